@@ -24,6 +24,9 @@ IF NOT DEFINED VCPKG_ROOT (
 :: Install nlohmann-json using Vcpkg
 "%VCPKG_ROOT%\vcpkg.exe" install nlohmann-json:x64-windows
 
+:: Install zlib using Vcpkg
+"%VCPKG_ROOT%\vcpkg.exe" install zlib:x64-windows
+
 :: Using MSBuild may require elevation
 "%VCPKG_ROOT%\vcpkg.exe" integrate install
 
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+struct BumpDetectorParameters
+{
+	// Activation a sample must exceed to belong to a bump.
+	double threshold;
+	// Peak activation at which a bump becomes a decision, and below which a decision is withdrawn.
+	// The defaults take a decision on any supra-threshold activation, as the centroid rule did;
+	// a higher onset waits for the bump to grow and commits later.
+	double onsetAmplitude;
+	double releaseAmplitude;
+	// Field positions of objects 1-3; a decision is the object nearest to the bump.
+	std::array<double, 3> objectPositions;
+
+	BumpDetectorParameters(double threshold = 0.0, double onsetAmplitude = 0.0, double releaseAmplitude = 0.0,
+		const std::array<double, 3>& objectPositions = { 37.5, 25.0, 12.5 })
+		: threshold(threshold), onsetAmplitude(onsetAmplitude), releaseAmplitude(releaseAmplitude),
+		objectPositions(objectPositions)
+	{}
+};
+
+// The strongest supra-threshold region of a field after a step.
+struct Bump
+{
+	bool present = false;
+	double position = -1;	// centre of mass of the activation above threshold, in field units
+	double amplitude = 0;	// peak activation
+	double width = 0;		// extent above threshold, in field units
+	double growth = 0;		// change of the peak activation since the previous step
+	double drift = 0;		// change of the position since the previous step
+};
+
+enum class DecisionEventType
+{
+	ONSET,		// a bump grew past the onset amplitude
+	CHANGE,		// the bump moved closer to another object
+	RELEASE,	// the bump decayed below the release amplitude
+};
+
+struct DecisionEvent
+{
+	using Clock = std::chrono::steady_clock;
+
+	DecisionEventType type;
+	int object;			// decision after the event, 0 after a release
+	int previousObject;
+	uint64_t step;
+	Clock::time_point time;	// end of the step that produced it
+	uint64_t inputFrame = 0;	// input frame the step ran with, set by the owner of the detector
+	Bump bump;
+};
+
+// Follows the bump of one field step by step. update() makes a single pass over the
+// activation: it keeps the running sums of the current supra-threshold region and the
+// strongest region seen so far, so it costs O(field size) with no allocation and can run
+// inside the simulation loop right after each step.
+class BumpDetector
+{
+private:
+	BumpDetectorParameters parameters;
+	bool circular;
+	double fieldLength;
+	Bump bump;
+	int decision;
+public:
+	explicit BumpDetector(const BumpDetectorParameters& parameters = {}, bool circular = false, double fieldLength = 50.0);
+
+	// Returns true and fills event when the decision changed with this step.
+	template <typename T>
+	bool update(const T* activation, int size, double dx, uint64_t step, DecisionEvent& event);
+
+	const Bump& getBump() const { return bump; }
+	int getDecision() const { return decision; }
+	void reset();
+private:
+	int nearestObject(double position) const;
+};
+
+// Fixed-capacity queue handing decision events from the simulation thread to the bridge.
+// When the bridge falls behind, the oldest events are dropped.
+class DecisionEventQueue
+{
+	static constexpr size_t capacity = 32;
+private:
+	mutable std::mutex mutex;
+	std::array<DecisionEvent, capacity> events;
+	size_t head = 0;
+	size_t count = 0;
+	uint64_t pushed = 0;
+public:
+	void push(const DecisionEvent& event);
+	bool pop(DecisionEvent& event);
+	// Number of events pushed so far; changes whenever a new event arrives.
+	uint64_t getPushedCount() const;
+};
+
+const char* toString(DecisionEventType type);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include "coppeliasim_transport.h"
+#include "metrics.h"
+
+struct ConnectionParameters
+{
+	// Delay after the first failed attempt; doubled after every further failure.
+	std::chrono::milliseconds initialBackoff;
+	std::chrono::milliseconds maxBackoff;
+	// Each delay is scaled by a random factor in [1 - jitter, 1 + jitter] so that the
+	// clients do not retry in lockstep.
+	double jitter;
+
+	ConnectionParameters(std::chrono::milliseconds initialBackoff = std::chrono::milliseconds(100),
+		std::chrono::milliseconds maxBackoff = std::chrono::milliseconds(5000),
+		double jitter = 0.2)
+		: initialBackoff(initialBackoff), maxBackoff(maxBackoff), jitter(jitter)
+	{}
+};
+
+enum class ConnectionState
+{
+	DISCONNECTED,
+	CONNECTING,
+	CONNECTED,
+};
+
+// Brings the simulator clients up and tracks their state by name.
+// Failed attempts are retried with exponential backoff and jitter; the waits sleep on a
+// condition variable, so stop() interrupts them and nothing spins while the simulator is down.
+class ConnectionManager
+{
+	using Clock = std::chrono::steady_clock;
+private:
+	ConnectionParameters parameters;
+	mutable std::mutex mutex;
+	std::condition_variable stateChanged;
+	std::map<std::string, ConnectionState> states;
+	bool stopRequested;
+	std::minstd_rand generator;
+	Counter& attempts;
+	Counter& drops;
+public:
+	ConnectionManager(const ConnectionParameters& parameters = {});
+
+	// Blocks until transport.initialize() succeeds (true) or stop() is called (false).
+	bool connect(CoppeliasimTransport& transport, const std::string& name);
+	// Records that a previously connected client lost its peer.
+	void markDisconnected(const std::string& name);
+	// Blocks until the named client is connected (true), stop() is called or the timeout expires (false).
+	bool waitUntilConnected(const std::string& name);
+	bool waitUntilConnected(const std::string& name, std::chrono::milliseconds timeout);
+
+	void stop();
+	bool isStopRequested() const;
+	ConnectionState getState(const std::string& name) const;
+private:
+	void setState(const std::string& name, ConnectionState state);
+	std::chrono::milliseconds nextDelay(std::chrono::milliseconds backoff);
+};
+
+const char* toString(ConnectionState state);
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <thread>
-#include <client.h>
+#include <memory>
 
 #include "misc.h"
+#include "coppeliasim_transport.h"
+#include "connection_manager.h"
+#include "io_scheduler.h"
+#include "signal_publisher.h"
+#include "metrics.h"
+#include "thread_layout.h"
 
 
 struct HumanHand
@@ -85,49 +94,63 @@ struct IncomingSignals
 	{}
 };
 
-struct OutgoingSignals
-{
-	static constexpr const char* START_SIM = "startSim";
-	static constexpr const char* TARGET_OBJECT = "targetObject";
-
-	bool startSim;
-	int targetObject;
-
-	OutgoingSignals()
-		: startSim(false)
-		, targetObject(0)
-	{}
-};
-
 class CoppeliasimHandler
 {
 private:
-	coppeliasim_cpp::CoppeliaSimClient incomingSignalsClient;
-	coppeliasim_cpp::CoppeliaSimClient outgoingSignalsClient;
-	coppeliasim_cpp::CoppeliaSimClient handClient;
-	std::thread incomingSignalsThread;
-	std::thread outgoingSignalsThread;
-	std::thread handThread;
-	IncomingSignals incomingSignals;
-	OutgoingSignals outgoingSignals;
-	HumanHand hand;
+	std::unique_ptr<CoppeliasimTransport> client;
+	std::thread ioThread;
+	// Written by the I/O thread, read by the experiment thread.
+	mutable std::mutex stateMutex;
+	IncomingSignals incomingSignals;	// guarded by stateMutex
+	SignalPublisher publisher;
+	ConnectionManager connections;
+	IoScheduler scheduler;
+	int poseTask;
+	int publishTask;
+	// Makes the pose read due whenever the peer rings the transport's doorbell, if it has one.
+	std::thread doorbellThread;
+	std::atomic<bool> doorbellStopRequested;
+	HumanHand hand;						// pose guarded by stateMutex
+	uint64_t poseCount;					// guarded by stateMutex
+	std::function<void()> updateListener;
+	std::atomic<uint64_t> updateCount;
+	Histogram& signalReadTime;
+	Histogram& poseReadTime;
 public:
-	CoppeliasimHandler();
+	CoppeliasimHandler(const TransportParameters& transport = {},
+		const SignalPublisherParameters& publisherParameters = {},
+		const ConnectionParameters& connectionParameters = {},
+		const IoSchedulerParameters& ioParameters = {});
+	// Uses the given transport instead of creating one, e.g. a stand-in for the simulator.
+	CoppeliasimHandler(std::unique_ptr<CoppeliasimTransport> transport,
+		const SignalPublisherParameters& publisherParameters = {},
+		const ConnectionParameters& connectionParameters = {},
+		const IoSchedulerParameters& ioParameters = {});
 	~CoppeliasimHandler();
 
 	void init();
 	void setSignals(const OutgoingSignals& signals);
 	IncomingSignals getSignals() const;
 	Pose getHandPose() const;
+	// Also returns the number of poses read so far, which tells a new sample from a repeated one.
+	Pose getHandPose(uint64_t& poseNumber) const;
 	void end();
 
 	bool isConnected() const;
+	// Blocks until the simulator is (re)connected; false once end() was called.
+	bool waitUntilConnected();
+	bool waitUntilConnected(std::chrono::milliseconds timeout);
+	// Called on the I/O thread after every pose or signal read and every connection change.
+	// Must be set before init().
+	void setUpdateListener(std::function<void()> listener);
+	uint64_t getUpdateCount() const;
 	void resetSignals() const;
 private:
-	void incomingSignalsLoop();
-	void outgoingSignalsLoop();
+	void ioLoop();
+	void waitForPeerUpdates(const std::atomic<uint32_t>& doorbell);
 	void readHandPosition();
 	void readSignals();
-	void writeSignals() const;
+	void notifyUpdate();
+	int readSignal(const std::string& name) const;
 	void printSignals() const;
 };
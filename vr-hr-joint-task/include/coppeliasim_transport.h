@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <client.h>
+
+#include "misc.h"
+#include "shared_memory.h"
+#include "shared_signal_region.h"
+
+enum class TransportType
+{
+	SOCKET,
+	SHARED_MEMORY,
+	REPLAY,			// serves a capture recorded with recordTraffic (see traffic_capture.h)
+};
+
+struct TransportParameters
+{
+	TransportType type;
+	std::string host;
+	std::string sharedMemoryName;
+	// Captures every remote call to traffic.bin in the session directory.
+	bool recordTraffic;
+	// Capture served by REPLAY, and its timing: 1 is the original pace, 0 as fast as possible.
+	std::string replayFile;
+	double replaySpeed;
+
+	TransportParameters(TransportType type = TransportType::SOCKET,
+		std::string host = "127.0.0.1",
+		std::string sharedMemoryName = "hr-vr-joint-task",
+		bool recordTraffic = false,
+		std::string replayFile = {},
+		double replaySpeed = 1.0)
+		: type(type), host(std::move(host)), sharedMemoryName(std::move(sharedMemoryName)),
+		recordTraffic(recordTraffic), replayFile(std::move(replayFile)), replaySpeed(replaySpeed)
+	{}
+};
+
+// The remote calls CoppeliasimHandler makes against the scene.
+class CoppeliasimTransport
+{
+public:
+	virtual ~CoppeliasimTransport() = default;
+
+	virtual bool initialize() = 0;
+	virtual bool isConnected() const = 0;
+	virtual void startSimulation() const = 0;
+	virtual void stopSimulation() const = 0;
+	virtual int getIntegerSignal(const std::string& name) const = 0;
+	virtual void setIntegerSignal(const std::string& name, int value) const = 0;
+	virtual int getObjectHandle(const std::string& name) const = 0;
+	virtual Pose getObjectPose(int handle) const = 0;
+	// Word the peer increments after every update, for waitForDoorbell; nullptr if it has none.
+	// Valid once initialize() succeeded.
+	virtual const std::atomic<uint32_t>* getUpdateDoorbell() const { return nullptr; }
+};
+
+// Legacy remote API client over a localhost TCP socket (the default).
+class SocketTransport : public CoppeliasimTransport
+{
+private:
+	coppeliasim_cpp::CoppeliaSimClient client;
+public:
+	SocketTransport(const std::string& host, int port);
+
+	bool initialize() override;
+	bool isConnected() const override;
+	void startSimulation() const override;
+	void stopSimulation() const override;
+	int getIntegerSignal(const std::string& name) const override;
+	void setIntegerSignal(const std::string& name, int value) const override;
+	int getObjectHandle(const std::string& name) const override;
+	Pose getObjectPose(int handle) const override;
+};
+
+// Lock-free shared-memory region, for a peer on the same host. It is polled by the I/O
+// thread like the socket, and its doorbell makes the pose read due as soon as the peer rings.
+// Object handles are indices into the region's object table.
+class SharedMemoryTransport : public CoppeliasimTransport
+{
+private:
+	std::string name;
+	SharedMemory memory;
+	SharedSignalRegion* region;
+	mutable std::unordered_map<std::string, SharedSignalRegion::SignalSlot*> signalSlots;
+public:
+	explicit SharedMemoryTransport(std::string name);
+
+	bool initialize() override;
+	bool isConnected() const override;
+	void startSimulation() const override;
+	void stopSimulation() const override;
+	int getIntegerSignal(const std::string& name) const override;
+	void setIntegerSignal(const std::string& name, int value) const override;
+	int getObjectHandle(const std::string& name) const override;
+	Pose getObjectPose(int handle) const override;
+	const std::atomic<uint32_t>* getUpdateDoorbell() const override;
+private:
+	SharedSignalRegion::SignalSlot* findSignal(const std::string& name) const;
+};
+
+std::unique_ptr<CoppeliasimTransport> createCoppeliasimTransport(const TransportParameters& parameters, int port);
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Lazily started coroutine returning nothing. Awaiting a Coroutine runs it to completion
+// and resumes the awaiting coroutine right after, on the same thread.
+class Coroutine
+{
+public:
+	struct promise_type
+	{
+		std::coroutine_handle<> continuation;
+		std::exception_ptr exception;
+
+		Coroutine get_return_object() { return Coroutine(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		auto final_suspend() noexcept
+		{
+			struct FinalAwaiter
+			{
+				bool await_ready() noexcept { return false; }
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+				{
+					const auto continuation = handle.promise().continuation;
+					return continuation ? continuation : std::noop_coroutine();
+				}
+				void await_resume() noexcept {}
+			};
+			return FinalAwaiter{};
+		}
+		void return_void() {}
+		void unhandled_exception() { exception = std::current_exception(); }
+	};
+private:
+	std::coroutine_handle<promise_type> handle;
+public:
+	explicit Coroutine(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+	Coroutine(Coroutine&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+	Coroutine& operator=(Coroutine&& other) noexcept;
+	Coroutine(const Coroutine&) = delete;
+	Coroutine& operator=(const Coroutine&) = delete;
+	~Coroutine();
+
+	bool isDone() const { return !handle || handle.done(); }
+	std::coroutine_handle<> getHandle() const { return handle; }
+	// Rethrows the exception the coroutine ended with, if any.
+	void rethrow() const;
+
+	auto operator co_await() const noexcept
+	{
+		struct Awaiter
+		{
+			std::coroutine_handle<promise_type> handle;
+
+			bool await_ready() const noexcept { return !handle || handle.done(); }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+			{
+				handle.promise().continuation = awaiting;
+				return handle;
+			}
+			void await_resume() const
+			{
+				if (handle.promise().exception)
+					std::rethrow_exception(handle.promise().exception);
+			}
+		};
+		return Awaiter{ handle };
+	}
+};
+
+class AsyncCondition;
+
+// Runs coroutines on the thread that calls run(). Other threads hand work over with post().
+class Executor
+{
+private:
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::vector<std::coroutine_handle<>> ready;
+	std::vector<std::coroutine_handle<>> running;
+	std::vector<AsyncCondition*> notified;
+	std::vector<AsyncCondition*> checking;
+	std::vector<Coroutine> tasks;
+public:
+	// Adds a top-level coroutine; it starts on the next run().
+	void spawn(Coroutine task);
+	// Queues a suspended coroutine to be resumed on the executor thread; callable from any thread.
+	void post(std::coroutine_handle<> handle);
+	// Queues a condition to have its predicates evaluated on the executor thread; callable from any thread.
+	void post(AsyncCondition& condition);
+	// Resumes queued coroutines until every spawned task has finished, then rethrows the
+	// first exception a task ended with.
+	void run();
+private:
+	bool areTasksDone();
+};
+
+// A condition coroutines can wait for. Whoever changes the state the predicates read
+// calls notify(); the executor then evaluates the predicates on its own thread and resumes
+// the waiters whose predicate holds. Waiters are only touched on the executor thread.
+class AsyncCondition
+{
+	friend class Executor;
+
+	struct Waiter
+	{
+		std::function<bool()> predicate;
+		std::coroutine_handle<> handle;
+	};
+private:
+	Executor& executor;
+	std::vector<Waiter> waiters;
+	std::atomic<bool> queued;
+public:
+	explicit AsyncCondition(Executor& executor) : executor(executor), queued(false) {}
+
+	// Wakes the executor; callable from any thread. Notifications coalesce until the check.
+	void notify();
+
+	auto until(std::function<bool()> predicate)
+	{
+		struct Awaiter
+		{
+			AsyncCondition& condition;
+			std::function<bool()> predicate;
+
+			bool await_ready() const { return predicate(); }
+			void await_suspend(std::coroutine_handle<> handle)
+			{
+				// On the executor thread, like every check, so a notify() cannot slip in between.
+				condition.waiters.push_back({ std::move(predicate), handle });
+			}
+			void await_resume() const noexcept {}
+		};
+		return Awaiter{ *this, std::move(predicate) };
+	}
+private:
+	void check();
+};
@@ -8,6 +8,73 @@ enum class DnfArchitectureType
 	ACTION_LIKELIHOOD,
 };
 
+enum class DnfElementType
+{
+	NEURAL_FIELD,
+	GAUSS_STIMULUS,
+	GAUSS_KERNEL,
+	LATERAL_INTERACTIONS,
+	NORMAL_NOISE,
+};
+
+// Numeric precision of the in-tree FieldEngine (see field_engine.h).
+// dnf-composer simulations always run in double.
+enum class FieldPrecision
+{
+	DOUBLE,		// double storage and arithmetic
+	FLOAT,		// float storage, float kernels and accumulation
+	MIXED,		// float storage, double accumulation
+};
+
+// One element of an architecture; only the parameters of its type are used.
+// Inputs are element names, in the order they are summed.
+struct DnfElementDescription
+{
+	DnfElementType type;
+	std::string name;
+	std::vector<std::string> inputs;
+	double tau = 0, restingLevel = 0, xShift = 0, steepness = 0;	// NEURAL_FIELD
+	double sigma = 0, amplitude = 0;								// stimuli, kernels (excitatory part), noise
+	double position = 0;											// GAUSS_STIMULUS
+	double sigmaInhibitory = 0, amplitudeInhibitory = 0, amplitudeGlobal = 0; // LATERAL_INTERACTIONS
+
+	static DnfElementDescription field(const std::string& name, double tau, double restingLevel,
+		double xShift, double steepness, const std::vector<std::string>& inputs);
+	static DnfElementDescription stimulus(const std::string& name, double sigma, double amplitude, double position);
+	static DnfElementDescription gaussKernel(const std::string& name, double sigma, double amplitude, const std::string& input);
+	static DnfElementDescription lateralInteractions(const std::string& name, double sigmaExcitatory, double amplitudeExcitatory,
+		double sigmaInhibitory, double amplitudeInhibitory, double amplitudeGlobal, const std::string& input);
+	static DnfElementDescription noise(const std::string& name, double amplitude);
+};
+
+// Element list of an architecture in stepping order, shared by the dnf-composer
+// simulation and the FieldEngine so both are built from the same parameters.
+struct DnfArchitectureDescription
+{
+	double xMax = 50;
+	double dx = 0.5;
+	bool circular = false;
+	FieldPrecision precision = FieldPrecision::DOUBLE;
+	std::vector<DnfElementDescription> elements;
+
+	int getSize() const { return static_cast<int>(xMax / dx); }
+	const DnfElementDescription* find(const std::string& name) const;
+};
+
+DnfArchitectureDescription getDnfArchitectureDescription(DnfArchitectureType type);
+
+const char* toString(DnfArchitectureType type);
+
+std::shared_ptr<dnf_composer::Simulation> createDnfComposerSimulation(const DnfArchitectureDescription& description,
+	const std::string& id, double deltaT);
+
+// One dnf-composer element of an architecture, without its inputs.
+std::shared_ptr<dnf_composer::element::Element> createDnfComposerElement(const DnfElementDescription& element,
+	const DnfArchitectureDescription& description);
+
 std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandMotion(const std::string& id, const double& deltaT);
 
-std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActionLikelihood(const std::string& id, const double& deltaT);
\ No newline at end of file
+std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActionLikelihood(const std::string& id, const double& deltaT);
+
+// Object (1-3) whose position is closest to the action execution centroid, 0 without a bump.
+int getTargetObjectFromCentroid(double centroid, double fieldLength);
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <application/application.h>
 #include <simulation/simulation.h>
@@ -9,36 +16,131 @@
 
 #include "dnf_architecture.h"
 #include "misc.h"
+#include "thread_layout.h"
+#include "metrics.h"
+#include "field_recorder.h"
+#include "field_readout.h"
+#include "event_logger.h"
+#include "field_snapshot.h"
+#include "parallel_stepper.h"
+#include "bump_detector.h"
+#include "input_staging.h"
+#include "parameter_watcher.h"
+#include "dnf_engine.h"
 
-class DnfComposerHandler
+struct SimulationLoopParameters
 {
+	// Fixed cadence of the simulation steps (0 = free running). The default matches
+	// the 60 Hz the steps ran at while they were tied to the rendered frames.
+	std::chrono::microseconds stepPeriod;
+	// Cadence at which the plot windows render the latest field snapshot.
+	double uiFrameRate;
+	// Threads that step independent elements of one step concurrently (1 = serial).
+	// Worthwhile once fields are much larger than the current 100 samples.
+	int stepWorkers;
+	// Without the plot windows there is no "ui" thread, and only end() stops the engine.
+	bool userInterface;
+
+	SimulationLoopParameters(std::chrono::microseconds stepPeriod = std::chrono::microseconds(16667),
+		double uiFrameRate = 30, int stepWorkers = 1, bool userInterface = true)
+		: stepPeriod(stepPeriod), uiFrameRate(uiFrameRate), stepWorkers(stepWorkers), userInterface(userInterface)
+	{}
+};
+
+class DnfComposerHandler : public DnfEngine
+{
+	// A changed kernel, built and sampled by the watcher as a new dnf-composer element.
+	// The simulation thread swaps it for the element it replaces, which the update then
+	// holds until the watcher frees it.
+	struct PreparedKernel
+	{
+		int index;	// into the architecture description, which is also the simulation's element order
+		std::shared_ptr<dnf_composer::element::Element> element;
+	};
+	using PreparedUpdate = std::vector<PreparedKernel>;
+
+	// The elements a kernel is connected to. Only kernels are ever replaced, so these stay valid.
+	struct KernelWiring
+	{
+		std::string name;
+		std::shared_ptr<dnf_composer::element::Element> source;
+		std::vector<std::shared_ptr<dnf_composer::element::Element>> consumers;
+	};
 private:
 	DnfArchitectureType dnf;
+	double deltaT;
+	FieldRecorderParameters recorderParameters;
+	BumpDetectorParameters decisionParameters;
+	FieldReadoutParameters readoutParameters;
+	// Built by the first init(); the plot windows are built by the UI thread.
 	std::shared_ptr<dnf_composer::Simulation> simulation;
+	std::shared_ptr<dnf_composer::Simulation> displaySimulation;
+	std::shared_ptr<FieldSnapshot> snapshot;
 	std::shared_ptr<dnf_composer::Application> application;
+	SimulationLoopParameters loopParameters;
 	std::thread simulationThread;
+	std::thread userInterfaceThread;
+	std::atomic<bool> stopRequested;
+	LoopMeter& simulationLoopMeter;
+	LoopMeter& userInterfaceLoopMeter;
+	Histogram& stepTime;
+	Histogram& inputAge;
+	Histogram& parameterApply;
+	std::unique_ptr<FieldRecorder> recorder;
+	std::unique_ptr<FieldPublisher> readout;
+	// Elements the bridge touches on every iteration, resolved once when the architecture is built.
+	std::shared_ptr<dnf_composer::element::NeuralField> actionExecutionField;
+	std::shared_ptr<dnf_composer::element::GaussStimulus> handStimulus;						// HAND_MOTION
+	std::array<std::shared_ptr<dnf_composer::element::GaussStimulus>, 3> handStimuli;		// ACTION_LIKELIHOOD
+	std::array<std::shared_ptr<dnf_composer::element::GaussStimulus>, 3> objectStimuli;
+	std::vector<KernelWiring> kernelWiring;	// by description index, kernels only
+	// Inputs are staged by the bridge and applied by the simulation thread before a step.
+	InputStaging inputs;
+	InputEncoder encoder;				// experiment thread
+	uint64_t appliedInputFrame;			// simulation thread
+	// Decisions are taken on the simulation thread after every step and handed to the bridge.
+	BumpDetector decisionDetector;
+	DecisionEventQueue decisionEvents;
+	std::atomic<int> targetObject;
+	std::function<void()> decisionListener;
+	// Parameter updates are staged by the watcher and applied by the simulation thread
+	// between two steps; the likelihood parameters are picked up by the bridge.
+	// An update staged before the architecture is built goes into the build instead.
+	std::mutex updateMutex;
+	DnfArchitectureDescription buildDescription;		// guarded by updateMutex
+	std::shared_ptr<PreparedUpdate> pendingUpdate;		// guarded by updateMutex
+	std::shared_ptr<PreparedUpdate> retiredUpdate;		// guarded by updateMutex, freed by the watcher
+	LikelihoodParameters stagedLikelihood;				// guarded by updateMutex
+	std::atomic<bool> updatePending;
+	std::atomic<bool> likelihoodPending;
 public:
-	DnfComposerHandler(DnfArchitectureType dnf, double deltaT);
-	~DnfComposerHandler();
-
-	void init();
-	void run() const;
-	void end();
-
-	void setHandStimulus(const Position& position, 
-		bool object1,
-		bool object2,
-		bool object3) const;
-	int getTargetObject() const;
-	void setAvailableObjectsInTheWorkspace(bool object1, bool object2, bool object3) const;
+	DnfComposerHandler(DnfArchitectureType dnf, double deltaT,
+		const FieldRecorderParameters& recorderParameters = {},
+		const SimulationLoopParameters& loopParameters = {},
+		const BumpDetectorParameters& decisionParameters = {},
+		const FieldReadoutParameters& readoutParameters = {});
+	~DnfComposerHandler() override;
+
+	void init() override;
+	void end() override;
+	bool isLost() const override;
+
+	uint64_t setInputs(const Position& handPosition, bool object1, bool object2, bool object3) override;
+	uint64_t setObjects(bool object1, bool object2, bool object3) override;
+	int getTargetObject() const override;
+	// The listener is called on the simulation thread.
+	void setDecisionListener(std::function<void()> listener) override;
+	bool pollDecisionEvent(DecisionEvent& event) override;
+	uint64_t getDecisionCount() const override;
+	void stageArchitectureUpdate(std::shared_ptr<const ArchitectureUpdate> update) override;
+	DnfArchitectureType getArchitectureType() const override { return dnf; }
+	const char* getEngineName() const override { return "dnf-composer"; }
 private:
-	void setHandStimulusDependingOnHumanActionLikelihood(const Position& position, 
-		bool object1, 
-		bool object2, 
-		bool object3) const;
-	void setHandStimulusDependingOnHumanHandPosition(const Position& position) const;
-	static double calculateHandDistanceToObjects(const Position& position);
-	static double calculateHandProximityToObjects(double distance);
-	static double normalizeHandPosition(double handPositionY);
-	void setupUserInterface() const;
+	void applyInputs();
+	void applyArchitectureUpdate();
+	void runSimulation();
+	void runUserInterface();
+	void build();
+	void setupUserInterface();
+	void resolveElements();
 };
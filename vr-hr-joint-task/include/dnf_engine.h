@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "dnf_architecture.h"
+#include "bump_detector.h"
+#include "misc.h"
+
+struct ArchitectureUpdate;
+
+enum class DnfEngineLocation
+{
+	IN_PROCESS,		// dnf-composer simulation and plot windows in the experiment process
+	OUT_OF_PROCESS,	// vr-hr-joint-task-dnf-engine, reached through shared memory (see remote_dnf_engine.h)
+};
+
+struct DnfEngineParameters
+{
+	DnfEngineLocation location;
+	std::string sharedMemoryName;
+	// A remote engine that has not advanced a step for this long is considered gone.
+	std::chrono::milliseconds heartbeatTimeout;
+
+	DnfEngineParameters(DnfEngineLocation location = DnfEngineLocation::IN_PROCESS,
+		std::string sharedMemoryName = "hr-vr-dnf-engine",
+		std::chrono::milliseconds heartbeatTimeout = std::chrono::milliseconds(1000))
+		: location(location), sharedMemoryName(std::move(sharedMemoryName)), heartbeatTimeout(heartbeatTimeout)
+	{}
+};
+
+// What the experiment needs from the DNF side, wherever the fields are stepped.
+class DnfEngine
+{
+public:
+	virtual ~DnfEngine() = default;
+
+	virtual void init() = 0;
+	// Stops the engine and joins its threads. dnf-composer's returns once its plot windows are closed.
+	virtual void end() = 0;
+	// True once the engine stopped on its own: its plot windows were closed, or the engine
+	// process exited or stopped stepping. The decision listener is called when it happens.
+	virtual bool isLost() const = 0;
+
+	// Stages the hand stimuli and object availability as one input frame; the engine applies
+	// it at the start of its next step. Returns the sequence number of the frame.
+	virtual uint64_t setInputs(const Position& handPosition, bool object1, bool object2, bool object3) = 0;
+	// Stages a frame with the last hand stimuli and new object availability, for signal
+	// updates without a new pose, so the hand's motion history stays as it is.
+	virtual uint64_t setObjects(bool object1, bool object2, bool object3) = 0;
+	// Latest decision of the action execution layer, 0 while there is none.
+	virtual int getTargetObject() const = 0;
+	// Called on an engine thread whenever a decision event is queued or the engine is lost. Set before init().
+	virtual void setDecisionListener(std::function<void()> listener) = 0;
+	virtual bool pollDecisionEvent(DecisionEvent& event) = 0;
+	virtual uint64_t getDecisionCount() const = 0;
+	// Hands a validated update over; the kernels change before the next step, all at once.
+	virtual void stageArchitectureUpdate(std::shared_ptr<const ArchitectureUpdate> update) = 0;
+
+	virtual DnfArchitectureType getArchitectureType() const = 0;
+	// Written to the decision log next to each decision ("dnf-composer", "remote").
+	virtual const char* getEngineName() const = 0;
+};
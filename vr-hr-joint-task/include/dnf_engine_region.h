@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "bump_detector.h"
+#include "input_staging.h"
+
+// Single-producer, single-consumer ring of trivially copyable records that can live in
+// shared memory: indices only grow, and slot i % N holds record i. The producer drops a
+// record when the ring is full instead of waiting for the consumer.
+template <typename T, size_t N>
+struct SharedRing
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Shared ring records are copied between processes.");
+	static_assert((N & (N - 1)) == 0, "The capacity of a shared ring is a power of two.");
+
+	std::atomic<uint64_t> head;		// records pushed, written by the producer
+	std::atomic<uint64_t> tail;		// records popped, written by the consumer
+	std::atomic<uint64_t> dropped;
+	T slots[N];
+
+	bool push(const T& record)
+	{
+		const uint64_t position = head.load(std::memory_order_relaxed);
+		if (position - tail.load(std::memory_order_acquire) >= N)
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		slots[position & (N - 1)] = record;
+		head.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& record)
+	{
+		const uint64_t position = tail.load(std::memory_order_relaxed);
+		if (position == head.load(std::memory_order_acquire))
+			return false;
+		record = slots[position & (N - 1)];
+		tail.store(position + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+// New parameters for one kernel of the engine's architecture, by element index.
+struct KernelUpdateRecord
+{
+	int32_t index;
+	double sigma, amplitude, sigmaInhibitory, amplitudeInhibitory, amplitudeGlobal;
+};
+
+// Layout of the shared-memory region between the experiment process and
+// vr-hr-joint-task-dnf-engine. Like SharedSignalRegion it holds no pointers and every
+// shared word is atomic; records are stamped with steady_clock, which both processes share.
+// The client writes input frames and kernel updates; the engine writes decision events,
+// the current target object and its step count, which doubles as a heartbeat.
+struct DnfEngineRegion
+{
+	static constexpr uint32_t MAGIC = 0x48524446; // "HRDF"
+	static constexpr uint32_t VERSION = 1;
+
+	std::atomic<uint32_t> magic;
+	std::atomic<uint32_t> version;
+	std::atomic<uint32_t> engineAttached;
+	std::atomic<uint32_t> clientAttached;
+	std::atomic<uint32_t> architecture;		// DnfArchitectureType of the engine
+	std::atomic<uint32_t> precision;		// FieldPrecision of the engine
+	std::atomic<uint64_t> step;
+	std::atomic<int32_t> targetObject;
+	std::atomic<uint32_t> stopRequested;	// set by the client to shut the engine down
+	// Rung by the engine after every decision event it queues.
+	std::atomic<uint32_t> decisionDoorbell;
+	SharedRing<InputFrame, 64> inputs;
+	SharedRing<DecisionEvent, 64> decisions;
+	SharedRing<KernelUpdateRecord, 32> kernels;
+
+	void initialize()
+	{
+		uint32_t expected = 0;
+		if (magic.compare_exchange_strong(expected, MAGIC))
+			version.store(VERSION);
+	}
+
+	bool isValid() const
+	{
+		return magic.load() == MAGIC && version.load() == VERSION;
+	}
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The engine region requires lock-free 64-bit counters.");
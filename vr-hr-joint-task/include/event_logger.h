@@ -2,6 +2,11 @@
 
 #include <fstream>
 #include <filesystem>
+#include <memory>
+#include <mutex>
+
+#include "misc.h"
+#include "session_storage.h"
 
 enum class LogLevel
 {
@@ -10,14 +15,34 @@ enum class LogLevel
     HUMAN,
 };
 
+// Boundaries recorded in the session index, so a trial can be read without the rest.
+enum class SessionMark
+{
+    TRIAL,
+    RESTART,
+};
+
 class EventLogger
 {
-    static std::ofstream logFile;
-    static std::ofstream humanHandPoseFile;
+    // logs.* and logs_human.* segments of the session, see session_storage.h.
+    static std::unique_ptr<SessionStorage> storage;
+    static int logStream;
+    static int humanHandPoseStream;
+    static int trialCount;
     static std::string sessionDirectory;
+    static std::mutex mutex;
 public:
     static void initialize();
+    // Creates the session directory under outputDirectory instead of the project's data directory.
+    static void initialize(const std::string& outputDirectory, const SessionStorageParameters& storageParameters = {});
     static void log(LogLevel level, const std::string& message);
-    static void logHumanHandPose(const std::string& message);
+    // Formats into a fixed buffer; does not allocate unless the message is long or the segment is full.
+    static void log(LogLevel level, const char* message);
+    // Called on every bridge iteration; formats into a fixed buffer and does not allocate
+    // unless the segment is full.
+    static void logHumanHandPose(const Pose& pose);
+    // Called by the bridge, which also writes the hand poses.
+    static void mark(SessionMark mark);
     static void finalize();
+    static std::string getSessionDirectory();
 };
@@ -2,84 +2,74 @@
 
 #include "dnf_architecture.h"
 #include "dnf_composer_handler.h"
+#include "remote_dnf_engine.h"
 #include "coppeliasim_handler.h"
 #include "event_logger.h"
+#include "thread_layout.h"
+#include "metrics.h"
+#include "coroutine_executor.h"
+#include "shadow_mode.h"
+#include "signal_bridge.h"
+#include "startup_profile.h"
 
 struct ExperimentParameters
 {
 	DnfArchitectureType dnf;
 	double deltaT;
+	std::string threadLayoutFile;
+	TransportParameters transport;
+	SignalPublisherParameters publisher;
+	ConnectionParameters connection;
+	IoSchedulerParameters io;
+	FieldRecorderParameters recorder;
+	FieldReadoutParameters readout;
+	SimulationLoopParameters simulationLoop;
+	BumpDetectorParameters decision;
+	DnfEngineParameters engine;
+	ParameterWatcherParameters architectureParameters;
+	// Secondary architectures stepped next to the primary on the same inputs (shadow mode).
+	std::vector<ShadowArchitecture> shadows;
+	SessionStorageParameters storage;
 
-	ExperimentParameters(DnfArchitectureType dnf, double deltaT)
-	: dnf(dnf), deltaT(deltaT)
+	ExperimentParameters(DnfArchitectureType dnf, double deltaT,
+		std::string threadLayoutFile = std::string(PROJECT_DIR) + "/resources/thread-layout.json")
+	: dnf(dnf), deltaT(deltaT), threadLayoutFile(std::move(threadLayoutFile))
 	{}
 };
 
-struct LogMsgs
-{
-    int lastTargetObject = -1;
-	bool prevSimStarted = false;
-    bool prevRobotGraspObj1 = false;
-    bool prevRobotGraspObj2 = false;
-    bool prevRobotGraspObj3 = false;
-    bool prevHumanGraspObj1 = false;
-    bool prevHumanGraspObj2 = false;
-    bool prevHumanGraspObj3 = false;
-    bool prevRobotPlaceObj1 = false;
-    bool prevRobotPlaceObj2 = false;
-    bool prevRobotPlaceObj3 = false;
-    bool prevHumanPlaceObj1 = false;
-    bool prevHumanPlaceObj2 = false;
-    bool prevHumanPlaceObj3 = false;
-
-    void clear()
-	{
-        lastTargetObject = -1;
-		prevSimStarted = false;
-        prevRobotGraspObj1 = false;
-        prevRobotGraspObj2 = false;
-        prevRobotGraspObj3 = false;
-        prevHumanGraspObj1 = false;
-        prevHumanGraspObj2 = false;
-        prevHumanGraspObj3 = false;
-        prevRobotPlaceObj1 = false;
-        prevRobotPlaceObj2 = false;
-        prevRobotPlaceObj3 = false;
-        prevHumanPlaceObj1 = false;
-        prevHumanPlaceObj2 = false;
-        prevHumanPlaceObj3 = false;
-    }
-};
-
 class Experiment
 {
 private:
-	DnfComposerHandler dnfComposerHandler;
+	std::unique_ptr<DnfEngine> dnfEngine;
 	CoppeliasimHandler coppeliasimHandler;
+	ParameterWatcher parameterWatcher;
+	std::vector<std::unique_ptr<ShadowRunner>> shadows;
+	DecisionLog decisionLog;
 	std::thread experimentThread;
-	IncomingSignals inSignals;
-	OutgoingSignals outSignals;
-	Pose handPose;
-	LogMsgs logMsgs;
+	Executor executor;
+	// Notified by the I/O thread after every update, by the engine after every decision event
+	// and when it is lost, and by end().
+	AsyncCondition updates;
+	std::atomic<bool> stopRequested;
+	bool ended;
+	SignalBridge bridge;
+	std::string threadLayoutFile;
+	SessionStorageParameters storageParameters;
 public:
 	Experiment(const ExperimentParameters& parameters);
 	~Experiment();
 
 	void init();
 	void run();
+	// Waits for the session to end, then tears it down; later calls do nothing.
 	void end();
 private:
-	void handleSignalsBetweenDnfAndCoppeliasim();
-
-	void waitForConnectionWithCoppeliasim();
-	void waitForSimulationToStart();
-
-	void sendHandPositionToDnf();
-	void sendAvailableObjectsToDnf() const;
-	void sendTargetObjectToRobot();
-	void interpretAndLogSystemState();
+	Coroutine runLifecycle();
+	Coroutine handleSignalsBetweenDnfAndCoppeliasim();
 
-	void keepAliveWhileTaskIsRunning() const;
-	bool areObjectsPresent() const;
-	bool areAllObjectsPresent() const;
+	Coroutine waitForConnectionWithCoppeliasim();
+	Coroutine waitForSimulationToStart();
+	Coroutine runTrial();
+	bool isSessionOver() const;
+	bool isSimulatorLost() const;
 };
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "dnf_architecture.h"
+#include "profile_cache.h"
+#include "bump_detector.h"
+
+// Precision policies of the FieldEngine. Storage is the type of every field, kernel and
+// stimulus array; Accumulator is the type convolutions and field inputs are summed in.
+struct DoublePrecision
+{
+	using Storage = double;
+	using Accumulator = double;
+	static constexpr FieldPrecision precision = FieldPrecision::DOUBLE;
+};
+
+struct SinglePrecision
+{
+	using Storage = float;
+	using Accumulator = float;
+	static constexpr FieldPrecision precision = FieldPrecision::FLOAT;
+};
+
+struct MixedPrecision
+{
+	using Storage = float;
+	using Accumulator = double;
+	static constexpr FieldPrecision precision = FieldPrecision::MIXED;
+};
+
+// Precision-independent view of a FieldEngine, for callers that choose the precision at run time.
+class FieldEngineBase
+{
+public:
+	virtual ~FieldEngineBase() = default;
+
+	virtual void init() = 0;
+	virtual void step() = 0;
+	// Index-based variant for hot loops; the index comes from indexOf().
+	virtual bool setStimulus(int index, double amplitude, double position) = 0;
+	bool setStimulus(const std::string& name, double amplitude, double position) { return setStimulus(indexOf(name), amplitude, position); }
+	// Replaces the parameters of a GAUSS_KERNEL or LATERAL_INTERACTIONS element between steps.
+	// The taps come from the ProfileCache, so a kernel prepared elsewhere is swapped in without
+	// being sampled again.
+	virtual bool setKernel(int index, const DnfElementDescription& kernel) = 0;
+	virtual double getCentroid(const std::string& field) const = 0;
+	// Runs a BumpDetector over the activation of a NEURAL_FIELD element, in the engine's own
+	// storage type; returns whether the detector reported a decision event.
+	virtual bool updateDetector(int index, BumpDetector& detector, uint64_t step, DecisionEvent& event) const = 0;
+	virtual std::vector<double> getComponent(const std::string& element, const std::string& component) const = 0;
+	virtual FieldPrecision getPrecision() const = 0;
+	virtual size_t getMemoryFootprint() const = 0;
+
+	int getTargetObject() const;
+	// Position of the element in the description, -1 if there is none of that name.
+	int indexOf(const std::string& name) const;
+	double getFieldLength() const { return description.xMax; }
+	const DnfArchitectureDescription& getDescription() const { return description; }
+protected:
+	DnfArchitectureDescription description;
+
+	explicit FieldEngineBase(const DnfArchitectureDescription& description) : description(description) {}
+};
+
+// Compact stepping engine for a DnfArchitectureDescription, used for parameter sweeps and
+// large fields where dnf-composer's double-only elements are the bottleneck.
+// Elements are stepped in description order with the same in-place semantics as
+// Simulation::step(). Kernels are applied as shifted multiply-adds over the whole field, so
+// the inner loop vectorises without reassociating sums; float storage doubles its SIMD width.
+// Noise is drawn in double from a seeded engine, so all precisions see the same noise.
+// Kernel taps and stimulus profiles are immutable handles from the ProfileCache, shared by
+// every engine built with the same parameters. A stimulus that is moved with setStimulus()
+// leaves the cache and is resampled in place into its own buffer, so tracking the hand does
+// not allocate.
+template <typename Precision>
+class FieldEngine : public FieldEngineBase
+{
+	using Storage = typename Precision::Storage;
+	using Accumulator = typename Precision::Accumulator;
+
+	struct Node
+	{
+		DnfElementType type;
+		std::vector<int> inputs;
+		std::vector<Storage> activation;	// NEURAL_FIELD only
+		std::vector<Storage> input;			// NEURAL_FIELD only
+		std::vector<Storage> output;		// GAUSS_STIMULUS only once it has been moved
+		ProfileHandle<Storage> profile;		// kernel taps or shared stimulus samples
+		int radius = 0;
+	};
+private:
+	double deltaT;
+	int size;
+	uint32_t seed;
+	std::vector<Node> nodes;
+	std::vector<Accumulator> accumulator;
+	std::vector<Storage> padded;			// convolution source with borders
+	std::mt19937_64 generator;
+	std::normal_distribution<double> normal;
+public:
+	FieldEngine(const DnfArchitectureDescription& description, double deltaT, uint32_t seed = 1);
+
+	void init() override;
+	void step() override;
+	using FieldEngineBase::setStimulus;
+	bool setStimulus(int index, double amplitude, double position) override;
+	bool setKernel(int index, const DnfElementDescription& kernel) override;
+	double getCentroid(const std::string& field) const override;
+	bool updateDetector(int index, BumpDetector& detector, uint64_t step, DecisionEvent& event) const override;
+	std::vector<double> getComponent(const std::string& element, const std::string& component) const override;
+	FieldPrecision getPrecision() const override { return Precision::precision; }
+	size_t getMemoryFootprint() const override;
+private:
+	const Storage* getOutput(int index) const;
+	void acquireStimulus(int index);
+	void convolve(const Storage* source, const Node& kernel);
+	void stepField(int index);
+};
+
+extern template class FieldEngine<DoublePrecision>;
+extern template class FieldEngine<SinglePrecision>;
+extern template class FieldEngine<MixedPrecision>;
+
+std::unique_ptr<FieldEngineBase> createFieldEngine(const DnfArchitectureDescription& description,
+	double deltaT, uint32_t seed = 1);
+
+const char* toString(FieldPrecision precision);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <simulation/simulation.h>
+
+#include "field_readout_region.h"
+#include "metrics.h"
+#include "shared_memory.h"
+
+struct FieldReadoutParameters
+{
+	bool enabled;
+	std::string sharedMemoryName;
+	// Published with their activation, input and output.
+	std::vector<std::string> fields;
+	int decimation;			// publish every n-th simulation step
+
+	FieldReadoutParameters(bool enabled = false, std::string sharedMemoryName = "hr-vr-fields",
+		std::vector<std::string> fields = { "aol", "asl", "orl", "ael" }, int decimation = 1)
+		: enabled(enabled), sharedMemoryName(std::move(sharedMemoryName)), fields(std::move(fields)),
+		decimation(decimation)
+	{}
+};
+
+// Simulation side of the field readout (see field_readout_region.h). publish() runs on the
+// simulation thread after each step; it copies the selected components into the next slot
+// and does not allocate, lock or wait for readers.
+class FieldPublisher
+{
+	struct Source
+	{
+		const std::vector<double>* component;
+		uint32_t offset;
+		uint32_t size;
+	};
+private:
+	FieldReadoutParameters parameters;
+	SharedMemory memory;
+	FieldReadoutRegion* region;
+	std::vector<Source> sources;
+	uint64_t stepCounter;
+	Histogram& publishTime;
+public:
+	explicit FieldPublisher(const FieldReadoutParameters& parameters);
+	~FieldPublisher();
+
+	// Maps the region and describes its columns. The components must outlive the publisher.
+	bool start(const std::shared_ptr<dnf_composer::Simulation>& simulation);
+	void stop();
+	void publish(uint64_t step, uint64_t inputFrame, int targetObject, const Bump& bump);
+};
+
+struct FieldColumn
+{
+	std::string element;
+	std::string component;
+	int offset;
+	int size;
+};
+
+// One publication as a reader sees it. samples points into the mapped slot: it is only
+// meaningful if FieldReader::validate() returns true after the samples have been used.
+struct FieldView
+{
+	const FieldReadoutRegion::Slot* slot = nullptr;
+	uint32_t sequence = 0;
+	uint64_t publication = 0;
+	uint64_t step = 0;
+	uint64_t inputFrame = 0;
+	std::chrono::steady_clock::time_point time;
+	int targetObject = 0;
+	Bump bump;
+	const double* samples = nullptr;
+
+	const double* column(const FieldColumn& column) const { return samples + column.offset; }
+};
+
+// Observer side. Readers never write to the region, so any number of them can attach and
+// detach while the experiment runs.
+class FieldReader
+{
+private:
+	SharedMemory memory;
+	const FieldReadoutRegion* region;
+	uint32_t layout;
+	std::vector<FieldColumn> columns;
+	size_t sampleCount;
+public:
+	FieldReader();
+
+	bool open(const std::string& sharedMemoryName = FieldReadoutParameters().sharedMemoryName);
+	bool isPublisherAttached() const;
+	// The columns of the current publisher; re-read after the publisher restarts.
+	const std::vector<FieldColumn>& getColumns();
+	int indexOf(const std::string& element, const std::string& component);
+
+	// Zero-copy read of the newest publication: false if there is none yet or the slot is
+	// being written; retry at once or on the next frame.
+	bool acquire(FieldView& view) const;
+	// True if the slot of view was not rewritten since acquire().
+	bool validate(const FieldView& view) const;
+	// Copies the newest publication and its samples, retrying until the copy is consistent.
+	bool read(FieldView& view, std::vector<double>& samples) const;
+private:
+	bool readLayout();
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "bump_detector.h"
+
+// Layout of the shared-memory region through which the simulation thread publishes
+// selected field components and its decision state to observers on the same host
+// (dashboards, recorders). Like the other regions it holds no pointers.
+//
+// The publisher writes publication n into slot n % SLOT_COUNT under that slot's seqlock:
+// the sequence is odd while the slot is written. latest is the newest complete
+// publication. A reader picks the slot of latest, reads it in place and then checks that
+// the sequence is still the even value it started with; with SLOT_COUNT slots, a slot is
+// only rewritten SLOT_COUNT - 1 publications later, so readers rarely have to retry and
+// never hold up the publisher. The column layout is guarded the same way by
+// layoutSequence and only changes when a publisher starts.
+struct FieldReadoutRegion
+{
+	static constexpr uint32_t MAGIC = 0x48524652; // "HRFR"
+	static constexpr uint32_t VERSION = 1;
+	static constexpr int MAX_COLUMNS = 16;
+	static constexpr int MAX_SAMPLES = 16384;	// per slot, over all columns
+	static constexpr int SLOT_COUNT = 4;
+	static constexpr int NAME_LENGTH = 32;
+
+	struct Column
+	{
+		char element[NAME_LENGTH];
+		char component[NAME_LENGTH];
+		uint32_t offset;	// first sample in Slot::samples
+		uint32_t size;
+	};
+
+	struct Slot
+	{
+		std::atomic<uint32_t> sequence;
+		uint64_t publication;
+		uint64_t step;
+		uint64_t inputFrame;
+		int64_t time;			// steady_clock nanoseconds at the end of the step
+		int32_t targetObject;
+		Bump bump;				// of the action execution layer
+		double samples[MAX_SAMPLES];
+	};
+
+	std::atomic<uint32_t> magic;
+	std::atomic<uint32_t> version;
+	std::atomic<uint32_t> publisherAttached;
+	std::atomic<uint32_t> layoutSequence;
+	uint32_t columnCount;
+	Column columns[MAX_COLUMNS];
+	std::atomic<uint64_t> latest;
+	Slot slots[SLOT_COUNT];
+
+	void initialize()
+	{
+		uint32_t expected = 0;
+		if (magic.compare_exchange_strong(expected, MAGIC))
+			version.store(VERSION);
+	}
+
+	bool isValid() const
+	{
+		return magic.load() == MAGIC && version.load() == VERSION;
+	}
+};
+
+static_assert(std::is_trivially_copyable_v<Bump>, "The decision state is copied into shared memory.");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The readout region requires lock-free 64-bit counters.");
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <simulation/simulation.h>
+
+#include "metrics.h"
+
+struct FieldRecorderParameters
+{
+	bool enabled;
+	std::vector<std::string> fields;
+	int decimation;			// record every n-th simulation step
+	int ticksPerChunk;
+	int compressionLevel;	// zlib level, 1 favours speed
+
+	FieldRecorderParameters(bool enabled = false,
+		std::vector<std::string> fields = { "aol", "asl", "orl", "ael" },
+		int decimation = 1,
+		int ticksPerChunk = 256,
+		int compressionLevel = 1)
+		: enabled(enabled), fields(std::move(fields)), decimation(decimation),
+		ticksPerChunk(ticksPerChunk), compressionLevel(compressionLevel)
+	{}
+};
+
+// Records the activation, input and output of selected fields into <session>/fields.bin.
+//
+// capture() runs on the simulation thread and only copies into preallocated chunk buffers;
+// a background thread compresses full chunks column by column and appends them.
+// If the writer falls behind, a chunk is dropped (and counted) rather than stalling the step.
+//
+// File layout (little endian):
+//   header: "HRVRFLD2", uint32 fieldCount, uint32 decimation, uint32 ticksPerChunk,
+//           per field: char[32] name, uint32 size
+//   chunk:  "CHNK", uint32 tickCount, then columns in order
+//           step (uint64[tickCount]), time (double[tickCount]), input frame (uint64[tickCount]),
+//           per field: activation, input, output (double[tickCount * size] each);
+//           each column is stored as uint32 rawBytes, uint32 compressedBytes, zlib data.
+class FieldRecorder
+{
+	static constexpr int COMPONENTS = 3;
+	static constexpr const char* COMPONENT_NAMES[COMPONENTS] = { "activation", "input", "output" };
+	static constexpr int CHUNK_POOL_SIZE = 4;
+
+	struct Chunk
+	{
+		std::vector<uint64_t> steps;
+		std::vector<double> times;
+		std::vector<uint64_t> inputFrames;
+		std::vector<std::vector<double>> columns;
+		int ticks = 0;
+	};
+private:
+	FieldRecorderParameters parameters;
+	std::vector<const std::vector<double>*> sources;	// field-major, COMPONENTS per field
+	std::vector<size_t> sizes;
+	std::vector<Chunk> pool;
+	Chunk* current;
+	std::queue<Chunk*> freeChunks;
+	std::queue<Chunk*> fullChunks;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	bool stopRequested;
+	std::thread writerThread;
+	std::ofstream file;
+	std::vector<unsigned char> compressed;
+	uint64_t stepCounter;
+	Counter& droppedChunks;
+	Histogram& captureTime;
+public:
+	FieldRecorder(const FieldRecorderParameters& parameters);
+	~FieldRecorder();
+
+	bool start(const std::shared_ptr<dnf_composer::Simulation>& simulation, const std::string& directory);
+	// inputFrame is the sequence number of the input frame the step ran with.
+	void capture(double time, uint64_t inputFrame);
+	void stop();
+private:
+	void submitCurrentChunk();
+	void writerLoop();
+	void writeChunk(const Chunk& chunk);
+	void writeColumn(const void* data, size_t bytes);
+};
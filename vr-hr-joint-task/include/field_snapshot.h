@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <elements/element.h>
+#include <simulation/simulation.h>
+
+// Triple buffer of selected field components.
+// The simulation thread publishes a complete copy after every step without ever waiting;
+// a reader (the UI) picks up the most recent complete copy at its own rate.
+class FieldSnapshot
+{
+	static constexpr uint8_t FRESH = 0x4;
+	static constexpr uint8_t INDEX = 0x3;
+
+	struct Slot
+	{
+		std::vector<std::vector<double>> columns;
+		uint64_t step = 0;
+	};
+private:
+	std::vector<std::pair<std::string, std::string>> keys;
+	std::vector<const std::vector<double>*> sources;
+	std::array<Slot, 3> slots;
+	std::atomic<uint8_t> middle;
+	uint8_t back;
+	uint8_t front;
+public:
+	FieldSnapshot();
+
+	// Registration happens before stepping starts.
+	int addSource(const std::shared_ptr<dnf_composer::Simulation>& simulation,
+		const std::string& element, const std::string& component);
+	int indexOf(const std::string& element, const std::string& component) const;
+
+	// Writer side (simulation thread).
+	void publish(uint64_t step);
+	// Reader side (UI thread). Returns true if a newer snapshot was taken.
+	bool acquire();
+	const std::vector<double>& get(int column) const { return slots[front].columns[column]; }
+	uint64_t getStep() const { return slots[front].step; }
+};
+
+// Display-only element that mirrors one field from a FieldSnapshot.
+// It lets the dnf-composer plot windows render a snapshot instead of the live field.
+class SnapshotElement : public dnf_composer::element::Element
+{
+private:
+	std::shared_ptr<FieldSnapshot> snapshot;
+	std::vector<std::pair<std::string, int>> mirroredComponents;
+public:
+	SnapshotElement(const dnf_composer::element::ElementCommonParameters& parameters,
+		std::shared_ptr<FieldSnapshot> snapshot);
+
+	void init() override;
+	void step(double t, double deltaT) override;
+	void printParameters() override;
+	std::shared_ptr<dnf_composer::element::Element> clone() const override;
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "dnf_architecture.h"
+#include "misc.h"
+
+// Amplitude and position of one Gaussian stimulus; its width stays as built.
+struct StimulusInput
+{
+	double amplitude = 0;
+	double position = 0;
+};
+
+// Everything the bridge feeds into the fields for one pose update.
+struct InputFrame
+{
+	using Clock = std::chrono::steady_clock;
+
+	uint64_t sequence = 0;				// 0 until the first frame is published
+	Clock::time_point published;
+	int handStimulusCount = 0;			// 1 for HAND_MOTION, 3 for ACTION_LIKELIHOOD
+	std::array<StimulusInput, 3> hand;
+	std::array<bool, 3> objectPresent{};
+};
+
+// Triple buffer of input frames, the writer-to-reader mirror of FieldSnapshot.
+// The bridge fills a complete frame and publishes it with one atomic exchange; the
+// simulation thread takes the most recent complete frame at the start of a step. Neither
+// side waits, and a step never sees half of one frame and half of another.
+class InputStaging
+{
+	static constexpr uint8_t FRESH = 0x4;
+	static constexpr uint8_t INDEX = 0x3;
+private:
+	std::array<InputFrame, 3> slots;
+	std::atomic<uint8_t> middle;
+	uint8_t back;
+	uint8_t front;
+	uint64_t sequence;
+public:
+	InputStaging();
+
+	// Writer side (experiment thread). Stamps the frame and returns its sequence number.
+	uint64_t publish(const InputFrame& frame);
+	// Reader side (simulation thread). Returns true if a newer frame was taken.
+	bool acquire();
+	const InputFrame& get() const { return slots[front]; }
+};
+
+// Turns a hand position and the object availability into the input frame of one
+// architecture: the hand proximity and lateral position for HAND_MOTION, the likelihood
+// of each action for ACTION_LIKELIHOOD. Stimulus positions start as the description has them.
+class InputEncoder
+{
+private:
+	DnfArchitectureType dnf;
+	LikelihoodParameters likelihood;
+	InputFrame frame;
+	std::array<double, 3> handLikelihood;	// ACTION_LIKELIHOOD amplitudes before the objects are masked
+	Position handPrevious;
+	InputFrame::Clock::time_point lastTime;
+	bool hasPrevious;
+public:
+	InputEncoder(DnfArchitectureType dnf, const DnfArchitectureDescription& description);
+
+	// Call once per new hand pose; the likelihoods come from the motion since the previous one.
+	const InputFrame& encode(const Position& handPosition, bool object1, bool object2, bool object3);
+	// The same for a pose taken at a given time, for replaying recorded poses.
+	const InputFrame& encode(const Position& handPosition, bool object1, bool object2, bool object3,
+		InputFrame::Clock::time_point time);
+	// The last hand inputs with new object availability, for an update without a new pose.
+	const InputFrame& encodeObjects(bool object1, bool object2, bool object3);
+	void setLikelihood(const LikelihoodParameters& parameters) { likelihood = parameters; }
+private:
+	void encodeHandMotion(const Position& position);
+	void encodeActionLikelihood(const Position& position, InputFrame::Clock::time_point time);
+};
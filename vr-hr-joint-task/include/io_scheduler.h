@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+
+struct IoSchedulerParameters
+{
+	// Rates at which the hand pose and the incoming signals are polled, in Hz.
+	double poseRate;
+	double signalRate;
+
+	IoSchedulerParameters(double poseRate = 90.0, double signalRate = 30.0)
+		: poseRate(poseRate), signalRate(signalRate)
+	{}
+};
+
+// Runs all remote calls of the simulator connection on one thread.
+// Each task says when it wants to run next; whenever several are due, the one with the
+// lowest priority value goes first. Between tasks the thread sleeps until the earliest due
+// time or until trigger() makes a task due immediately.
+class IoScheduler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	// Receives the time the task was due and returns the time it should run next.
+	using TaskFunction = std::function<Clock::time_point(Clock::time_point due)>;
+private:
+	struct Task
+	{
+		std::string name;
+		int priority;
+		TaskFunction function;
+		Clock::time_point due;
+		bool triggered;
+		LoopMeter* meter;
+	};
+
+	std::vector<Task> tasks;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	bool stopRequested;
+public:
+	IoScheduler();
+
+	// Must be called before run(). Returns the task id used by trigger().
+	int add(const std::string& name, int priority, TaskFunction function);
+	int addPeriodic(const std::string& name, int priority, double rate, std::function<void()> function);
+
+	// Runs the tasks until stop() is called or keepRunning returns false.
+	void run(const std::function<bool()>& keepRunning);
+	// Makes the task due now; callable from any thread.
+	void trigger(int task);
+	void stop();
+private:
+	int findNextTask(Clock::time_point now) const;
+	Clock::time_point getEarliestDue() const;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Lock-free instruments for the running system. Every record is one or two relaxed
+// atomic operations on memory owned by the instrument; registration, which allocates,
+// happens once at construction time of the owning component.
+
+class Counter
+{
+	std::atomic<uint64_t> value{ 0 };
+public:
+	void increment(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+	uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+class Gauge
+{
+	std::atomic<int64_t> value{ 0 };
+public:
+	void set(int64_t v) { value.store(v, std::memory_order_relaxed); }
+	void add(int64_t n) { value.fetch_add(n, std::memory_order_relaxed); }
+	int64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+struct HistogramSnapshot
+{
+	uint64_t count = 0;
+	double mean = 0;
+	double p50 = 0;
+	double p90 = 0;
+	double p99 = 0;
+	double max = 0;
+};
+
+// Latency histogram in nanoseconds with four sub-buckets per power of two
+// (relative error below 25%). Single writer: each histogram is recorded by the thread
+// that owns it (or under its owner's lock), so a sample is a plain relaxed load/store
+// without a locked read-modify-write; snapshots may be read from any thread.
+class Histogram
+{
+	static constexpr int BUCKETS = 256;
+	std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+	std::atomic<uint64_t> sum{ 0 };
+	std::atomic<uint64_t> maximum{ 0 };
+public:
+	void record(uint64_t nanoseconds);
+	void record(std::chrono::nanoseconds duration) { record(static_cast<uint64_t>(duration.count())); }
+	HistogramSnapshot snapshot() const;
+private:
+	static int bucketOf(uint64_t nanoseconds);
+	static uint64_t upperBoundOf(int bucket);
+};
+
+// Per-loop meter: iterations, period and period jitter (change of period between iterations).
+// tick() must only be called from the thread that owns the loop.
+class LoopMeter
+{
+	Counter iterations;
+	Histogram period;
+	Histogram jitter;
+	int64_t lastTick = 0;
+	int64_t lastPeriod = 0;
+public:
+	void tick();
+	uint64_t getIterations() const { return iterations.get(); }
+	HistogramSnapshot periodSnapshot() const { return period.snapshot(); }
+	HistogramSnapshot jitterSnapshot() const { return jitter.snapshot(); }
+};
+
+class ScopedTimer
+{
+	Histogram& histogram;
+	std::chrono::steady_clock::time_point start;
+public:
+	explicit ScopedTimer(Histogram& histogram)
+		: histogram(histogram), start(std::chrono::steady_clock::now())
+	{}
+	~ScopedTimer() { histogram.record(std::chrono::steady_clock::now() - start); }
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+// Process-wide registry. Instruments live until exit, so the returned references stay valid.
+// A background thread periodically rewrites <directory>/stats.txt with a snapshot.
+class Metrics
+{
+	static std::map<std::string, std::unique_ptr<Counter>> counters;
+	static std::map<std::string, std::unique_ptr<Gauge>> gauges;
+	static std::map<std::string, std::unique_ptr<Histogram>> histograms;
+	static std::map<std::string, std::unique_ptr<LoopMeter>> loops;
+	static std::mutex mutex;
+	static std::thread exporterThread;
+	static std::condition_variable exporterWakeUp;
+	static bool exporterRunning;
+public:
+	static Counter& counter(const std::string& name);
+	static Gauge& gauge(const std::string& name);
+	static Histogram& histogram(const std::string& name);
+	static LoopMeter& loop(const std::string& name);
+
+	static void startExporter(const std::string& directory,
+		std::chrono::milliseconds period = std::chrono::milliseconds(1000));
+	static void stopExporter();
+	static std::string format(double elapsedSeconds,
+		std::map<std::string, uint64_t>& previousIterations);
+private:
+	static void exporterLoop(std::string directory, std::chrono::milliseconds period);
+};
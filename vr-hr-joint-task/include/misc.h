@@ -3,6 +3,7 @@
 #include <cmath>
 #include <numbers>
 #include <chrono>
+#include <array>
 
 struct Position
 {
@@ -39,4 +40,30 @@ double calculateEuclideanDistance(const Position& a, const Position& b);
 
 double calculateVelocity(const Position& a, const Position& b, double time);
 
-double calculateLikelihoodOfHumanAction(const Position& handPos, const Position& handPosPrev, const Position& componentPos, double deltaTime, double tau, double sigma);
\ No newline at end of file
+double calculateLikelihoodOfHumanAction(const Position& handPos, const Position& handPosPrev, const Position& componentPos, double deltaTime, double tau, double sigma);
+
+// Shape of the action likelihood (see calculateLikelihoodOfHumanAction) and the gain
+// from likelihood to hand stimulus amplitude.
+struct LikelihoodParameters
+{
+	double tau;
+	double sigma;
+	double scalar;
+
+	LikelihoodParameters(double tau = 0.1, double sigma = 0.05, double scalar = 5)
+		: tau(tau), sigma(sigma), scalar(scalar)
+	{}
+};
+
+// Positions of the three objects on the table, object 1 first.
+const std::array<Position, 3>& getTableObjectPositions();
+
+// Likelihood of reaching for each of the three objects on the table, object 1 first.
+std::array<double, 3> calculateLikelihoodOfHumanActions(const Position& handPos, const Position& handPosPrev, double deltaTime,
+	const LikelihoodParameters& parameters = {});
+
+double calculateHandDistanceToObjects(const Position& position);
+
+double calculateHandProximityToObjects(double distance);
+
+double normalizeHandPosition(double handPositionY);
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <elements/element.h>
+#include <simulation/simulation.h>
+
+// Order constraints between the elements of one simulation step.
+// Simulation::step() updates the elements in insertion order and in place, so an element that
+// reads an earlier element sees its new output, and one that reads a later element sees the
+// previous output. Both directions become an edge from the lower to the higher index;
+// elements that share no edge can be stepped concurrently without changing any result.
+class StepGraph
+{
+private:
+	std::vector<std::string> names;
+	std::vector<std::vector<int>> dependencies;	// lower-index elements each element waits for
+	std::vector<int> levels;					// longest dependency chain ending at each element
+	int levelCount;
+public:
+	explicit StepGraph(const std::shared_ptr<dnf_composer::Simulation>& simulation);
+
+	int getElementCount() const { return static_cast<int>(levels.size()); }
+	int getLevel(int element) const { return levels[element]; }
+	int getLevelCount() const { return levelCount; }
+	const std::vector<int>& getDependencies(int element) const { return dependencies[element]; }
+	std::string toString() const;
+};
+
+// Sense-reversing barrier for the few threads of a ParallelStepper.
+// Waiters spin, as the whole wait is a fraction of one step.
+class SpinBarrier
+{
+private:
+	const uint32_t participants;
+	std::atomic<uint32_t> arrived;
+	std::atomic<uint32_t> phase;
+public:
+	explicit SpinBarrier(uint32_t participants);
+	void arriveAndWait();
+};
+
+// Steps a simulation level by level of its StepGraph on a small worker pool.
+// The calling thread is worker 0; the others are named "stepWorker1", "stepWorker2", ...
+// for the thread layout. Results are identical to Simulation::step().
+class ParallelStepper
+{
+private:
+	std::shared_ptr<dnf_composer::Simulation> simulation;
+	StepGraph graph;
+	int workerCount;
+	std::vector<std::vector<std::vector<int>>> plan;	// [worker][level] -> elements
+	std::vector<std::thread> workers;
+	SpinBarrier barrier;
+	std::mutex mutex;
+	std::condition_variable stepRequested;
+	uint64_t generation;
+	bool stopping;
+	double t;
+	double deltaT;
+public:
+	ParallelStepper(const std::shared_ptr<dnf_composer::Simulation>& simulation, int workerCount);
+	~ParallelStepper();
+	ParallelStepper(const ParallelStepper&) = delete;
+	ParallelStepper& operator=(const ParallelStepper&) = delete;
+
+	// Call after Simulation::init(); takes over the simulation time from there.
+	void start();
+	void step();
+	void stop();
+
+	const StepGraph& getGraph() const { return graph; }
+	int getWorkerCount() const { return workerCount; }
+private:
+	void buildPlan();
+	void runWorker(int worker);
+	void runLevels(int worker);
+	static double estimateCost(const std::shared_ptr<dnf_composer::element::Element>& element);
+};
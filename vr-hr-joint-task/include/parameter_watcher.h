@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dnf_architecture.h"
+#include "misc.h"
+
+// A validated set of parameter changes, prepared off the stepping threads and applied
+// between two steps as a whole.
+struct ArchitectureUpdate
+{
+	uint64_t version = 0;
+	// The architecture with every change of this update applied.
+	DnfArchitectureDescription description;
+	// Indices into description.elements of the kernels that differ from the previous update.
+	std::vector<int> changedElements;
+	LikelihoodParameters likelihood;
+	bool likelihoodChanged = false;
+	// Kernel profiles of the changed elements in float and double, computed by the watcher.
+	// Holding them keeps them in the ProfileCache, so a FieldEngine that picks up the update
+	// finds its taps ready instead of sampling them between steps.
+	std::vector<std::shared_ptr<const void>> kernelProfiles;
+	// The file this update was parsed from, so an engine with another architecture can
+	// parse it against its own and take only what the file sets.
+	std::string source;
+
+	std::string toString() const;
+};
+
+struct ParameterWatcherParameters
+{
+	std::string file;
+	std::chrono::milliseconds pollPeriod;
+
+	ParameterWatcherParameters(std::string file = std::string(PROJECT_DIR) + "/resources/architecture-parameters.json",
+		std::chrono::milliseconds pollPeriod = std::chrono::milliseconds(500))
+		: file(std::move(file)), pollPeriod(pollPeriod)
+	{}
+};
+
+// Watches a parameter file while the experiment runs. On its own thread ("parameters") it
+// notices a new modification time, parses the file, validates it against the architecture
+// and prepares the kernel profiles; only a complete, valid update reaches the listener,
+// and a file that fails validation leaves the running parameters as they are.
+//
+// File format (every entry optional; values left out keep the built-in parameters):
+//   {
+//     "elements": {
+//       "<kernel name>": { "sigma", "amplitude" },
+//       "<lateral interactions name>": { "sigma", "amplitude", "sigmaInhibitory",
+//                                        "amplitudeInhibitory", "amplitudeGlobal" }
+//     },
+//     "likelihood": { "tau", "sigma", "scalar" }
+//   }
+class ParameterWatcher
+{
+	using Listener = std::function<void(std::shared_ptr<const ArchitectureUpdate>)>;
+private:
+	ParameterWatcherParameters parameters;
+	DnfArchitectureDescription base;
+	std::shared_ptr<const ArchitectureUpdate> current;
+	std::filesystem::file_time_type lastModified;
+	bool seen;
+	Listener listener;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	bool stopRequested;
+public:
+	ParameterWatcher(const ParameterWatcherParameters& parameters, const DnfArchitectureDescription& base);
+	~ParameterWatcher();
+
+	// Loads the file once, so the experiment starts with its parameters, then keeps watching it.
+	void start(Listener listener);
+	void stop();
+
+	// Builds the update a parameter file describes relative to the built-in architecture.
+	// Returns nullptr and sets error if the file is not valid; changes are relative to previous.
+	// With skipUnknownElements, entries naming elements that are not kernels of base are skipped.
+	static std::shared_ptr<ArchitectureUpdate> parse(const std::string& text, const DnfArchitectureDescription& base,
+		const ArchitectureUpdate& previous, std::string& error, bool skipUnknownElements = false);
+private:
+	void run();
+	void poll();
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dnf_architecture.h"
+
+// Immutable sampled profile, the taps of a kernel or the samples of a Gauss stimulus.
+template <typename T>
+using ProfileHandle = std::shared_ptr<const std::vector<T>>;
+
+// Process-wide, content-addressed store of kernel and stimulus profiles.
+// Every FieldEngine asking for the same parameters gets the same copy. The cache only holds
+// weak references, so a profile is released with its last user and stimuli that keep moving
+// do not accumulate.
+class ProfileCache
+{
+	struct Key
+	{
+		DnfElementType type;
+		int size;
+		int storageBytes;
+		std::array<double, 6> parameters;
+
+		bool operator==(const Key& other) const = default;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	struct Entry
+	{
+		std::weak_ptr<const void> profile;
+		size_t bytes;
+	};
+private:
+	static std::mutex mutex;
+	static std::unordered_map<Key, Entry, KeyHash> entries;
+	static size_t insertsSinceSweep;
+public:
+	// Kernel taps from -radius to radius, cut off at five widths of the broadest Gaussian.
+	template <typename T>
+	static ProfileHandle<T> kernel(const DnfElementDescription& element, double dx, int size);
+	template <typename T>
+	static ProfileHandle<T> stimulus(const DnfElementDescription& element, double dx, double xMax, int size, bool circular);
+	// Writes the samples of a stimulus into a caller-owned buffer of size elements, bypassing the cache.
+	template <typename T>
+	static void sampleStimulus(const DnfElementDescription& element, double dx, double xMax, int size, bool circular, T* samples);
+
+	static size_t getEntryCount();
+	static size_t getMemoryFootprint();
+private:
+	template <typename T, typename Compute>
+	static ProfileHandle<T> getOrCompute(const Key& key, Compute compute);
+};
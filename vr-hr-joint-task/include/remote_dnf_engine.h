@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dnf_engine.h"
+#include "dnf_engine_region.h"
+#include "field_engine.h"
+#include "input_staging.h"
+#include "metrics.h"
+#include "parameter_watcher.h"
+#include "shared_memory.h"
+
+// Experiment side of an out-of-process DNF engine. Inputs are encoded here, on the
+// experiment thread, and pushed to the engine as complete frames; decision events come back
+// through the region, and a thread of the client ("engineClient") waits on the engine's
+// doorbell to wake the bridge. The engine process is started separately; it is lost once it
+// exits or stops stepping, and end() asks it to stop.
+class RemoteDnfEngine : public DnfEngine
+{
+private:
+	DnfArchitectureType dnf;
+	DnfEngineParameters parameters;
+	SharedMemory memory;
+	DnfEngineRegion* region;
+	InputEncoder encoder;				// experiment thread
+	uint64_t sequence;					// experiment thread
+	std::function<void()> decisionListener;
+	std::thread listenerThread;
+	std::atomic<bool> stopRequested;
+	std::atomic<bool> engineLost;
+	std::mutex likelihoodMutex;
+	LikelihoodParameters stagedLikelihood;	// guarded by likelihoodMutex
+	std::atomic<bool> likelihoodPending;
+public:
+	RemoteDnfEngine(DnfArchitectureType dnf, const DnfEngineParameters& parameters);
+	~RemoteDnfEngine() override;
+
+	void init() override;
+	void end() override;
+	bool isLost() const override;
+
+	uint64_t setInputs(const Position& handPosition, bool object1, bool object2, bool object3) override;
+	uint64_t setObjects(bool object1, bool object2, bool object3) override;
+	int getTargetObject() const override;
+	// The listener is called on the engineClient thread.
+	void setDecisionListener(std::function<void()> listener) override;
+	bool pollDecisionEvent(DecisionEvent& event) override;
+	uint64_t getDecisionCount() const override;
+	// Kernel changes are forwarded to the engine, which swaps them in between two steps.
+	void stageArchitectureUpdate(std::shared_ptr<const ArchitectureUpdate> update) override;
+	DnfArchitectureType getArchitectureType() const override { return dnf; }
+	const char* getEngineName() const override { return "remote"; }
+private:
+	uint64_t publish(const InputFrame& encoded);
+	void listen();
+};
+
+struct DnfEngineServerParameters
+{
+	DnfArchitectureType architecture;
+	FieldPrecision precision;
+	double deltaT;
+	std::chrono::microseconds stepPeriod;
+	BumpDetectorParameters decision;
+	std::string sharedMemoryName;
+
+	DnfEngineServerParameters(DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION,
+		FieldPrecision precision = FieldPrecision::DOUBLE, double deltaT = 65,
+		std::chrono::microseconds stepPeriod = std::chrono::microseconds(16667),
+		const BumpDetectorParameters& decision = {},
+		std::string sharedMemoryName = DnfEngineParameters().sharedMemoryName)
+		: architecture(architecture), precision(precision), deltaT(deltaT), stepPeriod(stepPeriod),
+		decision(decision), sharedMemoryName(std::move(sharedMemoryName))
+	{}
+};
+
+// Engine side, run by vr-hr-joint-task-dnf-engine on its "engine" thread. Steps a
+// FieldEngine at a fixed period: before each step it applies pending kernel updates and the
+// newest input frame, after it runs the BumpDetector and queues any decision event. Kernel
+// updates are taken from the region and their taps sampled on the "engineKernels" thread,
+// so the engine thread only swaps them in and does not allocate.
+class DnfEngineServer
+{
+	struct PreparedKernel
+	{
+		int index;
+		DnfElementDescription kernel;
+		std::shared_ptr<const void> profile;	// keeps the taps in the ProfileCache until applied
+	};
+private:
+	DnfEngineServerParameters parameters;
+	SharedMemory memory;
+	DnfEngineRegion* region;
+	DnfArchitectureDescription description;	// engineKernels thread once running
+	std::unique_ptr<FieldEngineBase> engine;
+	BumpDetector detector;
+	InputFrame frame;
+	int actionExecutionField;
+	std::array<int, 3> handStimuli;
+	std::array<int, 3> objectStimuli;
+	std::array<double, 3> objectPositions;
+	uint64_t appliedInputFrame;
+	Histogram& stepTime;
+	Histogram& inputAge;
+	std::thread kernelThread;
+	std::atomic<bool> kernelThreadStop;
+	std::mutex kernelMutex;
+	std::vector<PreparedKernel> preparedKernels;	// guarded by kernelMutex
+	std::vector<PreparedKernel> appliedKernels;		// engine thread; handed back to be freed
+	std::atomic<bool> kernelsPending;
+public:
+	explicit DnfEngineServer(const DnfEngineServerParameters& parameters);
+	~DnfEngineServer();
+
+	bool open();
+	// Steps until the client requests a stop or stop becomes true.
+	void run(const std::atomic<bool>& stop);
+private:
+	void prepareKernelUpdates();
+	void applyKernelUpdates();
+	void applyInputs();
+};
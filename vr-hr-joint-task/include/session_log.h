@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "misc.h"
+
+// Parser for the session logs written by EventLogger (the logs and logs_human streams).
+// It works on views of memory-mapped files or decompressed segments and never copies a line.
+
+enum class SessionEventType
+{
+	SIMULATION_STARTED,
+	ROBOT_TARGET,
+	ROBOT_GRASP,
+	ROBOT_PLACE,
+	HUMAN_GRASP,
+	HUMAN_PLACE,
+	OTHER,
+};
+
+struct SessionEvent
+{
+	double time;		// seconds since 1970-01-01 in local time
+	SessionEventType type;
+	int object;
+};
+
+struct HandSample
+{
+	double time;
+	Pose pose;
+};
+
+struct TrialMetrics
+{
+	std::string session;
+	int trial = 0;
+	double startTime = 0;
+	double duration = 0;
+	int robotTargetChanges = 0;
+	int robotGrasps = 0;
+	int robotPlaces = 0;
+	int humanGrasps = 0;
+	int humanPlaces = 0;
+	double robotGraspToPlace = 0;	// mean seconds from a grasp to the next place
+	double humanGraspToPlace = 0;
+	int conflicts = 0;				// human grasps of the object the robot is targeting
+	double anticipationLead = 0;	// mean seconds the robot committed to another object before a human grasp
+	int anticipatedGrasps = 0;
+	size_t handSamples = 0;
+	double handPathLength = 0;		// metres
+};
+
+// Position in the uncompressed text of a stream: a segment and a byte offset into it.
+struct SessionPosition
+{
+	int segment = 0;
+	uint64_t offset = 0;
+};
+
+// Past the last byte of any stream.
+constexpr SessionPosition SESSION_END{ std::numeric_limits<int>::max(), 0 };
+
+struct SessionSegment
+{
+	std::string stream;
+	int segment = 0;
+	std::string file;
+	uint64_t bytes = 0;			// uncompressed
+	uint64_t storedBytes = 0;	// on disk
+	double firstTime = 0;		// of the first and last line, as in SessionEvent
+	double lastTime = 0;
+	bool removed = false;		// deleted by the retention limit
+};
+
+struct SessionMarkEntry
+{
+	std::string stream;
+	std::string label;			// "trial N" or "restart"
+	double time = 0;
+	SessionPosition position;
+};
+
+// Reads the segments and the index.csv of a session written by SessionStorage. A session
+// written as single logs.txt and logs_human.txt files reads as one segment 0 per stream
+// without marks.
+class SessionIndex
+{
+private:
+	std::string directory;
+	std::vector<SessionSegment> segments;	// by stream, then segment
+	std::vector<SessionMarkEntry> marks;
+public:
+	// False if the directory holds neither stream.
+	bool load(const std::string& directory);
+	static bool isSession(const std::string& directory);
+
+	const std::vector<SessionSegment>& getSegments() const { return segments; }
+	const std::vector<SessionMarkEntry>& getMarks() const { return marks; }
+	// Trial n (from 1) of a stream, from its mark up to the next trial mark.
+	bool findTrial(const std::string& stream, int trial, SessionPosition& begin, SessionPosition& end, double& time) const;
+	// Hands the text of a stream from begin up to end to consumer, one segment at a time and
+	// in order. Only the segments in the range are read; removed segments are skipped.
+	void read(const std::string& stream, const SessionPosition& begin, const SessionPosition& end,
+		const std::function<void(std::string_view)>& consumer) const;
+};
+
+class SessionLogParser
+{
+public:
+	static bool parseTimestamp(std::string_view text, double& seconds);
+	static void parseEvents(std::string_view text, std::vector<SessionEvent>& events);
+	static bool parseHandPose(std::string_view line, double& time, Pose& pose);
+	static void parseHandTrajectory(std::string_view text, std::vector<HandSample>& samples);
+	// All trials, or only the given one (from 1), read through the session index.
+	static std::vector<TrialMetrics> analyzeSession(const std::string& directory, int trial = 0);
+	static std::string formatHeader();
+	static std::string format(const TrialMetrics& metrics);
+private:
+	static std::vector<TrialMetrics> computeTrialMetrics(const std::vector<SessionEvent>& events);
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+
+struct SessionStorageParameters
+{
+	// A segment is closed once it would grow past segmentBytes or has been open for
+	// segmentDuration, whichever comes first.
+	uint64_t segmentBytes;
+	std::chrono::seconds segmentDuration;
+	int compressionLevel;		// zlib level for closed segments, 0 keeps them as text
+	// Closed segments are deleted oldest first once together they take more than this on
+	// disk (0 = keep everything). Their entries stay in the index, marked as removed.
+	uint64_t maxSessionBytes;
+
+	SessionStorageParameters(uint64_t segmentBytes = 16ull << 20,
+		std::chrono::seconds segmentDuration = std::chrono::hours(1),
+		int compressionLevel = 6,
+		uint64_t maxSessionBytes = 4ull << 30)
+		: segmentBytes(segmentBytes), segmentDuration(segmentDuration),
+		compressionLevel(compressionLevel), maxSessionBytes(maxSessionBytes)
+	{}
+};
+
+// Segmented storage of the line streams of a session (logs, logs_human).
+//
+// Each stream is written to <stream>.NNNNNN.txt. write() only appends to the open segment;
+// when a segment is full it is closed and handed to a background thread ("storage"), which
+// gzips it to <stream>.NNNNNN.txt.gz (readable with zcat), removes the text file and
+// records the segment in index.csv. Every line starts with the 23-character timestamp
+// EventLogger writes, which gives the time range of each segment.
+//
+// index.csv is append-only:
+//   entry,stream,segment,offset,bytes,storedBytes,firstTime,lastTime,name
+//   segment,logs,3,,16777160,1529710,2024-05-02 10:00:00.125,2024-05-02 10:41:17.904,logs.000003.txt.gz
+//   mark,logs,4,20512,,,2024-05-02 10:42:03.018,,trial 7
+//   removed,logs_human,1,,,,,,logs_human.000001.txt.gz
+// A mark gives the segment and the offset in its uncompressed text of every stream at the
+// moment the mark was set, so a reader can go straight to one trial. SessionIndex in
+// session_log.h reads the index and the segments.
+class SessionStorage
+{
+	using Clock = std::chrono::steady_clock;
+	static constexpr size_t TIMESTAMP_LENGTH = 23;
+
+	struct Stream
+	{
+		std::string name;
+		std::mutex mutex;
+		std::ofstream file;
+		int segment = 0;
+		uint64_t bytes = 0;
+		uint64_t lines = 0;
+		char firstTime[TIMESTAMP_LENGTH + 1] = {};
+		char lastTime[TIMESTAMP_LENGTH + 1] = {};
+		Clock::time_point opened;
+	};
+
+	struct ClosedSegment
+	{
+		std::string stream;
+		int segment;
+		uint64_t bytes;
+		std::string firstTime;
+		std::string lastTime;
+	};
+
+	struct StoredSegment
+	{
+		std::string stream;
+		int segment;
+		std::string file;
+		uint64_t bytes;
+	};
+private:
+	SessionStorageParameters parameters;
+	std::string directory;
+	std::vector<std::unique_ptr<Stream>> streams;
+	std::mutex indexMutex;
+	std::ofstream index;
+	std::mutex queueMutex;
+	std::condition_variable wakeUp;
+	std::deque<ClosedSegment> closedSegments;	// guarded by queueMutex
+	bool stopRequested;							// guarded by queueMutex
+	std::thread compressorThread;
+	std::deque<StoredSegment> storedSegments;	// compressor thread
+	uint64_t storedBytes;						// compressor thread
+	Counter& segmentCount;
+	Counter& removedSegments;
+	Gauge& diskBytes;
+	Histogram& compressTime;
+public:
+	SessionStorage();
+	~SessionStorage();
+	SessionStorage(const SessionStorage&) = delete;
+	SessionStorage& operator=(const SessionStorage&) = delete;
+
+	bool open(const std::string& directory, const SessionStorageParameters& parameters = {});
+	// Closes every stream and waits until its last segments are stored.
+	void close();
+	bool isOpen() const { return index.is_open(); }
+
+	// Streams are added after open() and before the first write.
+	int addStream(const std::string& name);
+	// Appends whole lines to a stream. Does not allocate unless the segment is closed.
+	void write(int stream, const char* data, size_t length);
+	// Records the current position of every stream under a label.
+	void mark(const char* timestamp, const std::string& label);
+
+	static std::string segmentFile(const std::string& stream, int segment);
+private:
+	bool openSegment(Stream& stream);
+	void closeSegment(Stream& stream);
+	void writeIndex(const std::string& line);
+	void compress();
+	bool store(const ClosedSegment& segment, std::string& file, uint64_t& bytes);
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "dnf_architecture.h"
+#include "field_engine.h"
+#include "bump_detector.h"
+#include "input_staging.h"
+#include "metrics.h"
+
+struct ArchitectureUpdate;
+
+// A secondary architecture to run next to the primary one.
+struct ShadowArchitecture
+{
+	DnfArchitectureType type;
+	FieldPrecision precision;
+
+	ShadowArchitecture(DnfArchitectureType type, FieldPrecision precision = FieldPrecision::DOUBLE)
+		: type(type), precision(precision)
+	{}
+};
+
+// Steps a secondary architecture on a FieldEngine on its own thread ("shadow1", "shadow2", ...)
+// at the primary's step period. It receives the same hand positions and object availability
+// as the primary, encodes them for its own architecture and publishes them at the same time,
+// so its input frames carry the primary's sequence numbers. Its decisions are queued for the
+// bridge to log; they never reach the robot, and the primary's threads never wait on it.
+// The engine is built on the shadow thread, so it never delays the primary's startup.
+// Parameter updates reach it as they reach the primary; the file is parsed again against its
+// own architecture, so it takes the parameters the file sets for the kernels it shares by name.
+class ShadowRunner
+{
+private:
+	ShadowArchitecture architecture;
+	std::string name;
+	double deltaT;
+	std::chrono::microseconds stepPeriod;
+	BumpDetectorParameters decisionParameters;
+	DnfArchitectureDescription description;
+	std::unique_ptr<FieldEngineBase> engine;		// built by the shadow thread
+	InputEncoder encoder;				// experiment thread
+	InputStaging inputs;
+	uint64_t appliedInputFrame;			// shadow thread
+	BumpDetector detector;
+	DecisionEventQueue events;
+	int actionExecutionField;
+	std::array<int, 3> handStimuli;
+	std::array<int, 3> objectStimuli;
+	std::array<double, 3> objectPositions;
+	std::thread thread;
+	std::atomic<bool> stopRequested;
+	Histogram& stepTime;
+	// Parameter updates are mapped onto this architecture by the watcher and applied by the
+	// shadow thread between two steps; the likelihood parameters are picked up by the bridge.
+	std::shared_ptr<const ArchitectureUpdate> parsedUpdate;		// watcher thread
+	std::mutex updateMutex;
+	std::shared_ptr<const ArchitectureUpdate> pendingUpdate;	// guarded by updateMutex
+	std::shared_ptr<const ArchitectureUpdate> retiredUpdate;	// guarded by updateMutex, freed by the watcher
+	LikelihoodParameters stagedLikelihood;						// guarded by updateMutex
+	std::atomic<bool> updatePending;
+	std::atomic<bool> likelihoodPending;
+	std::shared_ptr<const ArchitectureUpdate> appliedUpdate;	// shadow thread
+public:
+	ShadowRunner(int id, const ShadowArchitecture& architecture, double deltaT,
+		std::chrono::microseconds stepPeriod, const BumpDetectorParameters& decisionParameters);
+	~ShadowRunner();
+
+	void start();
+	void stop();
+
+	void setInputs(const Position& handPosition, bool object1, bool object2, bool object3);
+	void setObjects(bool object1, bool object2, bool object3);
+	bool pollDecisionEvent(DecisionEvent& event);
+	void stageArchitectureUpdate(std::shared_ptr<const ArchitectureUpdate> update);
+
+	const ShadowArchitecture& getArchitecture() const { return architecture; }
+	const std::string& getName() const { return name; }
+private:
+	void build();
+	void run();
+	void applyInputs();
+	void applyArchitectureUpdate();
+};
+
+// decisions.csv in the session directory: the decision events of the primary and of every
+// shadow, one line each, on a common clock and keyed by the input frame they ran with.
+//   source,architecture,engine,event,object,previousObject,step,inputFrame,time,peak,position
+// source is "primary" or the shadow's thread name, engine is "dnf-composer", "remote" or the
+// FieldEngine precision, and time is the end of the step in seconds since the log was opened. Written by
+// the bridge only.
+class DecisionLog
+{
+	using Clock = std::chrono::steady_clock;
+private:
+	std::ofstream file;
+	Clock::time_point start;
+public:
+	bool open(const std::string& path);
+	void close();
+	void write(const char* source, DnfArchitectureType architecture, const char* engine, const DecisionEvent& event);
+	bool isOpen() const { return file.is_open(); }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Named shared memory mapping shared by co-located processes.
+// The first side to open the name creates and zero-fills it.
+class SharedMemory
+{
+private:
+	std::string name;
+	size_t size;
+	void* address;
+	bool created;
+#ifdef _WIN32
+	void* mapping;
+#else
+	int fd;
+#endif
+public:
+	SharedMemory();
+	~SharedMemory();
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	bool open(const std::string& name, size_t size);
+	void close();
+
+	void* data() const { return address; }
+	size_t getSize() const { return size; }
+	bool isOpen() const { return address != nullptr; }
+	bool wasCreated() const { return created; }
+};
+
+// Doorbell on a 32-bit word living in shared memory.
+// Linux uses a shared futex. Windows uses WaitOnAddress, whose wakes are process-local:
+// a ring from the same process wakes the waiter at once, one from another process is seen
+// within a 1 ms wait slice (or the system timer period, if that is coarser).
+void ringDoorbell(std::atomic<uint32_t>& word);
+bool waitForDoorbell(const std::atomic<uint32_t>& word, uint32_t lastSeen, std::chrono::microseconds timeout);
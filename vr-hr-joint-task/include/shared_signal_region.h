@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// Layout of the shared-memory region exchanged with a co-located peer
+// (a local stand-in for CoppeliaSim or a simulator plugin).
+// Every field is lock-free; the region contains no pointers so both sides can
+// map it at different addresses. The peer writes object poses and most signals,
+// the experiment writes the outgoing signals and the simulation request.
+struct SharedSignalRegion
+{
+	static constexpr uint32_t MAGIC = 0x48525652; // "HRVR"
+	static constexpr uint32_t VERSION = 1;
+	static constexpr int MAX_SIGNALS = 32;
+	static constexpr int MAX_OBJECTS = 8;
+	static constexpr int NAME_LENGTH = 32;
+
+	enum SlotState : uint32_t
+	{
+		SLOT_FREE = 0,
+		SLOT_CLAIMED = 1,
+		SLOT_READY = 2,
+	};
+
+	struct SignalSlot
+	{
+		std::atomic<uint32_t> state;
+		char name[NAME_LENGTH];
+		std::atomic<int32_t> value;
+	};
+
+	// Pose slots are guarded by a seqlock: odd sequence while the writer is
+	// inside, readers retry until they see the same even sequence twice.
+	struct ObjectSlot
+	{
+		std::atomic<uint32_t> state;
+		char name[NAME_LENGTH];
+		std::atomic<uint32_t> sequence;
+		std::atomic<double> pose[6]; // x, y, z, alpha, beta, gamma
+	};
+
+	std::atomic<uint32_t> magic;
+	std::atomic<uint32_t> version;
+	std::atomic<uint32_t> peerAttached;
+	std::atomic<uint32_t> simulationRequested;
+	// Incremented (and futex-woken) by the peer after every pose or signal update.
+	std::atomic<uint32_t> doorbell;
+	SignalSlot signals[MAX_SIGNALS];
+	ObjectSlot objects[MAX_OBJECTS];
+
+	void initialize()
+	{
+		uint32_t expected = 0;
+		if (magic.compare_exchange_strong(expected, MAGIC))
+			version.store(VERSION);
+	}
+
+	bool isValid() const
+	{
+		return magic.load() == MAGIC && version.load() == VERSION;
+	}
+
+	template<typename Slot>
+	static Slot* findOrClaim(Slot* slots, int count, const char* slotName)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			Slot& slot = slots[i];
+			uint32_t state = slot.state.load(std::memory_order_acquire);
+			if (state == SLOT_FREE)
+			{
+				if (slot.state.compare_exchange_strong(state, SLOT_CLAIMED))
+				{
+					std::strncpy(slot.name, slotName, NAME_LENGTH - 1);
+					slot.name[NAME_LENGTH - 1] = '\0';
+					slot.state.store(SLOT_READY, std::memory_order_release);
+					return &slot;
+				}
+			}
+			while (state == SLOT_CLAIMED)
+				state = slot.state.load(std::memory_order_acquire);
+			if (std::strncmp(slot.name, slotName, NAME_LENGTH - 1) == 0)
+				return &slot;
+		}
+		return nullptr;
+	}
+
+	SignalSlot* signal(const char* signalName)
+	{
+		return findOrClaim(signals, MAX_SIGNALS, signalName);
+	}
+
+	ObjectSlot* object(const char* objectName)
+	{
+		return findOrClaim(objects, MAX_OBJECTS, objectName);
+	}
+
+	static void writePose(ObjectSlot& slot, const double (&values)[6])
+	{
+		const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (int i = 0; i < 6; ++i)
+			slot.pose[i].store(values[i], std::memory_order_relaxed);
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	static uint32_t readPose(const ObjectSlot& slot, double (&values)[6])
+	{
+		while (true)
+		{
+			const uint32_t before = slot.sequence.load(std::memory_order_acquire);
+			if (before & 1)
+				continue;
+			for (int i = 0; i < 6; ++i)
+				values[i] = slot.pose[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) == before)
+				return before;
+		}
+	}
+};
+
+static_assert(std::atomic<double>::is_always_lock_free, "Shared pose slots require lock-free doubles.");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared signal slots require lock-free integers.");
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "coppeliasim_handler.h"
+#include "coroutine_executor.h"
+#include "dnf_engine.h"
+#include "metrics.h"
+#include "shadow_mode.h"
+
+struct LogMsgs
+{
+    int lastTargetObject = -1;
+	bool prevSimStarted = false;
+    bool prevRobotGraspObj1 = false;
+    bool prevRobotGraspObj2 = false;
+    bool prevRobotGraspObj3 = false;
+    bool prevHumanGraspObj1 = false;
+    bool prevHumanGraspObj2 = false;
+    bool prevHumanGraspObj3 = false;
+    bool prevRobotPlaceObj1 = false;
+    bool prevRobotPlaceObj2 = false;
+    bool prevRobotPlaceObj3 = false;
+    bool prevHumanPlaceObj1 = false;
+    bool prevHumanPlaceObj2 = false;
+    bool prevHumanPlaceObj3 = false;
+
+    void clear()
+	{
+        lastTargetObject = -1;
+		prevSimStarted = false;
+        prevRobotGraspObj1 = false;
+        prevRobotGraspObj2 = false;
+        prevRobotGraspObj3 = false;
+        prevHumanGraspObj1 = false;
+        prevHumanGraspObj2 = false;
+        prevHumanGraspObj3 = false;
+        prevRobotPlaceObj1 = false;
+        prevRobotPlaceObj2 = false;
+        prevRobotPlaceObj3 = false;
+        prevHumanPlaceObj1 = false;
+        prevHumanPlaceObj2 = false;
+        prevHumanPlaceObj3 = false;
+    }
+};
+
+// The loop between the simulator and the DNF engine, a coroutine on the experiment thread.
+// It runs once for every pose or signal update the I/O thread delivers, and as soon as the
+// engine reports a decision, so a new target reaches the robot without waiting for the next
+// pose. Kept apart from the experiment lifecycle so the allocation check runs this very code.
+class SignalBridge
+{
+private:
+	CoppeliasimHandler& coppeliasimHandler;
+	DnfEngine& dnfEngine;
+	const std::vector<std::unique_ptr<ShadowRunner>>& shadows;
+	DecisionLog& decisionLog;
+	AsyncCondition& updates;
+	const std::atomic<bool>& stopRequested;
+	IncomingSignals inSignals;
+	OutgoingSignals outSignals;
+	Pose handPose;
+	LogMsgs logMsgs;
+	// Members rather than locals, so the wait predicate captures only this and fits
+	// std::function's small buffer.
+	uint64_t handledUpdate;
+	uint64_t handledDecision;
+	// Signal reads outnumber pose reads; the encoders only advance on a new pose.
+	uint64_t handledPose;
+	std::array<bool, 3> sentObjects;
+	LoopMeter& bridgeLoopMeter;
+	Histogram& decisionDelivery;
+public:
+	SignalBridge(CoppeliasimHandler& coppeliasimHandler, DnfEngine& dnfEngine,
+		const std::vector<std::unique_ptr<ShadowRunner>>& shadows, DecisionLog& decisionLog,
+		AsyncCondition& updates, const std::atomic<bool>& stopRequested);
+
+	// Returns once stopRequested is set or the engine is lost.
+	Coroutine run();
+	// The scene is asked to start the simulation with the next signal write.
+	void requestSimulationStart() { outSignals.startSim = true; }
+	// Forgets the scene state logged so far, so a restarted trial logs its events again.
+	void resetSystemState() { logMsgs.clear(); }
+private:
+	bool isSessionOver() const;
+	void sendInputsToDnf();
+	void sendTargetObjectToRobot();
+	void handleDecisionEvents();
+	void interpretAndLogSystemState();
+
+	bool areObjectsPresent() const;
+	bool areAllObjectsPresent() const;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+#include "coppeliasim_transport.h"
+#include "metrics.h"
+
+struct OutgoingSignals
+{
+	static constexpr const char* START_SIM = "startSim";
+	static constexpr const char* TARGET_OBJECT = "targetObject";
+
+	bool startSim;
+	int targetObject;
+
+	OutgoingSignals()
+		: startSim(false)
+		, targetObject(0)
+	{}
+
+	bool operator==(const OutgoingSignals& other) const
+	{
+		return startSim == other.startSim && targetObject == other.targetObject;
+	}
+};
+
+struct SignalPublisherParameters
+{
+	// Changes arriving within this window of the previous write are merged into one write.
+	std::chrono::milliseconds coalesceWindow;
+	// All signals are rewritten at this period even if nothing changed.
+	std::chrono::milliseconds refreshPeriod;
+
+	SignalPublisherParameters(std::chrono::milliseconds coalesceWindow = std::chrono::milliseconds(5),
+		std::chrono::milliseconds refreshPeriod = std::chrono::milliseconds(1000))
+		: coalesceWindow(coalesceWindow), refreshPeriod(refreshPeriod)
+	{}
+};
+
+struct SignalPublisherStatistics
+{
+	uint64_t changes = 0;
+	uint64_t writes = 0;
+	uint64_t refreshes = 0;
+	// Time from the first change of a burst until its write was acknowledged.
+	double lastLatencyMs = 0;
+	double meanLatencyMs = 0;
+	double maxLatencyMs = 0;
+};
+
+// Sends the outgoing signals only when their value changes.
+// The first change after a quiet period is written immediately; further changes
+// inside the coalescing window are merged and written once the window closes.
+class SignalPublisher
+{
+public:
+	using Clock = std::chrono::steady_clock;
+private:
+	SignalPublisherParameters parameters;
+	mutable std::mutex mutex;
+	OutgoingSignals pending;
+	OutgoingSignals sent;
+	bool hasSent;
+	bool isDirty;
+	// A published change is waiting to be written; firstChangeTime is when it came in.
+	// Full writes after construction or reset() without one are not timed.
+	bool hasChange;
+	Clock::time_point firstChangeTime;
+	uint64_t timedWrites;
+	Clock::time_point lastWriteTime;
+	Clock::time_point lastChangeWriteTime;
+	SignalPublisherStatistics statistics;
+	Histogram& writeTime;
+	Counter& remoteWrites;
+public:
+	SignalPublisher(const SignalPublisherParameters& parameters = {});
+
+	// Returns true when the change starts a new burst, i.e. service() is due now.
+	bool publish(const OutgoingSignals& signals);
+	// Performs the write that is due, if any, and returns when it wants to be called again.
+	Clock::time_point service(const CoppeliasimTransport& transport);
+	// Forces a full write on the next service, e.g. after the transport reconnected.
+	void reset();
+
+	SignalPublisherStatistics getStatistics() const;
+private:
+	void write(const CoppeliasimTransport& transport, const OutgoingSignals& signals, const OutgoingSignals& previous, bool all) const;
+	void writeSignal(const CoppeliasimTransport& transport, const char* name, int value) const;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <random>
+
+#include "misc.h"
+
+struct SyntheticParticipantParameters
+{
+	uint64_t seed;
+	double sampleRate;				// Hz, the rate the RightController pose is read at
+	Position restPosition;			// where the hand waits between reaches
+	Position placePosition;			// where grasped objects are put down
+	double onsetDelay;				// seconds at rest before a reach, uniform in onsetDelay +/- onsetJitter
+	double onsetJitter;
+	double meanSpeed;				// m/s averaged over a reach, uniform in meanSpeed * (1 +/- speedJitter)
+	double speedJitter;
+	double hesitationProbability;	// chance that a reach stops part-way and waits
+	double hesitationDuration;		// seconds, uniform in [0.5, 1.5] times this
+	double switchProbability;		// chance that a reach is redirected to another object
+	double graspDuration;			// seconds the hand stays on the object while grasping
+	double placeDuration;			// seconds the hand stays at the place position while placing
+	double trialPause;				// seconds between the last place and the objects reappearing
+	double noise;					// standard deviation of the pose sensor noise, in metres
+
+	SyntheticParticipantParameters(uint64_t seed = 1, double sampleRate = 90.0,
+		const Position& restPosition = { 0.30, 0.0, 0.85 }, const Position& placePosition = { 0.25, -0.35, 0.75 },
+		double onsetDelay = 0.8, double onsetJitter = 0.4, double meanSpeed = 0.5, double speedJitter = 0.25,
+		double hesitationProbability = 0.15, double hesitationDuration = 0.4, double switchProbability = 0.15,
+		double graspDuration = 0.4, double placeDuration = 0.3, double trialPause = 2.0, double noise = 0.002)
+		: seed(seed), sampleRate(sampleRate), restPosition(restPosition), placePosition(placePosition),
+		onsetDelay(onsetDelay), onsetJitter(onsetJitter), meanSpeed(meanSpeed), speedJitter(speedJitter),
+		hesitationProbability(hesitationProbability), hesitationDuration(hesitationDuration),
+		switchProbability(switchProbability), graspDuration(graspDuration), placeDuration(placeDuration),
+		trialPause(trialPause), noise(noise)
+	{}
+};
+
+// One pose sample with the scene signals that would be read alongside it.
+struct SyntheticSample
+{
+	double time;						// seconds since the generator started
+	Pose pose;
+	std::array<bool, 3> objectPresent;	// objects still on the table, object 1 first
+	std::array<bool, 3> humanGrasping;
+	std::array<bool, 3> humanPlacing;
+	int intendedObject;					// object the hand is heading for or holding (1-3), 0 otherwise
+	int trial;
+};
+
+// Generates reach-to-grasp trajectories of a participant clearing the table object by object,
+// trial after trial, without a headset or a scene. Each movement follows a minimum-jerk profile;
+// a hesitating reach is split into two movements with a pause in between, and a target switch
+// superimposes a second movement from the first target to the new one (Flash & Henis, 1991).
+// The same seed always gives the same stream, on every platform.
+class SyntheticParticipant
+{
+	enum class Phase
+	{
+		WAIT,
+		REACH,
+		GRASP,
+		TRANSPORT,
+		PLACE,
+		RETURN,
+		PAUSE,
+	};
+
+	// A minimum-jerk displacement of delta, starting at start and lasting duration.
+	struct Movement
+	{
+		double start;
+		double duration;
+		Position delta;
+	};
+private:
+	SyntheticParticipantParameters parameters;
+	std::mt19937_64 generator;
+	double spareNormal;
+	bool hasSpareNormal;
+	uint64_t sampleIndex;
+
+	Phase phase;
+	double phaseEnd;
+	Position origin;
+	std::array<Movement, 2> movements;
+	int movementCount;
+	double switchTime;
+	int switchTarget;
+	int trial;
+	int object;		// object of the current reach, 1-3, or 0
+	std::array<bool, 3> objectPresent;
+	std::array<bool, 3> humanGrasping;
+	std::array<bool, 3> humanPlacing;
+public:
+	explicit SyntheticParticipant(const SyntheticParticipantParameters& parameters = {});
+
+	// Restarts the stream from the seed.
+	void reset();
+	SyntheticSample next();
+	void generate(SyntheticSample* samples, size_t count);
+
+	const SyntheticParticipantParameters& getParameters() const { return parameters; }
+
+	// Minimum-jerk position profile 10s^3 - 15s^4 + 6s^5, clamped to [0, 1].
+	static double minimumJerk(double s);
+private:
+	void advance(double time);
+	void enterPhase(Phase next, double time);
+	void startReach(double time);
+	void startMovement(double time, const Position& target);
+	Position positionAt(double time) const;
+	Position targetOf(int objectNumber) const;
+	int pickObject(int excluded);
+	double movementDuration(const Position& from, const Position& to);
+	double uniform();
+	double uniform(double low, double high);
+	double normal();
+};
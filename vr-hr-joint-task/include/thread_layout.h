@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+// Placement of one named runtime thread.
+// An empty cpu set leaves the thread where the OS puts it.
+struct ThreadPlacement
+{
+	std::vector<int> cpus;
+	bool realtime;		// SCHED_FIFO on Linux, time-critical priority on Windows
+	int priority;		// SCHED_FIFO priority (1-99), only used when realtime
+	int niceness;		// -20..19, only used when not realtime
+
+	ThreadPlacement()
+		: realtime(false), priority(0), niceness(0)
+	{}
+
+	std::string toString() const;
+};
+
+// Runtime configuration that pins the named threads of the process
+// (simulation, experiment, io) to CPU sets
+// and optionally raises their scheduling class.
+// The layout is read from a JSON file, e.g.
+// { "threads": { "simulation": { "cpus": [2, 3], "realtime": true, "priority": 50 },
+//                "io": { "cpus": [1], "niceness": -5 } } }
+class ThreadLayout
+{
+	static std::unordered_map<std::string, ThreadPlacement> placements;
+	static std::mutex mutex;
+public:
+	static void load(const std::string& filePath);
+	static void applyToCurrentThread(const std::string& threadName);
+	static void report();
+private:
+	static bool setAffinity(const std::vector<int>& cpus, std::string& error);
+	static bool setScheduling(const ThreadPlacement& placement, std::string& error);
+};
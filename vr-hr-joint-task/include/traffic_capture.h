@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "coppeliasim_transport.h"
+#include "metrics.h"
+
+// Binary capture of the remote calls made through a CoppeliasimTransport.
+//
+// File layout (little endian):
+//   header: "HRVRTRC1", int64 capture start (nanoseconds since 1970-01-01)
+//   record: uint8 type, then
+//     NAME:               uint16 id, uint16 length, char[length]; names a signal or object
+//                         for the records that follow
+//     any other type:     uint64 call start (nanoseconds since capture start),
+//                         uint32 call duration (nanoseconds), then
+//       INITIALIZE:       uint8 result
+//       START_SIMULATION, STOP_SIMULATION: nothing
+//       GET_SIGNAL, SET_SIGNAL: uint16 name, int32 value
+//       GET_HANDLE:       uint16 name, int32 handle
+//       GET_POSE:         int32 handle, double[6] x, y, z, alpha, beta, gamma
+// isConnected() is local and is not captured.
+namespace traffic
+{
+	enum class CallType : uint8_t
+	{
+		NAME,
+		INITIALIZE,
+		START_SIMULATION,
+		STOP_SIMULATION,
+		GET_SIGNAL,
+		SET_SIGNAL,
+		GET_HANDLE,
+		GET_POSE,
+	};
+
+	constexpr char MAGIC[8] = { 'H', 'R', 'V', 'R', 'T', 'R', 'C', '1' };
+}
+
+// Forwards every call to another transport and appends it, with its response and timing,
+// to a capture file. The file is opened on the first initialize(); without an explicit
+// path it is traffic.bin in the session directory.
+class RecordingTransport : public CoppeliasimTransport
+{
+	using Clock = std::chrono::steady_clock;
+private:
+	std::unique_ptr<CoppeliasimTransport> inner;
+	std::string path;
+	mutable std::mutex mutex;
+	mutable std::ofstream file;
+	mutable std::vector<char> buffer;
+	mutable std::unordered_map<std::string, uint16_t> names;
+	Clock::time_point start;
+	mutable Clock::time_point lastFlush;
+	Counter& recordedCalls;
+public:
+	RecordingTransport(std::unique_ptr<CoppeliasimTransport> inner, std::string path = {});
+	~RecordingTransport() override;
+
+	bool initialize() override;
+	bool isConnected() const override;
+	void startSimulation() const override;
+	void stopSimulation() const override;
+	int getIntegerSignal(const std::string& name) const override;
+	void setIntegerSignal(const std::string& name, int value) const override;
+	int getObjectHandle(const std::string& name) const override;
+	Pose getObjectPose(int handle) const override;
+	// Not recorded; a replay is paced by its recorded timing instead.
+	const std::atomic<uint32_t>* getUpdateDoorbell() const override { return inner->getUpdateDoorbell(); }
+private:
+	bool open();
+	uint16_t nameId(const std::string& name) const;
+	void writeCall(traffic::CallType type, Clock::time_point begin) const;
+	template <typename T>
+	void put(const T& value) const { file.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+};
+
+// Serves the responses of a capture instead of a live scene. Each kind of call (and each
+// signal name or object handle) replays its own recorded sequence in order, so the
+// unchanged pipeline sees the traffic it saw when the capture was made. With speed > 0
+// every call waits for its recorded start time, divided by speed, and lasts its recorded
+// duration, divided by speed; with speed 0 responses come back as fast as they are asked
+// for. Once any sequence runs out, the transport reports itself disconnected.
+class ReplayTransport : public CoppeliasimTransport
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Record
+	{
+		uint64_t time;
+		uint32_t duration;
+		int value;
+		Pose pose;
+	};
+
+	struct Sequence
+	{
+		std::vector<Record> records;
+		size_t next = 0;
+	};
+private:
+	std::string path;
+	double speed;
+	bool loaded;
+	std::unordered_map<std::string, uint16_t> names;
+	mutable std::unordered_map<uint64_t, Sequence> sequences;
+	Clock::time_point start;
+	mutable std::atomic<bool> connected;
+	mutable std::atomic<bool> exhausted;
+	Counter& mismatches;
+public:
+	explicit ReplayTransport(std::string path, double speed = 1.0);
+
+	bool initialize() override;
+	bool isConnected() const override;
+	void startSimulation() const override;
+	void stopSimulation() const override;
+	int getIntegerSignal(const std::string& name) const override;
+	void setIntegerSignal(const std::string& name, int value) const override;
+	int getObjectHandle(const std::string& name) const override;
+	Pose getObjectPose(int handle) const override;
+
+	bool isExhausted() const { return exhausted.load(std::memory_order_acquire); }
+private:
+	bool load();
+	static uint64_t keyOf(traffic::CallType type, uint32_t argument);
+	uint64_t keyOf(traffic::CallType type, const std::string& name) const;
+	// Next record of the sequence, after waiting for its recorded timing; nullptr if none is left.
+	const Record* next(uint64_t key) const;
+};
@@ -0,0 +1,183 @@
+#include "bump_detector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Running sums of one supra-threshold region.
+	struct Region
+	{
+		int start = -1;
+		int end = -1;
+		double mass = 0;
+		double moment = 0;
+		double peak = 0;
+
+		bool isOpen() const { return start >= 0; }
+		void add(int index, double position, double value, double threshold)
+		{
+			if (start < 0)
+			{
+				start = index;
+				peak = value;
+			}
+			end = index;
+			mass += value - threshold;
+			moment += (value - threshold) * position;
+			peak = std::max(peak, value);
+		}
+		void merge(const Region& other, double offset)
+		{
+			mass += other.mass;
+			moment += other.moment + other.mass * offset;
+			peak = std::max(peak, other.peak);
+			end = other.end;
+		}
+	};
+}
+
+BumpDetector::BumpDetector(const BumpDetectorParameters& parameters, bool circular, double fieldLength)
+	: parameters(parameters), circular(circular), fieldLength(fieldLength), decision(0)
+{}
+
+template <typename T>
+bool BumpDetector::update(const T* activation, int size, double dx, uint64_t step, DecisionEvent& event)
+{
+	const double threshold = parameters.threshold;
+	Region strongest, current, wrapped;
+	for (int i = 0; i < size; ++i)
+	{
+		const double value = static_cast<double>(activation[i]);
+		if (value > threshold)
+		{
+			current.add(i, i * dx, value, threshold);
+			continue;
+		}
+		if (!current.isOpen())
+			continue;
+		// On a circular field a region touching the left border may continue at the right one.
+		if (circular && current.start == 0)
+			wrapped = current;
+		else if (current.peak > strongest.peak || !strongest.isOpen())
+			strongest = current;
+		current = Region();
+	}
+	if (current.isOpen())
+	{
+		if (wrapped.isOpen() && current.end == size - 1)
+			current.merge(wrapped, fieldLength);
+		else if (wrapped.isOpen() && (wrapped.peak > strongest.peak || !strongest.isOpen()))
+			strongest = wrapped;
+		if (current.peak > strongest.peak || !strongest.isOpen())
+			strongest = current;
+	}
+	else if (wrapped.isOpen() && (wrapped.peak > strongest.peak || !strongest.isOpen()))
+		strongest = wrapped;
+
+	Bump next;
+	if (strongest.isOpen() && strongest.mass > 0)
+	{
+		next.present = true;
+		next.position = strongest.moment / strongest.mass;
+		if (circular)
+			next.position = std::fmod(next.position, fieldLength);
+		next.amplitude = strongest.peak;
+		const int samples = strongest.end >= strongest.start ? strongest.end - strongest.start + 1
+			: size - strongest.start + strongest.end + 1;
+		next.width = samples * dx;
+		next.growth = bump.present ? next.amplitude - bump.amplitude : next.amplitude - threshold;
+		next.drift = bump.present ? next.position - bump.position : 0;
+	}
+	else if (bump.present)
+		next.growth = -bump.amplitude;
+	bump = next;
+
+	int object = decision;
+	if (decision == 0)
+	{
+		if (bump.present && bump.amplitude >= parameters.onsetAmplitude)
+			object = nearestObject(bump.position);
+	}
+	else if (!bump.present || bump.amplitude < parameters.releaseAmplitude)
+		object = 0;
+	else
+		object = nearestObject(bump.position);
+
+	if (object == decision)
+		return false;
+	event.type = decision == 0 ? DecisionEventType::ONSET : object == 0 ? DecisionEventType::RELEASE : DecisionEventType::CHANGE;
+	event.object = object;
+	event.previousObject = decision;
+	event.step = step;
+	event.time = DecisionEvent::Clock::now();
+	event.bump = bump;
+	decision = object;
+	return true;
+}
+
+template bool BumpDetector::update<double>(const double*, int, double, uint64_t, DecisionEvent&);
+template bool BumpDetector::update<float>(const float*, int, double, uint64_t, DecisionEvent&);
+
+void BumpDetector::reset()
+{
+	bump = Bump();
+	decision = 0;
+}
+
+int BumpDetector::nearestObject(double position) const
+{
+	int nearest = 0;
+	double nearestDistance = 0;
+	for (int i = 0; i < static_cast<int>(parameters.objectPositions.size()); ++i)
+	{
+		double distance = std::abs(position - parameters.objectPositions[i]);
+		if (circular)
+			distance = std::min(distance, fieldLength - distance);
+		if (nearest == 0 || distance < nearestDistance)
+		{
+			nearest = i + 1;
+			nearestDistance = distance;
+		}
+	}
+	return nearest;
+}
+
+void DecisionEventQueue::push(const DecisionEvent& event)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	events[(head + count) % capacity] = event;
+	if (count < capacity)
+		count++;
+	else
+		head = (head + 1) % capacity;
+	pushed++;
+}
+
+bool DecisionEventQueue::pop(DecisionEvent& event)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (count == 0)
+		return false;
+	event = events[head];
+	head = (head + 1) % capacity;
+	count--;
+	return true;
+}
+
+uint64_t DecisionEventQueue::getPushedCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pushed;
+}
+
+const char* toString(DecisionEventType type)
+{
+	switch (type)
+	{
+	case DecisionEventType::ONSET: return "onset";
+	case DecisionEventType::CHANGE: return "change";
+	case DecisionEventType::RELEASE: return "release";
+	}
+	return "unknown";
+}
@@ -0,0 +1,115 @@
+#include "connection_manager.h"
+
+#include <algorithm>
+
+#include "event_logger.h"
+
+ConnectionManager::ConnectionManager(const ConnectionParameters& parameters)
+	: parameters(parameters)
+	, stopRequested(false)
+	, generator(std::random_device{}())
+	, attempts(Metrics::counter("connection.attempts"))
+	, drops(Metrics::counter("connection.drops"))
+{}
+
+bool ConnectionManager::connect(CoppeliasimTransport& transport, const std::string& name)
+{
+	setState(name, ConnectionState::CONNECTING);
+	std::chrono::milliseconds backoff = parameters.initialBackoff;
+	while (!isStopRequested())
+	{
+		attempts.increment();
+		if (transport.initialize())
+		{
+			setState(name, ConnectionState::CONNECTED);
+			return true;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		const auto delay = nextDelay(backoff);
+		if (stateChanged.wait_for(lock, delay, [this] { return stopRequested; }))
+			break;
+		backoff = std::min(backoff * 2, parameters.maxBackoff);
+	}
+	setState(name, ConnectionState::DISCONNECTED);
+	return false;
+}
+
+void ConnectionManager::markDisconnected(const std::string& name)
+{
+	if (getState(name) == ConnectionState::CONNECTED && !isStopRequested())
+		drops.increment();
+	setState(name, ConnectionState::DISCONNECTED);
+}
+
+bool ConnectionManager::waitUntilConnected(const std::string& name)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	stateChanged.wait(lock, [&] {
+		const auto state = states.find(name);
+		return stopRequested || (state != states.end() && state->second == ConnectionState::CONNECTED);
+	});
+	return !stopRequested;
+}
+
+bool ConnectionManager::waitUntilConnected(const std::string& name, std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const bool connected = stateChanged.wait_for(lock, timeout, [&] {
+		const auto state = states.find(name);
+		return stopRequested || (state != states.end() && state->second == ConnectionState::CONNECTED);
+	});
+	return connected && !stopRequested;
+}
+
+void ConnectionManager::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopRequested = true;
+	}
+	stateChanged.notify_all();
+}
+
+bool ConnectionManager::isStopRequested() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stopRequested;
+}
+
+ConnectionState ConnectionManager::getState(const std::string& name) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto state = states.find(name);
+	return state != states.end() ? state->second : ConnectionState::DISCONNECTED;
+}
+
+void ConnectionManager::setState(const std::string& name, ConnectionState state)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto& current = states.try_emplace(name, ConnectionState::DISCONNECTED).first->second;
+		if (current == state)
+			return;
+		current = state;
+	}
+	stateChanged.notify_all();
+	EventLogger::log(LogLevel::CONTROL, "Connection " + name + ": " + toString(state) + ".");
+}
+
+std::chrono::milliseconds ConnectionManager::nextDelay(std::chrono::milliseconds backoff)
+{
+	std::uniform_real_distribution<double> factor(1.0 - parameters.jitter, 1.0 + parameters.jitter);
+	return std::chrono::milliseconds(static_cast<int64_t>(static_cast<double>(backoff.count()) * factor(generator)));
+}
+
+const char* toString(ConnectionState state)
+{
+	switch (state)
+	{
+	case ConnectionState::DISCONNECTED: return "disconnected";
+	case ConnectionState::CONNECTING: return "connecting";
+	case ConnectionState::CONNECTED: return "connected";
+	}
+	return "unknown";
+}
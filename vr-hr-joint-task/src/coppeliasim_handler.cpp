@@ -1,13 +1,70 @@
 #include "coppeliasim_handler.h"
 
-CoppeliasimHandler::CoppeliasimHandler()
-	: incomingSignalsClient("127.0.0.1", 19999),
-	outgoingSignalsClient("127.0.0.1", 19998),
-	handClient("127.0.0.1", 19995)
+#include <array>
+
+#include "event_logger.h"
+
+namespace
+{
+	constexpr const char* SIMULATOR = "simulator";
+
+	struct SignalBinding
+	{
+		std::string name;
+		bool IncomingSignals::* field;
+	};
+
+	// The names are kept as strings so polling them does not build a temporary per call.
+	const std::array<SignalBinding, 20>& getIncomingSignalBindings()
+	{
+		static const std::array<SignalBinding, 20> bindings{ {
+			{ IncomingSignals::SIM_STARTED, &IncomingSignals::simStarted },
+			{ IncomingSignals::OBJECT1_EXISTS, &IncomingSignals::object1 },
+			{ IncomingSignals::OBJECT2_EXISTS, &IncomingSignals::object2 },
+			{ IncomingSignals::OBJECT3_EXISTS, &IncomingSignals::object3 },
+			{ IncomingSignals::ROBOT_APPROACH, &IncomingSignals::robotApproaching },
+			{ IncomingSignals::ROBOT_GRASP, &IncomingSignals::robotGrasping },
+			{ IncomingSignals::ROBOT_GRASP_OBJ1, &IncomingSignals::robotGraspObj1 },
+			{ IncomingSignals::ROBOT_GRASP_OBJ2, &IncomingSignals::robotGraspObj2 },
+			{ IncomingSignals::ROBOT_GRASP_OBJ3, &IncomingSignals::robotGraspObj3 },
+			{ IncomingSignals::ROBOT_PLACE_OBJ1, &IncomingSignals::robotPlaceObj1 },
+			{ IncomingSignals::ROBOT_PLACE_OBJ2, &IncomingSignals::robotPlaceObj2 },
+			{ IncomingSignals::ROBOT_PLACE_OBJ3, &IncomingSignals::robotPlaceObj3 },
+			{ IncomingSignals::HUMAN_GRASP_OBJ1, &IncomingSignals::humanGraspObj1 },
+			{ IncomingSignals::HUMAN_GRASP_OBJ2, &IncomingSignals::humanGraspObj2 },
+			{ IncomingSignals::HUMAN_GRASP_OBJ3, &IncomingSignals::humanGraspObj3 },
+			{ IncomingSignals::HUMAN_PLACE_OBJ1, &IncomingSignals::humanPlaceObj1 },
+			{ IncomingSignals::HUMAN_PLACE_OBJ2, &IncomingSignals::humanPlaceObj2 },
+			{ IncomingSignals::HUMAN_PLACE_OBJ3, &IncomingSignals::humanPlaceObj3 },
+			{ IncomingSignals::CAN_RESTART, &IncomingSignals::canRestart },
+			{ IncomingSignals::RESTART, &IncomingSignals::restart },
+		} };
+		return bindings;
+	}
+}
+
+CoppeliasimHandler::CoppeliasimHandler(const TransportParameters& transport, const SignalPublisherParameters& publisherParameters,
+	const ConnectionParameters& connectionParameters, const IoSchedulerParameters& ioParameters)
+	: CoppeliasimHandler(createCoppeliasimTransport(transport, 19999), publisherParameters, connectionParameters, ioParameters)
 {
-	incomingSignalsClient.setLogMode(coppeliasim_cpp::LogMode::NO_LOGS);
-	outgoingSignalsClient.setLogMode(coppeliasim_cpp::LogMode::NO_LOGS);
-	handClient.setLogMode(coppeliasim_cpp::LogMode::NO_LOGS);
+}
+
+CoppeliasimHandler::CoppeliasimHandler(std::unique_ptr<CoppeliasimTransport> transport, const SignalPublisherParameters& publisherParameters,
+	const ConnectionParameters& connectionParameters, const IoSchedulerParameters& ioParameters)
+	: client(std::move(transport)),
+	publisher(publisherParameters),
+	connections(connectionParameters),
+	doorbellStopRequested(false),
+	poseCount(0),
+	updateCount(0),
+	signalReadTime(Metrics::histogram("rtt.getIntegerSignal")),
+	poseReadTime(Metrics::histogram("rtt.getObjectPose"))
+{
+	// The hand pose feeds the fields at the headset rate and goes first, then pending writes,
+	// then the scene signals, which only change on discrete task events.
+	poseTask = scheduler.addPeriodic("hand", 0, ioParameters.poseRate, [this] { readHandPosition(); });
+	publishTask = scheduler.add("outgoingSignals", 1, [this](IoScheduler::Clock::time_point) { return publisher.service(*client); });
+	scheduler.addPeriodic("incomingSignals", 2, ioParameters.signalRate, [this] { readSignals(); });
 }
 
 CoppeliasimHandler::~CoppeliasimHandler()
@@ -17,147 +74,188 @@ CoppeliasimHandler::~CoppeliasimHandler()
 
 void CoppeliasimHandler::init()
 {
-	incomingSignalsThread = std::thread(&CoppeliasimHandler::incomingSignalsLoop, this);
-	outgoingSignalsThread = std::thread(&CoppeliasimHandler::outgoingSignalsLoop, this);
-	handThread = std::thread(&CoppeliasimHandler::readHandPosition, this);
+	ioThread = std::thread(&CoppeliasimHandler::ioLoop, this);
 }
 
-
-void CoppeliasimHandler::incomingSignalsLoop()
+void CoppeliasimHandler::ioLoop()
 {
-	
-	while (!incomingSignalsClient.initialize());
+	ThreadLayout::applyToCurrentThread("io");
 
-	incomingSignalsClient.startSimulation();
+	while (connections.connect(*client, SIMULATOR))
+	{
+		client->startSimulation();
 
-	resetSignals();
+		resetSignals();
 
-	while (isConnected())
-	{
-		readSignals();
-		//printSignals();
-	}
-}
+		// Handles are only valid for the scene instance they were resolved in.
+		hand.objectHandle = client->getObjectHandle("RightController");
 
-void CoppeliasimHandler::outgoingSignalsLoop()
-{
-	while (!outgoingSignalsClient.initialize());
+		// A restarted scene starts from its defaults, so everything is written again.
+		publisher.reset();
+		notifyUpdate();
 
-	while (outgoingSignalsClient.isConnected())
-	{
-		writeSignals();
+		// With a doorbell the pose is read as soon as the peer writes one; the poll stays as a fallback.
+		if (const std::atomic<uint32_t>* doorbell = client->getUpdateDoorbell())
+		{
+			doorbellStopRequested = false;
+			doorbellThread = std::thread(&CoppeliasimHandler::waitForPeerUpdates, this, std::cref(*doorbell));
+		}
+		scheduler.run([this] { return isConnected() && !connections.isStopRequested(); });
+		doorbellStopRequested = true;
+		if (doorbellThread.joinable())
+			doorbellThread.join();
+		connections.markDisconnected(SIMULATOR);
+		notifyUpdate();
 	}
 }
 
-
 void CoppeliasimHandler::setSignals(const OutgoingSignals& signals)
 {
-	outgoingSignals = signals;
+	if (publisher.publish(signals))
+		scheduler.trigger(publishTask);
 }
 
 
 IncomingSignals CoppeliasimHandler::getSignals() const
 {
+	std::lock_guard<std::mutex> lock(stateMutex);
 	return incomingSignals;
 }
 
 void CoppeliasimHandler::readHandPosition()
 {
-	while (!handClient.initialize());
-
-	hand.objectHandle = handClient.getObjectHandle("RightController");
-
-    while (handClient.isConnected())
-    {
-        coppeliasim_cpp::Pose pos = handClient.getObjectPose(hand.objectHandle);
-		hand.pose = { {pos.position.x,
-			pos.position.y,
-			pos.position.z},
-			{pos.orientation.alpha,
-			pos.orientation.beta,
-			pos.orientation.gamma}
-		};
-    }
+	const ScopedTimer timer(poseReadTime);
+	const Pose pose = client->getObjectPose(hand.objectHandle);
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		hand.pose = pose;
+		++poseCount;
+	}
+	notifyUpdate();
 }
 
 
 Pose CoppeliasimHandler::getHandPose() const
 {
+	std::lock_guard<std::mutex> lock(stateMutex);
 	return hand.pose;
 }
 
+Pose CoppeliasimHandler::getHandPose(uint64_t& poseNumber) const
+{
+	std::lock_guard<std::mutex> lock(stateMutex);
+	poseNumber = poseCount;
+	return hand.pose;
+}
+
+
+void CoppeliasimHandler::waitForPeerUpdates(const std::atomic<uint32_t>& doorbell)
+{
+	ThreadLayout::applyToCurrentThread("ioDoorbell");
+
+	uint32_t seen = doorbell.load(std::memory_order_acquire);
+	while (!doorbellStopRequested.load(std::memory_order_relaxed))
+	{
+		if (!waitForDoorbell(doorbell, seen, std::chrono::milliseconds(50)))
+			continue;
+		seen = doorbell.load(std::memory_order_acquire);
+		scheduler.trigger(poseTask);
+	}
+}
 
 void CoppeliasimHandler::end()
 {
+	connections.stop();
+	scheduler.stop();
+	if (!ioThread.joinable())
+		return;
+	ioThread.join();
+	// Only now, with the I/O thread gone, may this thread call into the client.
 	if (isConnected())
-		incomingSignalsClient.stopSimulation();
-	incomingSignalsThread.join();
-	outgoingSignalsThread.join();
-	handThread.join();
+		client->stopSimulation();
+	const SignalPublisherStatistics statistics = publisher.getStatistics();
+	EventLogger::log(LogLevel::CONTROL, "Outgoing signals: " + std::to_string(statistics.changes) + " changes, "
+		+ std::to_string(statistics.writes) + " writes, " + std::to_string(statistics.refreshes) + " refreshes, "
+		+ "change-to-ack latency mean " + std::to_string(statistics.meanLatencyMs) + " ms, max "
+		+ std::to_string(statistics.maxLatencyMs) + " ms.");
 }
 
 bool CoppeliasimHandler::isConnected() const
 {
-	return incomingSignalsClient.isConnected();
+	return client->isConnected();
+}
+
+bool CoppeliasimHandler::waitUntilConnected()
+{
+	return connections.waitUntilConnected(SIMULATOR);
+}
+
+bool CoppeliasimHandler::waitUntilConnected(std::chrono::milliseconds timeout)
+{
+	return connections.waitUntilConnected(SIMULATOR, timeout);
 }
 
 void CoppeliasimHandler::readSignals()
 {
-	incomingSignals.simStarted = incomingSignalsClient.getIntegerSignal(IncomingSignals::SIM_STARTED);
-	incomingSignals.object1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::OBJECT1_EXISTS);
-	incomingSignals.object2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::OBJECT2_EXISTS);
-	incomingSignals.object3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::OBJECT3_EXISTS);
-	incomingSignals.robotApproaching = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_APPROACH);
-	incomingSignals.robotGrasping = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_GRASP);
+	IncomingSignals signals;
+	for (const auto& binding : getIncomingSignalBindings())
+		signals.*binding.field = readSignal(binding.name);
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		incomingSignals = signals;
+	}
+	notifyUpdate();
+}
 
-	incomingSignals.robotGraspObj1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ1);
-	incomingSignals.robotGraspObj2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ2);
-	incomingSignals.robotGraspObj3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ3);
-	incomingSignals.robotPlaceObj1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ1);
-	incomingSignals.robotPlaceObj2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ2);
-	incomingSignals.robotPlaceObj3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ3);
-	incomingSignals.humanGraspObj1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ1);
-	incomingSignals.humanGraspObj2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ2);
-	incomingSignals.humanGraspObj3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ3);
-	incomingSignals.humanPlaceObj1 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ1);
-	incomingSignals.humanPlaceObj2 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ2);
-	incomingSignals.humanPlaceObj3 = incomingSignalsClient.getIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ3);
-	incomingSignals.canRestart = incomingSignalsClient.getIntegerSignal(IncomingSignals::CAN_RESTART);
-	incomingSignals.restart = incomingSignalsClient.getIntegerSignal(IncomingSignals::RESTART);
+void CoppeliasimHandler::setUpdateListener(std::function<void()> listener)
+{
+	updateListener = std::move(listener);
 }
 
-void CoppeliasimHandler::writeSignals() const
+uint64_t CoppeliasimHandler::getUpdateCount() const
 {
-	outgoingSignalsClient.setIntegerSignal(OutgoingSignals::START_SIM, outgoingSignals.startSim);
-	outgoingSignalsClient.setIntegerSignal(OutgoingSignals::TARGET_OBJECT, outgoingSignals.targetObject);
+	return updateCount.load(std::memory_order_acquire);
+}
+
+void CoppeliasimHandler::notifyUpdate()
+{
+	updateCount.fetch_add(1, std::memory_order_release);
+	if (updateListener)
+		updateListener();
+}
+
+int CoppeliasimHandler::readSignal(const std::string& name) const
+{
+	const ScopedTimer timer(signalReadTime);
+	return client->getIntegerSignal(name);
 }
 
 void CoppeliasimHandler::resetSignals() const
 {
-	incomingSignalsClient.setIntegerSignal(OutgoingSignals::START_SIM, 0);
-	incomingSignalsClient.setIntegerSignal(OutgoingSignals::TARGET_OBJECT, 0);
-
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::SIM_STARTED, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::OBJECT1_EXISTS, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::OBJECT2_EXISTS, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::OBJECT3_EXISTS, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_APPROACH, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_GRASP, 0);
-
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ1, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ2, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ3, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ1, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ2, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ3, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ1, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ2, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ3, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ1, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ2, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ3, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::CAN_RESTART, 0);
-	incomingSignalsClient.setIntegerSignal(IncomingSignals::RESTART, 0);
+	client->setIntegerSignal(OutgoingSignals::START_SIM, 0);
+	client->setIntegerSignal(OutgoingSignals::TARGET_OBJECT, 0);
+
+	client->setIntegerSignal(IncomingSignals::SIM_STARTED, 0);
+	client->setIntegerSignal(IncomingSignals::OBJECT1_EXISTS, 0);
+	client->setIntegerSignal(IncomingSignals::OBJECT2_EXISTS, 0);
+	client->setIntegerSignal(IncomingSignals::OBJECT3_EXISTS, 0);
+	client->setIntegerSignal(IncomingSignals::ROBOT_APPROACH, 0);
+	client->setIntegerSignal(IncomingSignals::ROBOT_GRASP, 0);
+
+	client->setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ1, 0);
+	client->setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ2, 0);
+	client->setIntegerSignal(IncomingSignals::ROBOT_GRASP_OBJ3, 0);
+	client->setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ1, 0);
+	client->setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ2, 0);
+	client->setIntegerSignal(IncomingSignals::ROBOT_PLACE_OBJ3, 0);
+	client->setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ1, 0);
+	client->setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ2, 0);
+	client->setIntegerSignal(IncomingSignals::HUMAN_GRASP_OBJ3, 0);
+	client->setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ1, 0);
+	client->setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ2, 0);
+	client->setIntegerSignal(IncomingSignals::HUMAN_PLACE_OBJ3, 0);
+	client->setIntegerSignal(IncomingSignals::CAN_RESTART, 0);
+	client->setIntegerSignal(IncomingSignals::RESTART, 0);
 }
 
 void CoppeliasimHandler::printSignals() const
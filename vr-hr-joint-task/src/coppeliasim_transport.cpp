@@ -0,0 +1,154 @@
+#include "coppeliasim_transport.h"
+
+#include "traffic_capture.h"
+
+SocketTransport::SocketTransport(const std::string& host, int port)
+	: client(host, port)
+{
+	client.setLogMode(coppeliasim_cpp::LogMode::NO_LOGS);
+}
+
+bool SocketTransport::initialize()
+{
+	return client.initialize();
+}
+
+bool SocketTransport::isConnected() const
+{
+	return client.isConnected();
+}
+
+void SocketTransport::startSimulation() const
+{
+	client.startSimulation();
+}
+
+void SocketTransport::stopSimulation() const
+{
+	client.stopSimulation();
+}
+
+int SocketTransport::getIntegerSignal(const std::string& name) const
+{
+	return client.getIntegerSignal(name);
+}
+
+void SocketTransport::setIntegerSignal(const std::string& name, int value) const
+{
+	client.setIntegerSignal(name, value);
+}
+
+int SocketTransport::getObjectHandle(const std::string& name) const
+{
+	return client.getObjectHandle(name);
+}
+
+Pose SocketTransport::getObjectPose(int handle) const
+{
+	const coppeliasim_cpp::Pose pose = client.getObjectPose(handle);
+	return { {pose.position.x, pose.position.y, pose.position.z},
+		{pose.orientation.alpha, pose.orientation.beta, pose.orientation.gamma} };
+}
+
+SharedMemoryTransport::SharedMemoryTransport(std::string name)
+	: name(std::move(name)), region(nullptr)
+{}
+
+bool SharedMemoryTransport::initialize()
+{
+	if (region == nullptr)
+	{
+		if (!memory.open(name, sizeof(SharedSignalRegion)))
+			return false;
+		region = static_cast<SharedSignalRegion*>(memory.data());
+		region->initialize();
+		if (!region->isValid())
+		{
+			memory.close();
+			region = nullptr;
+			return false;
+		}
+	}
+	return isConnected();
+}
+
+bool SharedMemoryTransport::isConnected() const
+{
+	return region != nullptr && region->peerAttached.load(std::memory_order_acquire) != 0;
+}
+
+void SharedMemoryTransport::startSimulation() const
+{
+	region->simulationRequested.store(1, std::memory_order_release);
+}
+
+void SharedMemoryTransport::stopSimulation() const
+{
+	region->simulationRequested.store(0, std::memory_order_release);
+}
+
+SharedSignalRegion::SignalSlot* SharedMemoryTransport::findSignal(const std::string& signalName) const
+{
+	const auto it = signalSlots.find(signalName);
+	if (it != signalSlots.end())
+		return it->second;
+	SharedSignalRegion::SignalSlot* slot = region->signal(signalName.c_str());
+	if (slot != nullptr)
+		signalSlots.emplace(signalName, slot);
+	return slot;
+}
+
+int SharedMemoryTransport::getIntegerSignal(const std::string& signalName) const
+{
+	const SharedSignalRegion::SignalSlot* slot = findSignal(signalName);
+	return slot != nullptr ? slot->value.load(std::memory_order_acquire) : 0;
+}
+
+void SharedMemoryTransport::setIntegerSignal(const std::string& signalName, int value) const
+{
+	if (SharedSignalRegion::SignalSlot* slot = findSignal(signalName))
+		slot->value.store(value, std::memory_order_release);
+}
+
+int SharedMemoryTransport::getObjectHandle(const std::string& objectName) const
+{
+	const SharedSignalRegion::ObjectSlot* slot = region->object(objectName.c_str());
+	if (slot == nullptr)
+		return -1;
+	return static_cast<int>(slot - region->objects);
+}
+
+Pose SharedMemoryTransport::getObjectPose(int handle) const
+{
+	if (handle < 0 || handle >= SharedSignalRegion::MAX_OBJECTS)
+		return {};
+	double values[6];
+	SharedSignalRegion::readPose(region->objects[handle], values);
+	return { {values[0], values[1], values[2]}, {values[3], values[4], values[5]} };
+}
+
+const std::atomic<uint32_t>* SharedMemoryTransport::getUpdateDoorbell() const
+{
+	return region != nullptr ? &region->doorbell : nullptr;
+}
+
+std::unique_ptr<CoppeliasimTransport> createCoppeliasimTransport(const TransportParameters& parameters, int port)
+{
+	std::unique_ptr<CoppeliasimTransport> transport;
+	switch (parameters.type)
+	{
+	case TransportType::SHARED_MEMORY:
+		transport = std::make_unique<SharedMemoryTransport>(parameters.sharedMemoryName);
+		break;
+	case TransportType::REPLAY:
+		transport = std::make_unique<ReplayTransport>(parameters.replayFile, parameters.replaySpeed);
+		break;
+	case TransportType::SOCKET:
+	default:
+		transport = std::make_unique<SocketTransport>(parameters.host, port);
+		break;
+	}
+	if (parameters.recordTraffic && parameters.type != TransportType::REPLAY)
+		transport = std::make_unique<RecordingTransport>(std::move(transport));
+	return transport;
+}
@@ -0,0 +1,108 @@
+#include "coroutine_executor.h"
+
+#include <algorithm>
+
+Coroutine& Coroutine::operator=(Coroutine&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (handle)
+			handle.destroy();
+		handle = std::exchange(other.handle, {});
+	}
+	return *this;
+}
+
+Coroutine::~Coroutine()
+{
+	if (handle)
+		handle.destroy();
+}
+
+void Coroutine::rethrow() const
+{
+	if (handle && handle.promise().exception)
+		std::rethrow_exception(handle.promise().exception);
+}
+
+void Executor::spawn(Coroutine task)
+{
+	const auto handle = task.getHandle();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	post(handle);
+}
+
+void Executor::post(std::coroutine_handle<> handle)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready.push_back(handle);
+	}
+	wakeUp.notify_one();
+}
+
+void Executor::post(AsyncCondition& condition)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		notified.push_back(&condition);
+	}
+	wakeUp.notify_one();
+}
+
+void Executor::run()
+{
+	while (!areTasksDone())
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeUp.wait(lock, [this] { return !ready.empty() || !notified.empty(); });
+			// The queues keep their capacity, so a steady stream of posts does not allocate.
+			std::swap(ready, running);
+			std::swap(notified, checking);
+		}
+		// A waiter whose predicate holds is posted and resumed on the next pass.
+		for (AsyncCondition* condition : checking)
+			condition->check();
+		checking.clear();
+		for (const auto handle : running)
+			handle.resume();
+		running.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const auto& task : tasks)
+		task.rethrow();
+}
+
+bool Executor::areTasksDone()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::all_of(tasks.begin(), tasks.end(), [](const Coroutine& task) { return task.isDone(); });
+}
+
+void AsyncCondition::notify()
+{
+	if (!queued.exchange(true, std::memory_order_acq_rel))
+		executor.post(*this);
+}
+
+void AsyncCondition::check()
+{
+	// Cleared first: a notify() while the predicates run queues another check.
+	queued.store(false, std::memory_order_release);
+	auto waiter = waiters.begin();
+	while (waiter != waiters.end())
+	{
+		if (waiter->predicate())
+		{
+			executor.post(waiter->handle);
+			waiter = waiters.erase(waiter);
+		}
+		else
+			++waiter;
+	}
+}
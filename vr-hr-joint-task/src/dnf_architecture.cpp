@@ -1,17 +1,66 @@
 
 #include "dnf_architecture.h"
 
+#include <algorithm>
+#include <cmath>
 
+DnfElementDescription DnfElementDescription::field(const std::string& name, double tau, double restingLevel,
+	double xShift, double steepness, const std::vector<std::string>& inputs)
+{
+	DnfElementDescription element{ DnfElementType::NEURAL_FIELD, name, inputs };
+	element.tau = tau;
+	element.restingLevel = restingLevel;
+	element.xShift = xShift;
+	element.steepness = steepness;
+	return element;
+}
 
-std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandMotion(const std::string& id, const double& deltaT)
+DnfElementDescription DnfElementDescription::stimulus(const std::string& name, double sigma, double amplitude, double position)
 {
-	using namespace dnf_composer;
-	auto simulation = std::make_shared<Simulation>(id, deltaT, 0, 0);
+	DnfElementDescription element{ DnfElementType::GAUSS_STIMULUS, name, {} };
+	element.sigma = sigma;
+	element.amplitude = amplitude;
+	element.position = position;
+	return element;
+}
 
-	element::ElementFactory factory;
-	element::ElementSpatialDimensionParameters dim_params{ 50, 0.5 };
-	constexpr bool circularity = false;
-	constexpr bool normalization = false;
+DnfElementDescription DnfElementDescription::gaussKernel(const std::string& name, double sigma, double amplitude, const std::string& input)
+{
+	DnfElementDescription element{ DnfElementType::GAUSS_KERNEL, name, { input } };
+	element.sigma = sigma;
+	element.amplitude = amplitude;
+	return element;
+}
+
+DnfElementDescription DnfElementDescription::lateralInteractions(const std::string& name, double sigmaExcitatory, double amplitudeExcitatory,
+	double sigmaInhibitory, double amplitudeInhibitory, double amplitudeGlobal, const std::string& input)
+{
+	DnfElementDescription element{ DnfElementType::LATERAL_INTERACTIONS, name, { input } };
+	element.sigma = sigmaExcitatory;
+	element.amplitude = amplitudeExcitatory;
+	element.sigmaInhibitory = sigmaInhibitory;
+	element.amplitudeInhibitory = amplitudeInhibitory;
+	element.amplitudeGlobal = amplitudeGlobal;
+	return element;
+}
+
+DnfElementDescription DnfElementDescription::noise(const std::string& name, double amplitude)
+{
+	DnfElementDescription element{ DnfElementType::NORMAL_NOISE, name, {} };
+	element.amplitude = amplitude;
+	return element;
+}
+
+const DnfElementDescription* DnfArchitectureDescription::find(const std::string& name) const
+{
+	const auto it = std::find_if(elements.begin(), elements.end(),
+		[&name](const DnfElementDescription& element) { return element.name == name; });
+	return it == elements.end() ? nullptr : &*it;
+}
+
+DnfArchitectureDescription getDnfArchitectureDescription(DnfArchitectureType type)
+{
+	using Element = DnfElementDescription;
 	constexpr double tau = 100;
 	constexpr double resting_level = -5;
 	constexpr double x_shift = 0;
@@ -20,270 +69,163 @@ std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandM
 	constexpr double stimulus_amplitude = 5;
 	constexpr double noise_amplitude = 0.001;
 
-	// Action observation layer
-	element::GaussStimulusParameters hand_position_gsp = { stimulus_sigma + 1, 0, 0, circularity, normalization };
-	const auto hand_position_stimulus = factory.createElement(element::GAUSS_STIMULUS, { "hand position stimulus", dim_params }, { hand_position_gsp });
-	simulation->addElement(hand_position_stimulus);
-
-	const element::SigmoidFunction aol_af = { x_shift, steepness };
-	element::NeuralFieldParameters aol_params = { tau, resting_level, aol_af };
-	const auto aol = factory.createElement(element::NEURAL_FIELD, { "aol", dim_params }, { aol_params });
-	simulation->addElement(aol);
-
-	element::GaussKernelParameters aol_aol_k_params = { 1, 1.5, circularity, normalization };
-	const auto aol_aol_k = factory.createElement(element::GAUSS_KERNEL, { "aol -> aol", dim_params }, { aol_aol_k_params });
-	simulation->addElement(aol_aol_k);
+	const bool handMotion = type == DnfArchitectureType::HAND_MOTION;
+	DnfArchitectureDescription description;
+	auto& elements = description.elements;
 
-	const element::NormalNoiseParameters aol_nn_params = { noise_amplitude };
-	const auto aol_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise aol", dim_params }, aol_nn_params);
-	simulation->addElement(aol_nn);
-
-	simulation->createInteraction("aol", "output", "aol -> aol");
-	simulation->createInteraction("aol -> aol", "output", "aol");
-	simulation->createInteraction("normal noise aol", "output", "aol");
-	simulation->createInteraction("hand position stimulus", "output", "aol");
+	// Action observation layer
+	std::vector<std::string> aolInputs = { "aol -> aol", "normal noise aol" };
+	if (handMotion)
+	{
+		elements.push_back(Element::stimulus("hand position stimulus", stimulus_sigma + 1, 0, 0));
+		aolInputs.emplace_back("hand position stimulus");
+	}
+	else
+	{
+		elements.push_back(Element::stimulus("hand position stimulus 3", stimulus_sigma, 0, 12.5));
+		elements.push_back(Element::stimulus("hand position stimulus 2", stimulus_sigma, 0, 25));
+		elements.push_back(Element::stimulus("hand position stimulus 1", stimulus_sigma, 0, 37.5));
+		aolInputs.insert(aolInputs.end(), { "hand position stimulus 3", "hand position stimulus 2", "hand position stimulus 1" });
+	}
+	elements.push_back(Element::field("aol", tau, resting_level, x_shift, steepness, aolInputs));
+	elements.push_back(Element::gaussKernel("aol -> aol", 1, 1.5, "aol"));
+	elements.push_back(Element::noise("normal noise aol", noise_amplitude));
 
 	// Action simulation layer
-	const element::SigmoidFunction asl_af = { x_shift, steepness };
-	element::NeuralFieldParameters asl_params = { tau, resting_level, asl_af };
-	const auto asl = factory.createElement(element::NEURAL_FIELD, { "asl", dim_params }, { asl_params });
-	simulation->addElement(asl);
-
-	element::LateralInteractionsParameters asl_asl_k_params = { 1, 2, 0.5, 1.5, -0.1, circularity, normalization };
-	const auto asl_asl_k = factory.createElement(element::LATERAL_INTERACTIONS, { "asl -> asl", dim_params }, { asl_asl_k_params });
-	simulation->addElement(asl_asl_k);
-
-	element::GaussKernelParameters aol_asl_k_params = { 2.4, 0.755, circularity, normalization };
-	const auto aol_asl_k = factory.createElement(element::GAUSS_KERNEL, { "aol -> asl", dim_params }, { aol_asl_k_params });
-	simulation->addElement(aol_asl_k);
-
-	const element::NormalNoiseParameters asl_nn_params = { noise_amplitude };
-	const auto asl_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise asl", dim_params }, asl_nn_params);
-	simulation->addElement(asl_nn);
-
-	simulation->createInteraction("asl", "output", "asl -> asl");
-	simulation->createInteraction("asl -> asl", "output", "asl");
-	simulation->createInteraction("normal noise asl", "output", "asl");
-
-	simulation->createInteraction("aol", "output", "aol -> asl");
-	simulation->createInteraction("aol -> asl", "output", "asl");
+	elements.push_back(Element::field("asl", tau, resting_level, x_shift, steepness,
+		{ "asl -> asl", "normal noise asl", "aol -> asl", "orl -> asl" }));
+	if (handMotion)
+		elements.push_back(Element::lateralInteractions("asl -> asl", 1, 2, 0.5, 1.5, -0.1, "asl"));
+	else
+		elements.push_back(Element::lateralInteractions("asl -> asl", 3.3, 5.626, 3.375, 5.03, -0.515, "asl"));
+	elements.push_back(Element::gaussKernel("aol -> asl", 2.4, 0.755, "aol"));
+	elements.push_back(Element::noise("normal noise asl", noise_amplitude));
 
 	// Object memory layer
-	element::GaussStimulusParameters orl_gsp = { stimulus_sigma, stimulus_amplitude, 12.5, circularity, normalization };
-	const auto orl_stimulus_1 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 3", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_1);
-
-	orl_gsp = { stimulus_sigma, stimulus_amplitude, 25, circularity, normalization };
-	const auto orl_stimulus_2 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 2", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_2);
-
-	orl_gsp = { stimulus_sigma, stimulus_amplitude, 37.5, circularity, normalization };
-	const auto orl_stimulus_3 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 1", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_3);
-
-	element::SigmoidFunction orl_af = { x_shift, steepness };
-	element::NeuralFieldParameters orl_params = { tau, resting_level, orl_af };
-	const auto orl = factory.createElement(element::NEURAL_FIELD, { "orl", dim_params }, { orl_params });
-	simulation->addElement(orl);
-
-	element::GaussKernelParameters orl_orl_k_params = { 1, 2, circularity, normalization };
-	const auto orl_orl_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> orl", dim_params }, { orl_orl_k_params });
-	simulation->addElement(orl_orl_k);
-
-	element::GaussKernelParameters orl_asl_k_params = { 1.9, 0.7, circularity, normalization };
-	const auto orl_asl_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> asl", dim_params }, { orl_asl_k_params });
-	simulation->addElement(orl_asl_k);
-
-	element::NormalNoiseParameters orl_nn_params = { noise_amplitude };
-	const auto orl_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise orl", dim_params }, orl_nn_params);
-	simulation->addElement(orl_nn);
-
-	simulation->createInteraction("orl", "output", "orl -> asl");
-	simulation->createInteraction("orl -> asl", "output", "asl");
-	simulation->createInteraction("orl", "output", "orl -> orl");
-	simulation->createInteraction("orl -> orl", "output", "orl");
-	simulation->createInteraction("normal noise orl", "output", "orl");
-	simulation->createInteraction("object stimulus 1", "output", "orl");
-	simulation->createInteraction("object stimulus 2", "output", "orl");
-	simulation->createInteraction("object stimulus 3", "output", "orl");
+	elements.push_back(Element::stimulus("object stimulus 3", stimulus_sigma, stimulus_amplitude, 12.5));
+	elements.push_back(Element::stimulus("object stimulus 2", stimulus_sigma, stimulus_amplitude, 25));
+	elements.push_back(Element::stimulus("object stimulus 1", stimulus_sigma, stimulus_amplitude, 37.5));
+	elements.push_back(Element::field("orl", tau, resting_level, x_shift, steepness,
+		{ "orl -> orl", "normal noise orl", "object stimulus 1", "object stimulus 2", "object stimulus 3" }));
+	elements.push_back(Element::gaussKernel("orl -> orl", 1, 2, "orl"));
+	elements.push_back(Element::gaussKernel("orl -> asl", 1.9, 0.7, "orl"));
+	elements.push_back(Element::noise("normal noise orl", noise_amplitude));
 
 	// Action execution layer
-	element::SigmoidFunction ael_af = { x_shift, steepness };
-	element::NeuralFieldParameters ael_params = { tau, resting_level, ael_af };
-	const auto ael = factory.createElement(element::NEURAL_FIELD, { "ael", dim_params }, { ael_params });
-	simulation->addElement(ael);
+	elements.push_back(Element::field("ael", handMotion ? tau : tau + 20, resting_level, x_shift, steepness,
+		{ "ael -> ael", "normal noise ael", "asl -> ael", "orl -> ael" }));
+	elements.push_back(Element::gaussKernel("asl -> ael", 1, -1.5, "asl"));
+	// deltaT = 10 Aexc=8.37, Ainh=5.677, Sinh=3.375, Sexc=4.75, Sself=-2.5
+	elements.push_back(Element::lateralInteractions("ael -> ael", 4.75, handMotion ? 8.143 : 8.37, 3.375, 5.677, -2.5, "ael"));
+	elements.push_back(Element::gaussKernel("orl -> ael", 2, 1.5, "orl"));
+	elements.push_back(Element::noise("normal noise ael", noise_amplitude));
 
-	element::GaussKernelParameters asl_ael_k_params = { 1, -1.5, circularity, normalization };
-	const auto asl_ael_k = factory.createElement(element::GAUSS_KERNEL, { "asl -> ael", dim_params }, { asl_ael_k_params });
-	simulation->addElement(asl_ael_k);
+	return description;
+}
 
-	// deltaT = 10 Aexc=8.37, Ainh=5.677, Sinh=3.375, Sexc=4.75, Sself=-2.5
-	element::LateralInteractionsParameters ael_ael_k_params = { 4.75, 8.143, 3.375, 5.677, -2.5, circularity, normalization };
-	const auto ael_ael_k = factory.createElement(element::LATERAL_INTERACTIONS, { "ael -> ael", dim_params }, { ael_ael_k_params });
-	simulation->addElement(ael_ael_k);
+const char* toString(DnfArchitectureType type)
+{
+	switch (type)
+	{
+	case DnfArchitectureType::HAND_MOTION: return "hand-motion";
+	case DnfArchitectureType::ACTION_LIKELIHOOD: return "action-likelihood";
+	}
+	return "unknown";
+}
 
-	element::GaussKernelParameters orl_ael_k_params = { 2, 1.5, circularity, normalization };
-	const auto orl_ael_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> ael", dim_params }, { orl_ael_k_params });
-	simulation->addElement(orl_ael_k);
+std::shared_ptr<dnf_composer::Simulation> createDnfComposerSimulation(const DnfArchitectureDescription& description,
+	const std::string& id, double deltaT)
+{
+	using namespace dnf_composer;
+	auto simulation = std::make_shared<Simulation>(id, deltaT, 0, 0);
 
-	element::NormalNoiseParameters ael_nn_params = { noise_amplitude };
-	const auto ael_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise ael", dim_params }, ael_nn_params);
-	simulation->addElement(ael_nn);
+	for (const auto& e : description.elements)
+		simulation->addElement(createDnfComposerElement(e, description));
 
-	simulation->createInteraction("ael", "output", "ael -> ael");
-	simulation->createInteraction("ael -> ael", "output", "ael");
-	simulation->createInteraction("normal noise ael", "output", "ael");
-	simulation->createInteraction("asl", "output", "asl -> ael");
-	simulation->createInteraction("asl -> ael", "output", "ael");
-	simulation->createInteraction("orl -> ael", "output", "ael");
-	simulation->createInteraction("orl", "output", "orl -> ael");
+	for (const auto& e : description.elements)
+		for (const auto& input : e.inputs)
+			simulation->createInteraction(input, "output", e.name);
 
 	return simulation;
 }
 
-std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActionLikelihood(const std::string& id, const double& deltaT)
+std::shared_ptr<dnf_composer::element::Element> createDnfComposerElement(const DnfElementDescription& e,
+	const DnfArchitectureDescription& description)
 {
 	using namespace dnf_composer;
-	auto simulation = std::make_shared<Simulation>(id, deltaT, 0, 0);
-
 	element::ElementFactory factory;
-	element::ElementSpatialDimensionParameters dim_params{ 50, 0.5 };
-	constexpr bool circularity = false;
+	element::ElementSpatialDimensionParameters dim_params{ description.xMax, description.dx };
+	const bool circularity = description.circular;
 	constexpr bool normalization = false;
-	constexpr double tau = 100;
-	constexpr double resting_level = -5;
-	constexpr double x_shift = 0;
-	constexpr double steepness = 4;
-	constexpr double stimulus_sigma = 3;
-	constexpr double stimulus_amplitude = 5;
-	constexpr double noise_amplitude = 0.001;
-
-	// Action observation layer
-	element::GaussStimulusParameters hand_position_gsp = { stimulus_sigma, 0, 12.5, circularity, normalization };
-	const auto hand_position_stimulus_3 = factory.createElement(element::GAUSS_STIMULUS, { "hand position stimulus 3", dim_params }, { hand_position_gsp });
-	simulation->addElement(hand_position_stimulus_3);
-
-	hand_position_gsp = { stimulus_sigma, 0, 25, circularity, normalization };
-	const auto hand_position_stimulus_2 = factory.createElement(element::GAUSS_STIMULUS, { "hand position stimulus 2", dim_params }, { hand_position_gsp });
-	simulation->addElement(hand_position_stimulus_2);
-
-	hand_position_gsp = { stimulus_sigma, 0, 37.5, circularity, normalization };
-	const auto hand_position_stimulus_1 = factory.createElement(element::GAUSS_STIMULUS, { "hand position stimulus 1", dim_params }, { hand_position_gsp });
-	simulation->addElement(hand_position_stimulus_1);
-
-	const element::SigmoidFunction aol_af = { x_shift, steepness };
-	element::NeuralFieldParameters aol_params = { tau, resting_level, aol_af };
-	const auto aol = factory.createElement(element::NEURAL_FIELD, { "aol", dim_params }, { aol_params });
-	simulation->addElement(aol);
-
-	element::GaussKernelParameters aol_aol_k_params = { 1, 1.5, circularity, normalization };
-	const auto aol_aol_k = factory.createElement(element::GAUSS_KERNEL, { "aol -> aol", dim_params }, { aol_aol_k_params });
-	simulation->addElement(aol_aol_k);
-
-	const element::NormalNoiseParameters aol_nn_params = { noise_amplitude };
-	const auto aol_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise aol", dim_params }, aol_nn_params);
-	simulation->addElement(aol_nn);
-
-	simulation->createInteraction("aol", "output", "aol -> aol");
-	simulation->createInteraction("aol -> aol", "output", "aol");
-	simulation->createInteraction("normal noise aol", "output", "aol");
-	simulation->createInteraction("hand position stimulus 3", "output", "aol");
-	simulation->createInteraction("hand position stimulus 2", "output", "aol");
-	simulation->createInteraction("hand position stimulus 1", "output", "aol");
-
-	// Action simulation layer
-	const element::SigmoidFunction asl_af = { x_shift, steepness };
-	element::NeuralFieldParameters asl_params = { tau, resting_level, asl_af };
-	const auto asl = factory.createElement(element::NEURAL_FIELD, { "asl", dim_params }, { asl_params });
-	simulation->addElement(asl);
-
-	element::LateralInteractionsParameters asl_asl_k_params = { 3.3, 5.626, 3.375, 5.03, -0.515, circularity, normalization };
-	const auto asl_asl_k = factory.createElement(element::LATERAL_INTERACTIONS, { "asl -> asl", dim_params }, { asl_asl_k_params });
-	simulation->addElement(asl_asl_k);
-
-	element::GaussKernelParameters aol_asl_k_params = { 2.4, 0.755, circularity, normalization };
-	const auto aol_asl_k = factory.createElement(element::GAUSS_KERNEL, { "aol -> asl", dim_params }, { aol_asl_k_params });
-	simulation->addElement(aol_asl_k);
-
-	const element::NormalNoiseParameters asl_nn_params = { noise_amplitude };
-	const auto asl_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise asl", dim_params }, asl_nn_params);
-	simulation->addElement(asl_nn);
-
-	simulation->createInteraction("asl", "output", "asl -> asl");
-	simulation->createInteraction("asl -> asl", "output", "asl");
-	simulation->createInteraction("normal noise asl", "output", "asl");
 
-	simulation->createInteraction("aol", "output", "aol -> asl");
-	simulation->createInteraction("aol -> asl", "output", "asl");
-
-	// Object memory layer
-	element::GaussStimulusParameters orl_gsp = { stimulus_sigma, stimulus_amplitude, 12.5, circularity, normalization };
-	const auto orl_stimulus_1 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 3", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_1);
-
-	orl_gsp = { stimulus_sigma, stimulus_amplitude, 25, circularity, normalization };
-	const auto orl_stimulus_2 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 2", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_2);
-
-	orl_gsp = { stimulus_sigma, stimulus_amplitude, 37.5, circularity, normalization };
-	const auto orl_stimulus_3 = factory.createElement(element::GAUSS_STIMULUS, { "object stimulus 1", dim_params }, { orl_gsp });
-	simulation->addElement(orl_stimulus_3);
-
-	element::SigmoidFunction orl_af = { x_shift, steepness };
-	element::NeuralFieldParameters orl_params = { tau, resting_level, orl_af };
-	const auto orl = factory.createElement(element::NEURAL_FIELD, { "orl", dim_params }, { orl_params });
-	simulation->addElement(orl);
-
-	element::GaussKernelParameters orl_orl_k_params = { 1, 2, circularity, normalization };
-	const auto orl_orl_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> orl", dim_params }, { orl_orl_k_params });
-	simulation->addElement(orl_orl_k);
-
-	element::GaussKernelParameters orl_asl_k_params = { 1.9, 0.7, circularity, normalization };
-	const auto orl_asl_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> asl", dim_params }, { orl_asl_k_params });
-	simulation->addElement(orl_asl_k);
-
-	element::NormalNoiseParameters orl_nn_params = { noise_amplitude };
-	const auto orl_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise orl", dim_params }, orl_nn_params);
-	simulation->addElement(orl_nn);
-
-	simulation->createInteraction("orl", "output", "orl -> asl");
-	simulation->createInteraction("orl -> asl", "output", "asl");
-	simulation->createInteraction("orl", "output", "orl -> orl");
-	simulation->createInteraction("orl -> orl", "output", "orl");
-	simulation->createInteraction("normal noise orl", "output", "orl");
-	simulation->createInteraction("object stimulus 1", "output", "orl");
-	simulation->createInteraction("object stimulus 2", "output", "orl");
-	simulation->createInteraction("object stimulus 3", "output", "orl");
-
-	// Action execution layer
-	element::SigmoidFunction ael_af = { x_shift, steepness };
-	element::NeuralFieldParameters ael_params = { tau+20, resting_level, ael_af };
-	const auto ael = factory.createElement(element::NEURAL_FIELD, { "ael", dim_params }, { ael_params });
-	simulation->addElement(ael);
-
-	element::GaussKernelParameters asl_ael_k_params = { 1, -1.5, circularity, normalization };
-	const auto asl_ael_k = factory.createElement(element::GAUSS_KERNEL, { "asl -> ael", dim_params }, { asl_ael_k_params });
-	simulation->addElement(asl_ael_k);
-
-	element::LateralInteractionsParameters ael_ael_k_params = { 4.75, 8.37, 3.375, 5.677, -2.5, circularity, normalization };
-	const auto ael_ael_k = factory.createElement(element::LATERAL_INTERACTIONS, { "ael -> ael", dim_params }, { ael_ael_k_params });
-	simulation->addElement(ael_ael_k);
-
-	element::GaussKernelParameters orl_ael_k_params = { 2, 1.5, circularity, normalization };
-	const auto orl_ael_k = factory.createElement(element::GAUSS_KERNEL, { "orl -> ael", dim_params }, { orl_ael_k_params });
-	simulation->addElement(orl_ael_k);
+	switch (e.type)
+	{
+	case DnfElementType::NEURAL_FIELD:
+	{
+		const element::SigmoidFunction af = { e.xShift, e.steepness };
+		const element::NeuralFieldParameters params = { e.tau, e.restingLevel, af };
+		return factory.createElement(element::NEURAL_FIELD, { e.name, dim_params }, { params });
+	}
+	case DnfElementType::GAUSS_STIMULUS:
+	{
+		const element::GaussStimulusParameters params = { e.sigma, e.amplitude, e.position, circularity, normalization };
+		return factory.createElement(element::GAUSS_STIMULUS, { e.name, dim_params }, { params });
+	}
+	case DnfElementType::GAUSS_KERNEL:
+	{
+		const element::GaussKernelParameters params = { e.sigma, e.amplitude, circularity, normalization };
+		return factory.createElement(element::GAUSS_KERNEL, { e.name, dim_params }, { params });
+	}
+	case DnfElementType::LATERAL_INTERACTIONS:
+	{
+		const element::LateralInteractionsParameters params = { e.sigma, e.amplitude,
+			e.sigmaInhibitory, e.amplitudeInhibitory, e.amplitudeGlobal, circularity, normalization };
+		return factory.createElement(element::LATERAL_INTERACTIONS, { e.name, dim_params }, { params });
+	}
+	case DnfElementType::NORMAL_NOISE:
+	{
+		const element::NormalNoiseParameters params = { e.amplitude };
+		return factory.createElement(element::NORMAL_NOISE, { e.name, dim_params }, params);
+	}
+	}
+	return nullptr;
+}
 
-	element::NormalNoiseParameters ael_nn_params = { noise_amplitude };
-	const auto ael_nn = factory.createElement(element::NORMAL_NOISE, { "normal noise ael", dim_params }, ael_nn_params);
-	simulation->addElement(ael_nn);
+std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureHandMotion(const std::string& id, const double& deltaT)
+{
+	return createDnfComposerSimulation(getDnfArchitectureDescription(DnfArchitectureType::HAND_MOTION), id, deltaT);
+}
 
-	simulation->createInteraction("ael", "output", "ael -> ael");
-	simulation->createInteraction("ael -> ael", "output", "ael");
-	simulation->createInteraction("normal noise ael", "output", "ael");
-	simulation->createInteraction("asl", "output", "asl -> ael");
-	simulation->createInteraction("asl -> ael", "output", "ael");
-	simulation->createInteraction("orl -> ael", "output", "ael");
-	simulation->createInteraction("orl", "output", "orl -> ael");
+std::shared_ptr<dnf_composer::Simulation> getDynamicNeuralFieldArchitectureActionLikelihood(const std::string& id, const double& deltaT)
+{
+	return createDnfComposerSimulation(getDnfArchitectureDescription(DnfArchitectureType::ACTION_LIKELIHOOD), id, deltaT);
+}
 
-	return simulation;
+int getTargetObjectFromCentroid(double centroid, double fieldLength)
+{
+	if (centroid < 0)
+		return 0;
+
+	// Function to calculate the circular distance between two points
+	auto circularDistance = [fieldLength](double point1, double point2) -> double {
+		const double directDistance = std::abs(point1 - point2);
+		const double circularDistance = fieldLength - directDistance;
+		return std::min(directDistance, circularDistance);
+		};
+
+	// Calculate distances to the three points
+	const double distanceToObject1 = circularDistance(centroid, 37.5);
+	const double distanceToObject2 = circularDistance(centroid, 25);
+	const double distanceToObject3 = circularDistance(centroid, 12.5);
+
+	// Determine the closest target and return the corresponding value
+	const double minDistance = std::min({ distanceToObject1, distanceToObject2, distanceToObject3 });
+
+	if (minDistance == distanceToObject1)
+		return 1;
+	if (minDistance == distanceToObject2)
+		return 2;
+	if (minDistance == distanceToObject3)
+		return 3;
+	return 0;
 }
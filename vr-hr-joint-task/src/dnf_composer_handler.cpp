@@ -1,19 +1,33 @@
 #include "dnf_composer_handler.h"
 
-DnfComposerHandler::DnfComposerHandler(DnfArchitectureType dnf, double deltaT)
+#include <algorithm>
+
+#include <tools/logger.h>
+
+#include "startup_profile.h"
+
+DnfComposerHandler::DnfComposerHandler(DnfArchitectureType dnf, double deltaT,
+	const FieldRecorderParameters& recorderParameters, const SimulationLoopParameters& loopParameters,
+	const BumpDetectorParameters& decisionParameters, const FieldReadoutParameters& readoutParameters)
 	: dnf(dnf)
+	, deltaT(deltaT)
+	, recorderParameters(recorderParameters)
+	, decisionParameters(decisionParameters)
+	, readoutParameters(readoutParameters)
+	, loopParameters(loopParameters)
+	, stopRequested(false)
+	, simulationLoopMeter(Metrics::loop("loop.simulation"))
+	, userInterfaceLoopMeter(Metrics::loop("loop.ui"))
+	, stepTime(Metrics::histogram("dnf.step"))
+	, inputAge(Metrics::histogram("dnf.inputAge"))
+	, parameterApply(Metrics::histogram("parameters.apply"))
+	, encoder(dnf, getDnfArchitectureDescription(dnf))
+	, appliedInputFrame(0)
+	, targetObject(0)
+	, buildDescription(getDnfArchitectureDescription(dnf))
+	, updatePending(false)
+	, likelihoodPending(false)
 {
-	switch (dnf)
-	{
-	case DnfArchitectureType::HAND_MOTION:
-		simulation = getDynamicNeuralFieldArchitectureHandMotion("dnf arch", deltaT);
-		break;
-	case DnfArchitectureType::ACTION_LIKELIHOOD:
-		simulation = getDynamicNeuralFieldArchitectureActionLikelihood("dnf arch", deltaT);
-		break;
-	}
-	application = std::make_shared<dnf_composer::Application>(simulation);
-	setupUserInterface();
 }
 
 DnfComposerHandler::~DnfComposerHandler()
@@ -23,196 +37,362 @@ DnfComposerHandler::~DnfComposerHandler()
 
 void DnfComposerHandler::init()
 {
-	simulationThread = std::thread(&DnfComposerHandler::run, this);
+	if (!simulation)
+		build();
+	stopRequested = false;
+	appliedInputFrame = 0;
+	decisionDetector.reset();
+	targetObject = 0;
+	simulationThread = std::thread(&DnfComposerHandler::runSimulation, this);
+	if (loopParameters.userInterface)
+		userInterfaceThread = std::thread(&DnfComposerHandler::runUserInterface, this);
 }
 
-void DnfComposerHandler::run() const
+void DnfComposerHandler::runSimulation()
 {
-	application->init();
-	bool userRequestedExit = false;
-	while (!userRequestedExit)
+	using Clock = std::chrono::steady_clock;
+
+	ThreadLayout::applyToCurrentThread("simulation");
+	{
+		const StartupPhase phase("simulationInit");
+		simulation->init();
+	}
+	std::unique_ptr<ParallelStepper> stepper;
+	if (loopParameters.stepWorkers > 1)
+	{
+		stepper = std::make_unique<ParallelStepper>(simulation, loopParameters.stepWorkers);
+		stepper->start();
+		EventLogger::log(LogLevel::CONTROL, "Parallel stepping: " + std::to_string(stepper->getGraph().getElementCount())
+			+ " elements in " + std::to_string(stepper->getGraph().getLevelCount()) + " levels on "
+			+ std::to_string(stepper->getWorkerCount()) + " workers.");
+		log(dnf_composer::tools::logger::LogLevel::INFO, "Step graph:\n" + stepper->getGraph().toString());
+	}
+	if (recorder && !recorder->start(simulation, EventLogger::getSessionDirectory()))
+		recorder.reset();
+	if (readout && !readout->start(simulation))
+		readout.reset();
+	const std::vector<double>* actionExecutionActivation = simulation->getComponentPtr("ael", "activation");
+	const double actionExecutionStep = actionExecutionField->getStepSize();
+
+	const auto start = Clock::now();
+	auto nextStep = start;
+	uint64_t step = 0;
+	while (!stopRequested.load(std::memory_order_relaxed))
 	{
+		simulationLoopMeter.tick();
+		applyArchitectureUpdate();
+		applyInputs();
+		{
+			const ScopedTimer timer(stepTime);
+			if (stepper)
+				stepper->step();
+			else
+				simulation->step();
+		}
+		DecisionEvent event;
+		if (decisionDetector.update(actionExecutionActivation->data(), static_cast<int>(actionExecutionActivation->size()),
+			actionExecutionStep, step, event))
+		{
+			event.inputFrame = appliedInputFrame;
+			targetObject.store(event.object, std::memory_order_relaxed);
+			decisionEvents.push(event);
+			if (decisionListener)
+				decisionListener();
+		}
+		if (readout)
+			readout->publish(step, appliedInputFrame, decisionDetector.getDecision(), decisionDetector.getBump());
+		snapshot->publish(step++);
+		if (step == 1)
+			StartupProfile::milestone("firstStep");
+		if (recorder)
+			recorder->capture(std::chrono::duration<double>(Clock::now() - start).count(), appliedInputFrame);
+
+		if (loopParameters.stepPeriod.count() > 0)
+		{
+			nextStep += loopParameters.stepPeriod;
+			const auto now = Clock::now();
+			if (nextStep > now)
+				std::this_thread::sleep_until(nextStep);
+			else
+				nextStep = now; // overran: resume the cadence instead of stepping in a burst
+		}
+	}
+	if (stepper)
+		stepper->stop();
+	if (recorder)
+		recorder->stop();
+	if (readout)
+		readout->stop();
+	simulation->close();
+}
+
+void DnfComposerHandler::runUserInterface()
+{
+	using Clock = std::chrono::steady_clock;
+
+	ThreadLayout::applyToCurrentThread("ui");
+	{
+		// Built here rather than in init(), so the first step does not wait for the windows.
+		const StartupPhase phase("ui");
+		setupUserInterface();
+		application->init();
+	}
+
+	const auto framePeriod = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(1.0 / std::max(1.0, loopParameters.uiFrameRate)));
+	auto nextFrame = Clock::now();
+	while (!application->getCloseUI())
+	{
+		userInterfaceLoopMeter.tick();
+		// Steps only the display elements, which copy the latest snapshot, then renders.
+		snapshot->acquire();
 		application->step();
-		userRequestedExit = application->getCloseUI();
+
+		nextFrame += framePeriod;
+		const auto now = Clock::now();
+		if (nextFrame > now)
+			std::this_thread::sleep_until(nextFrame);
+		else
+			nextFrame = now;
 	}
 	application->close();
+	stopRequested = true;
+	if (decisionListener)
+		decisionListener();
 }
 
 void DnfComposerHandler::end()
 {
-	simulationThread.join();
+	if (userInterfaceThread.joinable())
+		userInterfaceThread.join();
+	stopRequested = true;
+	if (simulationThread.joinable())
+		simulationThread.join();
 }
 
-void DnfComposerHandler::setHandStimulus(const Position& position, bool object1, bool object2, bool object3) const
+uint64_t DnfComposerHandler::setInputs(const Position& handPosition, bool object1, bool object2, bool object3)
 {
-	switch (dnf)
+	if (likelihoodPending.exchange(false, std::memory_order_acquire))
 	{
-	case DnfArchitectureType::HAND_MOTION:
-		setHandStimulusDependingOnHumanHandPosition(position);
-		break;
-	case DnfArchitectureType::ACTION_LIKELIHOOD:
-		setHandStimulusDependingOnHumanActionLikelihood(position, object1, object2, object3);
-		break;
+		std::lock_guard<std::mutex> lock(updateMutex);
+		encoder.setLikelihood(stagedLikelihood);
 	}
+	return inputs.publish(encoder.encode(handPosition, object1, object2, object3));
 }
 
-int DnfComposerHandler::getTargetObject() const
+uint64_t DnfComposerHandler::setObjects(bool object1, bool object2, bool object3)
 {
-	const auto ael = std::dynamic_pointer_cast<dnf_composer::element::NeuralField>(simulation->getElement("ael"));
-	const double centroid = ael->getCentroid();
-	if (centroid < 0)
-		return 0;
-
-	const int size = ael->getMaxSpatialDimension();
-
-	// Function to calculate the circular distance between two points
-	auto circularDistance = [size](double point1, double point2) -> double {
-		const double directDistance = std::abs(point1 - point2);
-		const double circularDistance = size - directDistance;
-		return std::min(directDistance, circularDistance);
-		};
-
-	// Calculate distances to the three points
-	double distanceToObject1 = circularDistance(centroid, 37.5);
-	double distanceToObject2 = circularDistance(centroid, 25);
-	double distanceToObject3 = circularDistance(centroid, 12.5);
-
-	// Determine the closest target and return the corresponding value
-	const double minDistance = std::min({ distanceToObject1, distanceToObject2, distanceToObject3 });
-
-	if (minDistance == distanceToObject1)
-		return 1;
-	if (minDistance == distanceToObject2)
-		return 2;
-	if (minDistance == distanceToObject3)
-		return 3;
-	return 0;
+	return inputs.publish(encoder.encodeObjects(object1, object2, object3));
 }
 
-void DnfComposerHandler::setAvailableObjectsInTheWorkspace(bool object1, bool object2, bool object3) const
+bool DnfComposerHandler::isLost() const
 {
-	auto orl_stimulus = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("object stimulus 1"));
-	auto orl_stimulus_parameters = orl_stimulus->getParameters();
-	double amplitude = object1 ? 1 : 0;
-	dnf_composer::element::GaussStimulusParameters new_params = { orl_stimulus_parameters.sigma, 5*amplitude, orl_stimulus_parameters.position, false, false };
-	orl_stimulus->setParameters(new_params);
-
-	orl_stimulus = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("object stimulus 2"));
-	orl_stimulus_parameters = orl_stimulus->getParameters();
-	amplitude = object2 ? 1 : 0;
-	new_params = { orl_stimulus_parameters.sigma, 5*amplitude, orl_stimulus_parameters.position, false, false };
-	orl_stimulus->setParameters(new_params);
-
-	orl_stimulus = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("object stimulus 3"));
-	orl_stimulus_parameters = orl_stimulus->getParameters();
-	amplitude = object3 ? 1 : 0;
-	new_params = { orl_stimulus_parameters.sigma, 5*amplitude, orl_stimulus_parameters.position, false, false };
-	orl_stimulus->setParameters(new_params);
+	return stopRequested.load(std::memory_order_relaxed);
 }
 
-void DnfComposerHandler::setHandStimulusDependingOnHumanActionLikelihood(const Position& position, bool object1, bool object2, bool object3) const
+int DnfComposerHandler::getTargetObject() const
 {
-	static Position handPrevious = position;
-	static const Position objPosition1 = { 0.000,  0.125, 0.716 };
-	static const Position objPosition2 = { 0.000,  0.000, 0.716 };
-	static const Position objPosition3 = { 0.000, -0.125, 0.716 };
-	static constexpr double tau = 0.1;
-	static constexpr double sigma = 0.05;
-	static constexpr double scalar = 5;
-
-	using Clock = std::chrono::high_resolution_clock;
-	auto lastTime = Clock::now();
-
-	const auto currentTime = Clock::now();
-	const std::chrono::duration<double> elapsed = currentTime - lastTime;
-	const double deltaTime = elapsed.count();
-
-	// Check if elapsed time is too small
-	if (deltaTime < std::numeric_limits<double>::epsilon())
-		return;
-
-	double likelihood_1 = calculateLikelihoodOfHumanAction(position, handPrevious, objPosition1, deltaTime, tau, sigma);
-	double likelihood_2 = calculateLikelihoodOfHumanAction(position, handPrevious, objPosition2, deltaTime, tau, sigma);
-	double likelihood_3 = calculateLikelihoodOfHumanAction(position, handPrevious, objPosition3, deltaTime, tau, sigma);
-
-	if (!object1)
-		likelihood_1 = 0.0;
-	if (!object2)
-		likelihood_2 = 0.0;
-	if (!object3)
-		likelihood_3 = 0.0;
-
-
-	const auto aol_stimulus_1 = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("hand position stimulus 1"));
-	const dnf_composer::element::GaussStimulusParameters new_params{ aol_stimulus_1->getParameters().sigma, scalar * likelihood_1, aol_stimulus_1->getParameters().position, false, false };
-	aol_stimulus_1->setParameters(new_params);
-
-	const auto aol_stimulus_2 = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("hand position stimulus 2"));
-	const dnf_composer::element::GaussStimulusParameters new_params_2{ aol_stimulus_2->getParameters().sigma, scalar * likelihood_2, aol_stimulus_2->getParameters().position, false, false };
-	aol_stimulus_2->setParameters(new_params_2);
-
-	const auto aol_stimulus_3 = std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("hand position stimulus 3"));
-	const dnf_composer::element::GaussStimulusParameters new_params_3{ aol_stimulus_3->getParameters().sigma, scalar * likelihood_3, aol_stimulus_3->getParameters().position, false, false };
-	aol_stimulus_3->setParameters(new_params_3);
-
-	handPrevious = position;
-	lastTime = currentTime;
+	return targetObject.load(std::memory_order_relaxed);
 }
 
-void DnfComposerHandler::setHandStimulusDependingOnHumanHandPosition(const Position& position) const
+void DnfComposerHandler::setDecisionListener(std::function<void()> listener)
 {
-	const auto aol_stimulus =
-		std::dynamic_pointer_cast<dnf_composer::element::GaussStimulus>(simulation->getElement("hand position stimulus"));
+	decisionListener = std::move(listener);
+}
 
-	const double proximity = calculateHandProximityToObjects(
-		calculateHandDistanceToObjects(position));
-	const double y = normalizeHandPosition(position.y);
+bool DnfComposerHandler::pollDecisionEvent(DecisionEvent& event)
+{
+	return decisionEvents.pop(event);
+}
 
-	const dnf_composer::element::GaussStimulusParameters new_params{ aol_stimulus->getParameters().sigma, proximity, y, false, false };
-	aol_stimulus->setParameters(new_params);
+uint64_t DnfComposerHandler::getDecisionCount() const
+{
+	return decisionEvents.getPushedCount();
 }
 
-double DnfComposerHandler::calculateHandDistanceToObjects(const Position& position)
+void DnfComposerHandler::stageArchitectureUpdate(std::shared_ptr<const ArchitectureUpdate> update)
 {
-	// Table center and dimensions
-	static constexpr double tableCenterX = 0.0;
-	static constexpr double tableCenterZ = 0.641 + 0.08;
+	std::shared_ptr<PreparedUpdate> retired;
+	{
+		// Held while the kernels are built; the simulation thread only ever tries the lock.
+		std::lock_guard<std::mutex> lock(updateMutex);
+		retired = std::move(retiredUpdate);
+		if (update->likelihoodChanged)
+		{
+			stagedLikelihood = update->likelihood;
+			likelihoodPending.store(true, std::memory_order_release);
+		}
+		if (!simulation)
+		{
+			buildDescription = update->description;
+			return;
+		}
+
+		auto prepared = std::make_shared<PreparedUpdate>();
+		for (const int index : update->changedElements)
+		{
+			const KernelWiring& wiring = kernelWiring[index];
+			if (!wiring.source)
+				continue;
+			auto element = createDnfComposerElement(update->description.elements[index], update->description);
+			element->addInput(wiring.source, "output");
+			element->init();
+			prepared->push_back({ index, std::move(element) });
+		}
+		if (!prepared->empty())
+		{
+			// Changes are relative to the previous update; if that one has not been applied
+			// yet, this one has to carry its kernels as well.
+			if (pendingUpdate)
+			{
+				for (const PreparedKernel& kernel : *pendingUpdate)
+					if (std::none_of(prepared->begin(), prepared->end(),
+						[&](const PreparedKernel& other) { return other.index == kernel.index; }))
+						prepared->push_back(kernel);
+				retired = std::move(pendingUpdate);
+			}
+			pendingUpdate = std::move(prepared);
+			updatePending.store(true, std::memory_order_release);
+		}
+	}
+	// The update the simulation let go of last time, with the kernels it replaced, is freed
+	// here, off the stepping thread.
+}
 
-	const double distanceX = std::abs(position.x - tableCenterX);
-	const double distanceZ = std::abs(position.z - tableCenterZ);
-	const double distance = std::sqrt(distanceX * distanceX + distanceZ * distanceZ);
+void DnfComposerHandler::applyArchitectureUpdate()
+{
+	if (!updatePending.load(std::memory_order_acquire))
+		return;
+	std::unique_lock<std::mutex> lock(updateMutex, std::try_to_lock);
+	if (!lock.owns_lock())
+		return; // the watcher is staging; take the update at the next step
+	std::shared_ptr<PreparedUpdate> update = std::move(pendingUpdate);
+	updatePending.store(false, std::memory_order_relaxed);
+	if (!update)
+		return;
 
-	return distance;
+	// The watcher logged the update when it staged it. Swapping an element costs one output
+	// copy and reconnecting its consumers; the taps were sampled when the watcher built it.
+	const auto begin = std::chrono::steady_clock::now();
+	auto& elements = simulation->elements;
+	for (PreparedKernel& kernel : *update)
+	{
+		std::shared_ptr<dnf_composer::element::Element>& current = elements[kernel.index];
+		// Consumers stepped before the kernel read its output of the previous step.
+		const std::vector<double>& output = *current->getComponentPtr("output");
+		std::copy(output.begin(), output.end(), kernel.element->getComponentPtr("output")->begin());
+		const KernelWiring& wiring = kernelWiring[kernel.index];
+		for (const auto& consumer : wiring.consumers)
+		{
+			consumer->removeInput(wiring.name);
+			consumer->addInput(kernel.element, "output");
+		}
+		std::swap(current, kernel.element);
+	}
+	parameterApply.record(std::chrono::steady_clock::now() - begin);
+	// Every staging takes the retired update first, so the slot is empty here.
+	retiredUpdate = std::move(update);
 }
 
-double DnfComposerHandler::calculateHandProximityToObjects(double distance)
+void DnfComposerHandler::applyInputs()
 {
-	// Ensure distance is always greater than zero to avoid division by zero
-	static constexpr double safeZone = 0.01;
-	distance = std::max(distance, safeZone);
-	return 1.0 / distance;
+	if (!inputs.acquire())
+		return;
+	const InputFrame& frame = inputs.get();
+	inputAge.record(InputFrame::Clock::now() - frame.published);
+	appliedInputFrame = frame.sequence;
+
+	const auto setStimulus = [](const std::shared_ptr<dnf_composer::element::GaussStimulus>& stimulus, double amplitude, double position) {
+		const auto parameters = stimulus->getParameters();
+		stimulus->setParameters({ parameters.sigma, amplitude, position, false, false });
+	};
+	switch (dnf)
+	{
+	case DnfArchitectureType::HAND_MOTION:
+		setStimulus(handStimulus, frame.hand[0].amplitude, frame.hand[0].position);
+		break;
+	case DnfArchitectureType::ACTION_LIKELIHOOD:
+		for (size_t i = 0; i < handStimuli.size(); ++i)
+			setStimulus(handStimuli[i], frame.hand[i].amplitude, frame.hand[i].position);
+		break;
+	}
+	for (size_t i = 0; i < objectStimuli.size(); ++i)
+	{
+		const double amplitude = frame.objectPresent[i] ? 1 : 0;
+		setStimulus(objectStimuli[i], 5 * amplitude, objectStimuli[i]->getParameters().position);
+	}
 }
 
-double DnfComposerHandler::normalizeHandPosition(double handPositionY)
+void DnfComposerHandler::build()
 {
-	// Define the min and max of the table in Y dimension
-	static constexpr double yMin = -0.25;
-	static constexpr double yMax = 0.25;
-	// Define the min and max of the scale
-	static constexpr double scaleMin = 0;
-	static constexpr double scaleMax = 50;
-
-	// Normalize posY to the 0-50 scale
-	const double normalizedScale = scaleMin + (scaleMax - scaleMin) * (handPositionY - yMin) / (yMax - yMin);
+	const StartupPhase phase("architecture");
+	{
+		std::lock_guard<std::mutex> lock(updateMutex);
+		simulation = createDnfComposerSimulation(buildDescription, "dnf arch", deltaT);
+		resolveElements();
+	}
+	decisionDetector = BumpDetector(decisionParameters, false, actionExecutionField->getMaxSpatialDimension());
+	// The snapshot sources are fixed before either thread starts; the display side of the
+	// snapshot is built by the UI thread.
+	snapshot = std::make_shared<FieldSnapshot>();
+	for (const char* field : { "aol", "asl", "orl", "ael" })
+		for (const char* component : { "activation", "input", "output" })
+			snapshot->addSource(simulation, field, component);
+	if (recorderParameters.enabled)
+		recorder = std::make_unique<FieldRecorder>(recorderParameters);
+	if (readoutParameters.enabled)
+		readout = std::make_unique<FieldPublisher>(readoutParameters);
+}
 
-	return normalizedScale;
+void DnfComposerHandler::resolveElements()
+{
+	using namespace dnf_composer::element;
+	const auto stimulus = [this](const std::string& name) {
+		return std::dynamic_pointer_cast<GaussStimulus>(simulation->getElement(name));
+	};
+
+	actionExecutionField = std::dynamic_pointer_cast<NeuralField>(simulation->getElement("ael"));
+	const DnfArchitectureDescription& description = buildDescription;
+	kernelWiring.assign(description.elements.size(), {});
+	for (size_t i = 0; i < description.elements.size(); ++i)
+	{
+		const DnfElementDescription& element = description.elements[i];
+		if (element.type != DnfElementType::GAUSS_KERNEL && element.type != DnfElementType::LATERAL_INTERACTIONS)
+			continue;
+		KernelWiring& wiring = kernelWiring[i];
+		wiring.name = element.name;
+		wiring.source = simulation->getElement(element.inputs.front());
+		for (const DnfElementDescription& other : description.elements)
+			if (std::find(other.inputs.begin(), other.inputs.end(), element.name) != other.inputs.end())
+				wiring.consumers.push_back(simulation->getElement(other.name));
+	}
+	for (size_t i = 0; i < objectStimuli.size(); ++i)
+		objectStimuli[i] = stimulus("object stimulus " + std::to_string(i + 1));
+	switch (dnf)
+	{
+	case DnfArchitectureType::HAND_MOTION:
+		handStimulus = stimulus("hand position stimulus");
+		break;
+	case DnfArchitectureType::ACTION_LIKELIHOOD:
+		for (size_t i = 0; i < handStimuli.size(); ++i)
+			handStimuli[i] = stimulus("hand position stimulus " + std::to_string(i + 1));
+		break;
+	}
 }
 
-void DnfComposerHandler::setupUserInterface() const
+void DnfComposerHandler::setupUserInterface()
 {
 	using namespace dnf_composer;
 	element::ElementSpatialDimensionParameters dim_params{ 50, 0.5 };
 
+	// The plot windows render display elements fed from a snapshot of the live fields,
+	// so rendering never touches the simulation while it steps.
+	displaySimulation = std::make_shared<Simulation>("dnf display", 1.0, 0, 0);
+	for (const char* field : { "aol", "asl", "orl", "ael" })
+		displaySimulation->addElement(std::make_shared<SnapshotElement>(
+			element::ElementCommonParameters{ field, dim_params }, snapshot));
+	application = std::make_shared<Application>(displaySimulation);
+
 	// Create User Interface windows
 	//application->activateUserInterfaceWindow(user_interface::SIMULATION_WINDOW);
 	//application->activateUserInterfaceWindow(user_interface::LOG_WINDOW);
@@ -227,7 +407,7 @@ void DnfComposerHandler::setupUserInterface() const
 	aolPlotParameters.annotations = { "Action observation layer", "Spatial dimension", "Amplitude" };
 	aolPlotParameters.dimensions = { 0, dim_params.x_max, -yMin, yMax + 10, dim_params.d_x };
 	aolPlotParameters.renderDataSelector = false;
-	const auto aolPlotWindow = std::make_shared<user_interface::PlotWindow>(simulation, aolPlotParameters);
+	const auto aolPlotWindow = std::make_shared<user_interface::PlotWindow>(displaySimulation, aolPlotParameters);
 	aolPlotWindow->addPlottingData("aol", "activation");
 	aolPlotWindow->addPlottingData("aol", "input");
 	aolPlotWindow->addPlottingData("aol", "output");
@@ -237,7 +417,7 @@ void DnfComposerHandler::setupUserInterface() const
 	aslPlotParameters.annotations = { "Action simulation layer", "Spatial dimension", "Amplitude" };
 	aslPlotParameters.dimensions = { 0, dim_params.x_max, -yMin, yMax, dim_params.d_x };
 	aslPlotParameters.renderDataSelector = false;
-	const auto aslPlotWindow = std::make_shared<user_interface::PlotWindow>(simulation, aslPlotParameters);
+	const auto aslPlotWindow = std::make_shared<user_interface::PlotWindow>(displaySimulation, aslPlotParameters);
 	aslPlotWindow->addPlottingData("asl", "activation");
 	aslPlotWindow->addPlottingData("asl", "input");
 	aslPlotWindow->addPlottingData("asl", "output");
@@ -247,7 +427,7 @@ void DnfComposerHandler::setupUserInterface() const
 	orlPlotParameters.annotations = { "Object representation layer", "Spatial dimension", "Amplitude" };
 	orlPlotParameters.dimensions = { 0, dim_params.x_max, -yMin, yMax, dim_params.d_x };
 	orlPlotParameters.renderDataSelector = false;
-	const auto orlPlotWindow = std::make_shared<user_interface::PlotWindow>(simulation, orlPlotParameters);
+	const auto orlPlotWindow = std::make_shared<user_interface::PlotWindow>(displaySimulation, orlPlotParameters);
 	orlPlotWindow->addPlottingData("orl", "activation");
 	orlPlotWindow->addPlottingData("orl", "input");
 	orlPlotWindow->addPlottingData("orl", "output");
@@ -257,7 +437,7 @@ void DnfComposerHandler::setupUserInterface() const
 	aelPlotParameters.annotations = { "Action execution layer", "Spatial dimension", "Amplitude" };
 	aelPlotParameters.dimensions = { 0, dim_params.x_max, -yMin - 20, yMax, dim_params.d_x };
 	aelPlotParameters.renderDataSelector = false;
-	const auto aelPlotWindow = std::make_shared<user_interface::PlotWindow>(simulation, aelPlotParameters);
+	const auto aelPlotWindow = std::make_shared<user_interface::PlotWindow>(displaySimulation, aelPlotParameters);
 	aelPlotWindow->addPlottingData("ael", "activation");
 	aelPlotWindow->addPlottingData("ael", "input");
 	aelPlotWindow->addPlottingData("ael", "output");
@@ -0,0 +1,79 @@
+// Out-of-process DNF engine: steps the architecture on a FieldEngine and talks to the
+// experiment through shared memory (see include/remote_dnf_engine.h). Start it before or
+// after the experiment, which selects it with DnfEngineLocation::OUT_OF_PROCESS.
+//
+// Usage: vr-hr-joint-task-dnf-engine [--architecture hand-motion|action-likelihood]
+//        [--precision double|float|mixed] [--delta-t 65] [--step-period microseconds]
+//        [--name shared-memory-name] [--thread-layout file] [--stats directory]
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "remote_dnf_engine.h"
+#include "thread_layout.h"
+
+namespace
+{
+	std::atomic<bool> stopRequested{ false };
+
+	void requestStop(int)
+	{
+		stopRequested = true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	DnfEngineServerParameters parameters;
+	std::string threadLayoutFile = std::string(PROJECT_DIR) + "/resources/thread-layout.json";
+	std::string statsDirectory;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--architecture" && hasValue)
+			parameters.architecture = std::string(argv[++i]) == "action-likelihood" ? DnfArchitectureType::ACTION_LIKELIHOOD : DnfArchitectureType::HAND_MOTION;
+		else if (argument == "--precision" && hasValue)
+		{
+			const std::string precision = argv[++i];
+			parameters.precision = precision == "float" ? FieldPrecision::FLOAT : precision == "mixed" ? FieldPrecision::MIXED : FieldPrecision::DOUBLE;
+		}
+		else if (argument == "--delta-t" && hasValue)
+			parameters.deltaT = std::atof(argv[++i]);
+		else if (argument == "--step-period" && hasValue)
+			parameters.stepPeriod = std::chrono::microseconds(std::max(0, std::atoi(argv[++i])));
+		else if (argument == "--name" && hasValue)
+			parameters.sharedMemoryName = argv[++i];
+		else if (argument == "--thread-layout" && hasValue)
+			threadLayoutFile = argv[++i];
+		else if (argument == "--stats" && hasValue)
+			statsDirectory = argv[++i];
+		else
+		{
+			std::cerr << "Unknown argument " << argument << std::endl;
+			return 2;
+		}
+	}
+
+	std::signal(SIGINT, requestStop);
+	std::signal(SIGTERM, requestStop);
+	ThreadLayout::load(threadLayoutFile);
+
+	DnfEngineServer server(parameters);
+	if (!server.open())
+		return 1;
+	if (!statsDirectory.empty())
+		Metrics::startExporter(statsDirectory);
+	std::cout << "DNF engine: " << toString(parameters.architecture) << " architecture in " << toString(parameters.precision)
+		<< ", deltaT " << parameters.deltaT << ", a step every " << parameters.stepPeriod.count() << " us on "
+		<< parameters.sharedMemoryName << "." << std::endl;
+	server.run(stopRequested);
+	if (!statsDirectory.empty())
+		Metrics::stopExporter();
+	std::cout << "DNF engine stopped." << std::endl;
+	return 0;
+}
@@ -1,67 +1,158 @@
 #include "event_logger.h"
 
-std::ofstream EventLogger::logFile;
-std::ofstream EventLogger::humanHandPoseFile;
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+#include "metrics.h"
+
+std::unique_ptr<SessionStorage> EventLogger::storage;
+int EventLogger::logStream = 0;
+int EventLogger::humanHandPoseStream = 0;
+int EventLogger::trialCount = 0;
 std::string EventLogger::sessionDirectory;
+std::mutex EventLogger::mutex;
+
+namespace
+{
+	constexpr size_t TIMESTAMP_LENGTH = 23;
+
+	// std::localtime returns a shared buffer; every logging thread converts into its own.
+	void toLocalTime(std::time_t time, std::tm& local)
+	{
+#ifdef _WIN32
+		localtime_s(&local, &time);
+#else
+		localtime_r(&time, &local);
+#endif
+	}
+
+	// "YYYY-mm-dd HH:MM:SS.mmm" in local time; the milliseconds let analysis order events within a second.
+	// Writes TIMESTAMP_LENGTH characters and a terminating zero.
+	void formatTimestamp(char* out)
+	{
+		const auto now = std::chrono::system_clock::now();
+		const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+		const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+
+		std::tm local{};
+		toLocalTime(now_time, local);
+		std::strftime(out, TIMESTAMP_LENGTH + 1, "%Y-%m-%d %H:%M:%S", &local);
+		std::snprintf(out + 19, 5, ".%03d", static_cast<int>(milliseconds));
+	}
+
+	const char* toString(LogLevel level)
+	{
+		switch (level)
+		{
+		case LogLevel::CONTROL: return "CONTROL";
+		case LogLevel::ROBOT: return "ROBOT";
+		case LogLevel::HUMAN: return "HUMAN";
+		}
+		return "";
+	}
+}
 
 void EventLogger::initialize()
+{
+    initialize(OUTPUT_DIRECTORY);
+}
+
+void EventLogger::initialize(const std::string& outputDirectory, const SessionStorageParameters& storageParameters)
 {
     const auto now = std::chrono::system_clock::now();
     const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+    std::tm local{};
+    toLocalTime(now_time, local);
     std::stringstream ss;
-    ss << std::put_time(std::localtime(&now_time), "%y-%m-%d_%Hh%Mm%Ss");
-    sessionDirectory = std::string(OUTPUT_DIRECTORY) + "/session" + ss.str();
+    ss << std::put_time(&local, "%y-%m-%d_%Hh%Mm%Ss");
+    sessionDirectory = outputDirectory + "/session" + ss.str();
 
     std::filesystem::create_directories(sessionDirectory);
 
-    logFile.open(sessionDirectory + "/logs.txt", std::ofstream::out | std::ofstream::app);
-    humanHandPoseFile.open(sessionDirectory + "/logs_human.txt", std::ofstream::out | std::ofstream::app);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        storage = std::make_unique<SessionStorage>();
+        if (!storage->open(sessionDirectory, storageParameters))
+            storage.reset();
+        else
+        {
+            logStream = storage->addStream("logs");
+            humanHandPoseStream = storage->addStream("logs_human");
+        }
+        trialCount = 0;
+    }
 
     log(LogLevel::CONTROL, "Session started at " + ss.str());
 }
 
 void EventLogger::log(LogLevel level, const std::string& msg)
 {
-	if (!logFile.is_open()) return;
-
-	const auto now = std::chrono::system_clock::now();
-	const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
-
-	std::stringstream timeSS, logSS;
-	timeSS << std::put_time(std::localtime(&now_time), "%Y-%m-%d %H:%M:%S");
-	std::string levelStr;
-	switch (level) {
-	case LogLevel::CONTROL: levelStr = "CONTROL"; break;
-	case LogLevel::ROBOT: levelStr = "ROBOT"; break;
-	case LogLevel::HUMAN: levelStr = "HUMAN"; break;
-	}
-
-	logSS << timeSS.str() << " " << levelStr << " " << msg << std::endl;
+	log(level, msg.c_str());
+}
 
-	logFile << logSS.str();
-	logFile.flush(); // Ensure that each message is immediately written to the file
+void EventLogger::log(LogLevel level, const char* msg)
+{
+	// Writes are synchronous, so the queue is the callers waiting for the file.
+	static Gauge& queueDepth = Metrics::gauge("logger.queueDepth");
+	static Histogram& writeTime = Metrics::histogram("logger.write");
+	queueDepth.add(1);
+	std::lock_guard<std::mutex> lock(mutex);
+	queueDepth.add(-1);
+	const ScopedTimer timer(writeTime);
+	if (!storage) return;
+
+	char line[256];
+	formatTimestamp(line);
+	const int written = std::snprintf(line + TIMESTAMP_LENGTH, sizeof(line) - TIMESTAMP_LENGTH, " %s %s\n", toString(level), msg);
+	if (written >= 0 && static_cast<size_t>(written) < sizeof(line) - TIMESTAMP_LENGTH)
+	{
+		storage->write(logStream, line, TIMESTAMP_LENGTH + written);
+		return;
+	}
+	// Longer messages, such as a staged parameter update, are rare enough to allocate.
+	std::string longLine(line, TIMESTAMP_LENGTH);
+	longLine.append(" ").append(toString(level)).append(" ").append(msg).append("\n");
+	storage->write(logStream, longLine.data(), longLine.size());
 }
 
-void EventLogger::logHumanHandPose(const std::string& msg)
+void EventLogger::logHumanHandPose(const Pose& pose)
 {
-	if (!humanHandPoseFile.is_open()) return;
+	if (!storage) return;
 
-	const auto now = std::chrono::system_clock::now();
-	const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+	char line[256];
+	formatTimestamp(line);
+	const int written = std::snprintf(line + TIMESTAMP_LENGTH, sizeof(line) - TIMESTAMP_LENGTH,
+		" Hand pose: x = %f, y = %f, z = %f, alpha = %f, beta = %f, gamma = %f\n",
+		pose.position.x, pose.position.y, pose.position.z,
+		pose.orientation.alpha, pose.orientation.beta, pose.orientation.gamma);
+	const size_t length = std::min(sizeof(line) - 1, TIMESTAMP_LENGTH + static_cast<size_t>(std::max(written, 0)));
 
-	std::stringstream timeSS;
-	timeSS << std::put_time(std::localtime(&now_time), "%Y-%m-%d %H:%M:%S");
+	storage->write(humanHandPoseStream, line, length);
+}
 
-	const std::string logMsg = timeSS.str() + " " + msg + "\n";
+void EventLogger::mark(SessionMark mark)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!storage) return;
 
-	humanHandPoseFile << logMsg;
-	humanHandPoseFile.flush(); // Ensure that each message is immediately written to the file
+	char time[TIMESTAMP_LENGTH + 1];
+	formatTimestamp(time);
+	storage->mark(time, mark == SessionMark::TRIAL ? "trial " + std::to_string(++trialCount) : "restart");
+}
+
+std::string EventLogger::getSessionDirectory()
+{
+	return sessionDirectory;
 }
 
 void EventLogger::finalize()
 {
-	if (logFile.is_open())
-		logFile.close();
-	if (humanHandPoseFile.is_open())
-		humanHandPoseFile.close();
+	std::lock_guard<std::mutex> lock(mutex);
+	// Waits until the last segments are compressed.
+	if (storage)
+		storage->close();
+	storage.reset();
 }
\ No newline at end of file
@@ -1,205 +1,169 @@
 #include "experiment.h"
 
-Experiment::Experiment(const ExperimentParameters& parameters)
-	: dnfComposerHandler(parameters.dnf, parameters.deltaT)
-	, coppeliasimHandler()
-	, handPose({},{})
+namespace
 {
+	std::unique_ptr<DnfEngine> createDnfEngine(const ExperimentParameters& parameters)
+	{
+		if (parameters.engine.location == DnfEngineLocation::OUT_OF_PROCESS)
+			return std::make_unique<RemoteDnfEngine>(parameters.dnf, parameters.engine);
+		return std::make_unique<DnfComposerHandler>(parameters.dnf, parameters.deltaT, parameters.recorder,
+			parameters.simulationLoop, parameters.decision, parameters.readout);
+	}
+}
 
+Experiment::Experiment(const ExperimentParameters& parameters)
+	: dnfEngine(createDnfEngine(parameters))
+	, coppeliasimHandler(parameters.transport, parameters.publisher, parameters.connection, parameters.io)
+	, parameterWatcher(parameters.architectureParameters, getDnfArchitectureDescription(parameters.dnf))
+	, updates(executor)
+	, stopRequested(false)
+	, ended(false)
+	, bridge(coppeliasimHandler, *dnfEngine, shadows, decisionLog, updates, stopRequested)
+	, threadLayoutFile(parameters.threadLayoutFile)
+	, storageParameters(parameters.storage)
+{
+	for (size_t i = 0; i < parameters.shadows.size(); ++i)
+		shadows.push_back(std::make_unique<ShadowRunner>(static_cast<int>(i + 1), parameters.shadows[i],
+			parameters.deltaT, parameters.simulationLoop.stepPeriod, parameters.decision));
 }
 
 Experiment::~Experiment()
 {
+	// Unwinding before the session is over stops it rather than waiting for the engine.
+	stopRequested = true;
+	updates.notify();
 	end();
 }
 
 void Experiment::init()
 {
-	dnfComposerHandler.init();
+	{
+		const StartupPhase phase("session");
+		EventLogger::initialize(OUTPUT_DIRECTORY, storageParameters);
+		ThreadLayout::load(threadLayoutFile);
+		ThreadLayout::report();
+		Metrics::startExporter(EventLogger::getSessionDirectory());
+		if (!decisionLog.open(EventLogger::getSessionDirectory() + "/decisions.csv"))
+			log(dnf_composer::tools::logger::LogLevel::WARNING, "Could not open the decision log.\n");
+	}
+	// Everything from here on overlaps: the I/O thread connects while the architecture is
+	// built here, the shadows build their engines and the UI thread builds the plot windows.
+	coppeliasimHandler.setUpdateListener([this] { updates.notify(); });
 	coppeliasimHandler.init();
-	EventLogger::initialize();
+	for (const auto& shadow : shadows)
+	{
+		shadow->start();
+		EventLogger::log(LogLevel::CONTROL, "Shadow mode: " + shadow->getName() + " runs the "
+			+ toString(shadow->getArchitecture().type) + " architecture in " + toString(shadow->getArchitecture().precision) + ".");
+	}
+	{
+		// Staged before the engine starts, so its first step already runs with the file's parameters.
+		const StartupPhase phase("parameters");
+		parameterWatcher.start([this](std::shared_ptr<const ArchitectureUpdate> update) {
+			for (const auto& shadow : shadows)
+				shadow->stageArchitectureUpdate(update);
+			dnfEngine->stageArchitectureUpdate(std::move(update));
+		});
+	}
+	dnfEngine->setDecisionListener([this] { updates.notify(); });
+	dnfEngine->init();
 }
 
 void Experiment::run()
 {
-	waitForConnectionWithCoppeliasim();
-	experimentThread = std::thread(&Experiment::handleSignalsBetweenDnfAndCoppeliasim, this);
-	waitForSimulationToStart();
+	executor.spawn(runLifecycle());
+	executor.spawn(handleSignalsBetweenDnfAndCoppeliasim());
+	experimentThread = std::thread([this]
+	{
+		ThreadLayout::applyToCurrentThread("experiment");
+		try
+		{
+			executor.run();
+		}
+		catch (const std::exception& e)
+		{
+			log(dnf_composer::tools::logger::LogLevel::ERROR, std::string("Experiment stopped: ") + e.what() + "\n");
+		}
+	});
 }
 
 void Experiment::end()
 {
-	dnfComposerHandler.end();
+	if (ended)
+		return;
+	ended = true;
+	// The session lasts until the engine is lost: its plot windows were closed, or the engine
+	// process went away. The experiment thread returns then and the engine is stopped after it.
+	if (experimentThread.joinable())
+		experimentThread.join();
+	stopRequested = true;
+	parameterWatcher.stop();
+	dnfEngine->end();
+	for (const auto& shadow : shadows)
+		shadow->stop();
 	coppeliasimHandler.end();
-	experimentThread.join();
+	decisionLog.close();
+	Metrics::stopExporter();
 	EventLogger::finalize();
 }
 
-void Experiment::handleSignalsBetweenDnfAndCoppeliasim()
+Coroutine Experiment::runLifecycle()
 {
-	while (coppeliasimHandler.isConnected())
+	while (!isSessionOver())
 	{
-		inSignals = coppeliasimHandler.getSignals();
-		sendHandPositionToDnf();
-		sendAvailableObjectsToDnf();
-		sendTargetObjectToRobot();
-		interpretAndLogSystemState();
-		coppeliasimHandler.setSignals(outSignals);
+		co_await waitForConnectionWithCoppeliasim();
+		while (!isSimulatorLost())
+		{
+			co_await waitForSimulationToStart();
+			co_await runTrial();
+		}
 	}
 }
 
-void Experiment::waitForConnectionWithCoppeliasim()
+Coroutine Experiment::handleSignalsBetweenDnfAndCoppeliasim()
 {
-	while (!coppeliasimHandler.isConnected())
-	{
-		log(dnf_composer::tools::logger::LogLevel::INFO, "Waiting for connection with CoppeliaSim...\n");
-		Sleep(500);
-	}
-	log(dnf_composer::tools::logger::LogLevel::INFO, "Connected with CoppeliaSim.\n");
-	EventLogger::log(LogLevel::CONTROL, "Connected with CoppeliaSim.");
+	return bridge.run();
 }
 
-void Experiment::waitForSimulationToStart()
+Coroutine Experiment::waitForConnectionWithCoppeliasim()
 {
-	bool hasSimStarted = inSignals.simStarted;
-	while (!hasSimStarted)
-	{
-		outSignals.startSim = true;
-		log(dnf_composer::tools::logger::LogLevel::INFO, "Waiting for Simulation to start...\n");
-		hasSimStarted = inSignals.simStarted;
-		Sleep(500);
-	}
-	log(dnf_composer::tools::logger::LogLevel::INFO, "Simulation has started.\n");
-}
-
-void Experiment::sendHandPositionToDnf()
-{
-	handPose = coppeliasimHandler.getHandPose();
-	dnfComposerHandler.setHandStimulus({ handPose.position.x,
-		handPose.position.y,
-		handPose.position.z},
-		inSignals.object1,
-		inSignals.object2,
-		inSignals.object3);
-}
-
-void Experiment::sendAvailableObjectsToDnf() const
-{
-	dnfComposerHandler.setAvailableObjectsInTheWorkspace(inSignals.object1, inSignals.object2, inSignals.object3);
-}
-
-void Experiment::sendTargetObjectToRobot()
-{
-	outSignals.targetObject = dnfComposerHandler.getTargetObject();
+	log(dnf_composer::tools::logger::LogLevel::INFO, "Waiting for connection with CoppeliaSim...\n");
+	co_await updates.until([this] { return isSessionOver() || coppeliasimHandler.isConnected(); });
+	if (isSessionOver())
+		co_return;
+	log(dnf_composer::tools::logger::LogLevel::INFO, "Connected with CoppeliaSim.\n");
+	EventLogger::log(LogLevel::CONTROL, "Connected with CoppeliaSim.");
+	StartupProfile::milestone("connected");
 }
 
-void Experiment::interpretAndLogSystemState()
+Coroutine Experiment::waitForSimulationToStart()
 {
-	const std::string log = "Hand pose: x = "
-		+ std::to_string(handPose.position.x) +
-		", y = " + std::to_string(handPose.position.y) +
-		", z = " + std::to_string(handPose.position.z) +
-		", alpha = " + std::to_string(handPose.orientation.alpha) +
-		", beta = " + std::to_string(handPose.orientation.beta) +
-		", gamma = " + std::to_string(handPose.orientation.gamma);
-	EventLogger::logHumanHandPose(log);
-
-	if(inSignals.simStarted && logMsgs.prevSimStarted == false)
-	{
-		EventLogger::log(LogLevel::CONTROL, "Simulation has started.");
-		logMsgs.prevSimStarted = true;
-	}
-	logMsgs.prevSimStarted = inSignals.simStarted;
-
-	// Grasping events for robot, logged every time it passes from 0 to 1.
-	if (inSignals.robotGraspObj1 && logMsgs.prevRobotGraspObj1 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 1.");
-	}
-	logMsgs.prevRobotGraspObj1 = inSignals.robotGraspObj1;
-
-	if (inSignals.robotGraspObj2 && logMsgs.prevRobotGraspObj2 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 2.");
-	}
-	logMsgs.prevRobotGraspObj2 = inSignals.robotGraspObj2;
-
-	if (inSignals.robotGraspObj3 && logMsgs.prevRobotGraspObj3 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 3.");
-	}
-	logMsgs.prevRobotGraspObj3 = inSignals.robotGraspObj3;
-
-	// Grasping events for human, logged every time it passes from 0 to 1.
-	if (inSignals.humanGraspObj1 && logMsgs.prevHumanGraspObj1 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 1.");
-	}
-	logMsgs.prevHumanGraspObj1 = inSignals.humanGraspObj1;
-
-	if (inSignals.humanGraspObj2 && logMsgs.prevHumanGraspObj2 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 2.");
-	}
-	logMsgs.prevHumanGraspObj2 = inSignals.humanGraspObj2;
-
-	if (inSignals.humanGraspObj3 && logMsgs.prevHumanGraspObj3 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 3.");
-	}
-	logMsgs.prevHumanGraspObj3 = inSignals.humanGraspObj3;
-
-	// Placement events for robot, logged every time it passes from 0 to 1.
-	if (inSignals.robotPlaceObj1 && logMsgs.prevRobotPlaceObj1 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 1.");
-	}
-	logMsgs.prevRobotPlaceObj1 = inSignals.robotPlaceObj1;
-
-	if (inSignals.robotPlaceObj2 && logMsgs.prevRobotPlaceObj2 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 2.");
-	}
-	logMsgs.prevRobotPlaceObj2 = inSignals.robotPlaceObj2;
-
-	if (inSignals.robotPlaceObj3 && logMsgs.prevRobotPlaceObj3 == 0) {
-		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 3.");
-	}
-	logMsgs.prevRobotPlaceObj3 = inSignals.robotPlaceObj3;
-
-	// Placement events for human, logged every time it passes from 0 to 1.
-	if (inSignals.humanPlaceObj1 && logMsgs.prevHumanPlaceObj1 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is placing object 1.");
-	}
-	logMsgs.prevHumanPlaceObj1 = inSignals.humanPlaceObj1;
-
-	if (inSignals.humanPlaceObj2 && logMsgs.prevHumanPlaceObj2 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is placing object 2.");
-	}
-	logMsgs.prevHumanPlaceObj2 = inSignals.humanPlaceObj2;
-
-	if (inSignals.humanPlaceObj3 && logMsgs.prevHumanPlaceObj3 == 0) {
-		EventLogger::log(LogLevel::HUMAN, "Human is placing object 3.");
-	}
-	logMsgs.prevHumanPlaceObj3 = inSignals.humanPlaceObj3;
-
-	// Check if the robot is approaching a new object.
-	if (inSignals.robotApproaching && /*!inSignals.robotGrasping && */outSignals.targetObject != logMsgs.lastTargetObject) {
-		if (outSignals.targetObject != 0)
-			EventLogger::log(LogLevel::ROBOT, "Robot will target object " + std::to_string(outSignals.targetObject) + ".");
-		logMsgs.lastTargetObject = outSignals.targetObject;
-	}
+	bridge.requestSimulationStart();
+	log(dnf_composer::tools::logger::LogLevel::INFO, "Waiting for Simulation to start...\n");
+	co_await updates.until([this] { return isSimulatorLost() || coppeliasimHandler.getSignals().simStarted; });
+	if (isSimulatorLost())
+		co_return;
+	log(dnf_composer::tools::logger::LogLevel::INFO, "Simulation has started.\n");
 }
 
-void Experiment::keepAliveWhileTaskIsRunning() const
+Coroutine Experiment::runTrial()
 {
-	while (true)
-	{
-		Sleep(1000);
-	}
-	// For now let's keep alive for a few seconds after the task is done.
-	Sleep(10000);
+	// The trial lasts until the scene asks for a restart or the simulator goes away.
+	co_await updates.until([this] { return isSimulatorLost() || coppeliasimHandler.getSignals().restart; });
+	if (isSimulatorLost())
+		co_return;
+	EventLogger::mark(SessionMark::RESTART);
+	EventLogger::log(LogLevel::CONTROL, "Restart requested.");
+	bridge.resetSystemState();
+	co_await updates.until([this] { return isSimulatorLost() || !coppeliasimHandler.getSignals().restart; });
 }
 
-bool Experiment::areObjectsPresent() const
+bool Experiment::isSessionOver() const
 {
-	const bool isPresent = inSignals.object1 != 0 || inSignals.object2 != 0 || inSignals.object3 != 0;
-	return isPresent;
+	return stopRequested || dnfEngine->isLost();
 }
 
-bool Experiment::areAllObjectsPresent() const
+bool Experiment::isSimulatorLost() const
 {
-	return inSignals.object1 != 0 && inSignals.object2 != 0 && inSignals.object3 != 0;
+	return isSessionOver() || !coppeliasimHandler.isConnected();
 }
@@ -0,0 +1,344 @@
+#include "field_engine.h"
+
+#include <algorithm>
+#include <cmath>
+
+int FieldEngineBase::getTargetObject() const
+{
+	return getTargetObjectFromCentroid(getCentroid("ael"), description.xMax);
+}
+
+int FieldEngineBase::indexOf(const std::string& name) const
+{
+	for (size_t i = 0; i < description.elements.size(); ++i)
+		if (description.elements[i].name == name)
+			return static_cast<int>(i);
+	return -1;
+}
+
+template <typename Precision>
+FieldEngine<Precision>::FieldEngine(const DnfArchitectureDescription& description, double deltaT, uint32_t seed)
+	: FieldEngineBase(description)
+	, deltaT(deltaT)
+	, size(std::max(1, description.getSize()))
+	, seed(seed)
+	, accumulator(size)
+{
+	int maxRadius = 0;
+	for (const auto& element : description.elements)
+	{
+		Node node;
+		node.type = element.type;
+		if (element.type != DnfElementType::GAUSS_STIMULUS)
+			node.output.assign(size, Storage(0));
+		if (element.type == DnfElementType::NEURAL_FIELD)
+		{
+			node.activation.assign(size, Storage(0));
+			node.input.assign(size, Storage(0));
+		}
+		nodes.push_back(std::move(node));
+	}
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		for (const auto& input : description.elements[i].inputs)
+		{
+			const int index = indexOf(input);
+			if (index >= 0)
+				nodes[i].inputs.push_back(index);
+		}
+		if (nodes[i].type == DnfElementType::GAUSS_KERNEL || nodes[i].type == DnfElementType::LATERAL_INTERACTIONS)
+		{
+			nodes[i].profile = ProfileCache::kernel<Storage>(description.elements[i], description.dx, size);
+			nodes[i].radius = static_cast<int>(nodes[i].profile->size() / 2);
+			maxRadius = std::max(maxRadius, nodes[i].radius);
+		}
+	}
+	padded.assign(size + 2 * maxRadius, Storage(0));
+	init();
+}
+
+template <typename Precision>
+void FieldEngine<Precision>::init()
+{
+	generator.seed(seed);
+	normal.reset();
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		Node& node = nodes[i];
+		switch (node.type)
+		{
+		case DnfElementType::NEURAL_FIELD:
+		{
+			const auto& element = description.elements[i];
+			const double output = 1.0 / (1.0 + std::exp(-element.steepness * (element.restingLevel - element.xShift)));
+			std::fill(node.activation.begin(), node.activation.end(), Storage(element.restingLevel));
+			std::fill(node.input.begin(), node.input.end(), Storage(0));
+			std::fill(node.output.begin(), node.output.end(), Storage(output));
+			break;
+		}
+		case DnfElementType::GAUSS_STIMULUS:
+			acquireStimulus(static_cast<int>(i));
+			break;
+		default:
+			std::fill(node.output.begin(), node.output.end(), Storage(0));
+			break;
+		}
+	}
+}
+
+template <typename Precision>
+void FieldEngine<Precision>::step()
+{
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		Node& node = nodes[i];
+		switch (node.type)
+		{
+		case DnfElementType::NEURAL_FIELD:
+			stepField(static_cast<int>(i));
+			break;
+		case DnfElementType::GAUSS_KERNEL:
+		case DnfElementType::LATERAL_INTERACTIONS:
+		{
+			if (node.inputs.empty())
+				break;
+			const Storage* source = getOutput(node.inputs.front());
+			convolve(source, node);
+			Accumulator global = 0;
+			if (description.elements[i].amplitudeGlobal != 0)
+			{
+				for (int x = 0; x < size; ++x)
+					global += source[x];
+				global *= static_cast<Accumulator>(description.elements[i].amplitudeGlobal);
+			}
+			for (int x = 0; x < size; ++x)
+				node.output[x] = static_cast<Storage>(accumulator[x] + global);
+			break;
+		}
+		case DnfElementType::NORMAL_NOISE:
+		{
+			const double amplitude = description.elements[i].amplitude;
+			for (auto& value : node.output)
+				value = static_cast<Storage>(amplitude * normal(generator));
+			break;
+		}
+		case DnfElementType::GAUSS_STIMULUS:
+			break; // recomputed only when its parameters change
+		}
+	}
+}
+
+template <typename Precision>
+void FieldEngine<Precision>::stepField(int index)
+{
+	Node& node = nodes[index];
+	const auto& element = description.elements[index];
+
+	std::fill(accumulator.begin(), accumulator.end(), Accumulator(0));
+	for (const int input : node.inputs)
+	{
+		const Storage* source = getOutput(input);
+		for (int x = 0; x < size; ++x)
+			accumulator[x] += source[x];
+	}
+
+	const Accumulator rate = static_cast<Accumulator>(deltaT / element.tau);
+	const Accumulator restingLevel = static_cast<Accumulator>(element.restingLevel);
+	const Accumulator steepness = static_cast<Accumulator>(element.steepness);
+	const Accumulator xShift = static_cast<Accumulator>(element.xShift);
+	for (int x = 0; x < size; ++x)
+	{
+		Accumulator u = node.activation[x];
+		u += rate * (-u + restingLevel + accumulator[x]);
+		node.input[x] = static_cast<Storage>(accumulator[x]);
+		node.activation[x] = static_cast<Storage>(u);
+		node.output[x] = static_cast<Storage>(Accumulator(1) / (Accumulator(1) + std::exp(-steepness * (u - xShift))));
+	}
+}
+
+template <typename Precision>
+void FieldEngine<Precision>::convolve(const Storage* source, const Node& kernel)
+{
+	// accumulator[x] = sum over taps j of weights[j] * padded[x + 2 * radius - j]
+	// The source is copied into a buffer padded by the radius (zeros, or the wrapped field when
+	// circular), so every tap is one bounds-free multiply-add over the whole field. Taps are
+	// applied in pairs to halve the accumulator traffic, keeping the serial summation order.
+	const int radius = kernel.radius;
+	std::fill(padded.begin(), padded.end(), Storage(0));
+	std::copy(source, source + size, padded.begin() + radius);
+	if (description.circular)
+		for (int k = 1; k <= radius; ++k)
+		{
+			padded[radius - k] = source[((size - k) % size + size) % size];
+			padded[radius + size - 1 + k] = source[(k - 1) % size];
+		}
+
+	std::fill(accumulator.begin(), accumulator.end(), Accumulator(0));
+	Accumulator* out = accumulator.data();
+	const Storage* weights = kernel.profile->data();
+	const int taps = 2 * radius + 1;
+	int j = 0;
+	for (; j + 1 < taps; j += 2)
+	{
+		const Accumulator first = weights[j];
+		const Accumulator second = weights[j + 1];
+		const Storage* in = padded.data() + 2 * radius - j;
+		for (int x = 0; x < size; ++x)
+			out[x] = (out[x] + first * static_cast<Accumulator>(in[x])) + second * static_cast<Accumulator>(in[x - 1]);
+	}
+	for (; j < taps; ++j)
+	{
+		const Accumulator weight = weights[j];
+		const Storage* in = padded.data() + 2 * radius - j;
+		for (int x = 0; x < size; ++x)
+			out[x] += weight * static_cast<Accumulator>(in[x]);
+	}
+}
+
+template <typename Precision>
+void FieldEngine<Precision>::acquireStimulus(int index)
+{
+	Node& node = nodes[index];
+	if (node.output.empty())
+		node.profile = ProfileCache::stimulus<Storage>(description.elements[index],
+			description.dx, description.xMax, size, description.circular);
+	else
+		ProfileCache::sampleStimulus(description.elements[index], description.dx, description.xMax,
+			size, description.circular, node.output.data());
+}
+
+template <typename Precision>
+bool FieldEngine<Precision>::setStimulus(int index, double amplitude, double position)
+{
+	if (index < 0 || index >= static_cast<int>(nodes.size()) || nodes[index].type != DnfElementType::GAUSS_STIMULUS)
+		return false;
+	auto& element = description.elements[index];
+	if (element.amplitude == amplitude && element.position == position)
+		return true;
+	element.amplitude = amplitude;
+	element.position = position;
+	Node& node = nodes[index];
+	if (node.output.empty())
+	{
+		// First move: from now on the samples are rewritten in place.
+		node.profile.reset();
+		node.output.assign(size, Storage(0));
+	}
+	acquireStimulus(index);
+	return true;
+}
+
+template <typename Precision>
+bool FieldEngine<Precision>::setKernel(int index, const DnfElementDescription& kernel)
+{
+	if (index < 0 || index >= static_cast<int>(nodes.size()) || nodes[index].type != kernel.type
+		|| (kernel.type != DnfElementType::GAUSS_KERNEL && kernel.type != DnfElementType::LATERAL_INTERACTIONS))
+		return false;
+	auto& element = description.elements[index];
+	element.sigma = kernel.sigma;
+	element.amplitude = kernel.amplitude;
+	element.sigmaInhibitory = kernel.sigmaInhibitory;
+	element.amplitudeInhibitory = kernel.amplitudeInhibitory;
+	element.amplitudeGlobal = kernel.amplitudeGlobal;
+	Node& node = nodes[index];
+	node.profile = ProfileCache::kernel<Storage>(element, description.dx, size);
+	node.radius = static_cast<int>(node.profile->size() / 2);
+	// Only a wider kernel than any before it grows the convolution buffer.
+	if (size + 2 * node.radius > static_cast<int>(padded.size()))
+		padded.assign(size + 2 * node.radius, Storage(0));
+	return true;
+}
+
+template <typename Precision>
+bool FieldEngine<Precision>::updateDetector(int index, BumpDetector& detector, uint64_t step, DecisionEvent& event) const
+{
+	if (index < 0 || index >= static_cast<int>(nodes.size()) || nodes[index].type != DnfElementType::NEURAL_FIELD)
+		return false;
+	return detector.update(nodes[index].activation.data(), size, description.dx, step, event);
+}
+
+template <typename Precision>
+double FieldEngine<Precision>::getCentroid(const std::string& field) const
+{
+	// Output-weighted mean position of the supra-threshold samples, -1 without a bump.
+	const int index = indexOf(field);
+	if (index < 0 || nodes[index].type != DnfElementType::NEURAL_FIELD)
+		return -1;
+	const Node& node = nodes[index];
+	double weightedSum = 0, weight = 0;
+	for (int x = 0; x < size; ++x)
+	{
+		if (node.activation[x] <= 0)
+			continue;
+		weightedSum += x * description.dx * node.output[x];
+		weight += node.output[x];
+	}
+	return weight > 0 ? weightedSum / weight : -1;
+}
+
+template <typename Precision>
+std::vector<double> FieldEngine<Precision>::getComponent(const std::string& element, const std::string& component) const
+{
+	const int index = indexOf(element);
+	if (index < 0)
+		return {};
+	const Node& node = nodes[index];
+	const std::vector<Storage>* values = nullptr;
+	if (component == "output")
+		values = node.profile && node.type == DnfElementType::GAUSS_STIMULUS ? node.profile.get() : &node.output;
+	else if (component == "activation" && !node.activation.empty())
+		values = &node.activation;
+	else if (component == "input" && !node.input.empty())
+		values = &node.input;
+	else if (component == "kernel" && node.type != DnfElementType::GAUSS_STIMULUS && node.profile)
+		values = node.profile.get();
+	if (values == nullptr)
+		return {};
+	return { values->begin(), values->end() };
+}
+
+template <typename Precision>
+size_t FieldEngine<Precision>::getMemoryFootprint() const
+{
+	// Shared profiles are accounted for by ProfileCache::getMemoryFootprint().
+	size_t bytes = accumulator.size() * sizeof(Accumulator) + padded.size() * sizeof(Storage);
+	for (const auto& node : nodes)
+		bytes += (node.activation.size() + node.input.size() + node.output.size()) * sizeof(Storage);
+	return bytes;
+}
+
+template <typename Precision>
+const typename FieldEngine<Precision>::Storage* FieldEngine<Precision>::getOutput(int index) const
+{
+	const Node& node = nodes[index];
+	return node.type == DnfElementType::GAUSS_STIMULUS && node.profile ? node.profile->data() : node.output.data();
+}
+
+template class FieldEngine<DoublePrecision>;
+template class FieldEngine<SinglePrecision>;
+template class FieldEngine<MixedPrecision>;
+
+std::unique_ptr<FieldEngineBase> createFieldEngine(const DnfArchitectureDescription& description, double deltaT, uint32_t seed)
+{
+	switch (description.precision)
+	{
+	case FieldPrecision::FLOAT:
+		return std::make_unique<FieldEngine<SinglePrecision>>(description, deltaT, seed);
+	case FieldPrecision::MIXED:
+		return std::make_unique<FieldEngine<MixedPrecision>>(description, deltaT, seed);
+	case FieldPrecision::DOUBLE:
+	default:
+		return std::make_unique<FieldEngine<DoublePrecision>>(description, deltaT, seed);
+	}
+}
+
+const char* toString(FieldPrecision precision)
+{
+	switch (precision)
+	{
+	case FieldPrecision::FLOAT: return "float";
+	case FieldPrecision::MIXED: return "mixed";
+	case FieldPrecision::DOUBLE: return "double";
+	}
+	return "unknown";
+}
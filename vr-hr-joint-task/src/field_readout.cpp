@@ -0,0 +1,225 @@
+#include "field_readout.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <tools/logger.h>
+
+FieldPublisher::FieldPublisher(const FieldReadoutParameters& parameters)
+	: parameters(parameters)
+	, region(nullptr)
+	, stepCounter(0)
+	, publishTime(Metrics::histogram("readout.publish"))
+{
+	this->parameters.decimation = std::max(1, parameters.decimation);
+}
+
+FieldPublisher::~FieldPublisher()
+{
+	stop();
+}
+
+bool FieldPublisher::start(const std::shared_ptr<dnf_composer::Simulation>& simulation)
+{
+	if (!memory.open(parameters.sharedMemoryName, sizeof(FieldReadoutRegion)))
+	{
+		log(dnf_composer::tools::logger::LogLevel::ERROR, "Could not open the field readout region " + parameters.sharedMemoryName + ".\n");
+		return false;
+	}
+	region = static_cast<FieldReadoutRegion*>(memory.data());
+	region->initialize();
+	if (!region->isValid())
+	{
+		log(dnf_composer::tools::logger::LogLevel::ERROR, "The field readout region " + parameters.sharedMemoryName + " has an unknown layout.\n");
+		region = nullptr;
+		memory.close();
+		return false;
+	}
+
+	// Readers re-read the columns when layoutSequence changes; until the first publication
+	// under the new layout there is none to read.
+	const uint32_t sequence = region->layoutSequence.load(std::memory_order_relaxed);
+	region->layoutSequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	region->latest.store(0, std::memory_order_relaxed);
+	sources.clear();
+	uint32_t offset = 0;
+	for (const auto& field : parameters.fields)
+	{
+		for (const char* component : { "activation", "input", "output" })
+		{
+			const std::vector<double>* source = simulation->getComponentPtr(field, component);
+			if (source == nullptr)
+			{
+				log(dnf_composer::tools::logger::LogLevel::WARNING, "Field readout: '" + field + "' has no component " + component + ".\n");
+				continue;
+			}
+			const auto size = static_cast<uint32_t>(source->size());
+			if (sources.size() == FieldReadoutRegion::MAX_COLUMNS || offset + size > FieldReadoutRegion::MAX_SAMPLES)
+			{
+				log(dnf_composer::tools::logger::LogLevel::WARNING, "Field readout: no room for " + field + " " + component + ".\n");
+				continue;
+			}
+			FieldReadoutRegion::Column& column = region->columns[sources.size()];
+			std::memset(&column, 0, sizeof(column));
+			std::strncpy(column.element, field.c_str(), FieldReadoutRegion::NAME_LENGTH - 1);
+			std::strncpy(column.component, component, FieldReadoutRegion::NAME_LENGTH - 1);
+			column.offset = offset;
+			column.size = size;
+			sources.push_back({ source, offset, size });
+			offset += size;
+		}
+	}
+	region->columnCount = static_cast<uint32_t>(sources.size());
+	region->layoutSequence.store(sequence + 2, std::memory_order_release);
+	region->publisherAttached.store(1, std::memory_order_release);
+	log(dnf_composer::tools::logger::LogLevel::INFO, "Publishing " + std::to_string(sources.size()) + " field components on "
+		+ parameters.sharedMemoryName + ".\n");
+	return true;
+}
+
+void FieldPublisher::stop()
+{
+	if (region == nullptr)
+		return;
+	region->publisherAttached.store(0, std::memory_order_release);
+	region = nullptr;
+	memory.close();
+}
+
+void FieldPublisher::publish(uint64_t step, uint64_t inputFrame, int targetObject, const Bump& bump)
+{
+	if (region == nullptr || stepCounter++ % parameters.decimation != 0)
+		return;
+	const ScopedTimer timer(publishTime);
+
+	const uint64_t publication = region->latest.load(std::memory_order_relaxed) + 1;
+	FieldReadoutRegion::Slot& slot = region->slots[publication % FieldReadoutRegion::SLOT_COUNT];
+	const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+	slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.publication = publication;
+	slot.step = step;
+	slot.inputFrame = inputFrame;
+	slot.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	slot.targetObject = targetObject;
+	slot.bump = bump;
+	// Plain copies: readers that overlap them see a changed sequence and discard what they read.
+	for (const Source& source : sources)
+		std::memcpy(slot.samples + source.offset, source.component->data(), std::min<size_t>(source.size, source.component->size()) * sizeof(double));
+	slot.sequence.store(sequence + 2, std::memory_order_release);
+	region->latest.store(publication, std::memory_order_release);
+}
+
+FieldReader::FieldReader()
+	: region(nullptr)
+	, layout(1)
+	, sampleCount(0)
+{
+}
+
+bool FieldReader::open(const std::string& sharedMemoryName)
+{
+	if (!memory.open(sharedMemoryName, sizeof(FieldReadoutRegion)))
+		return false;
+	region = static_cast<const FieldReadoutRegion*>(memory.data());
+	layout = 1;
+	return true;
+}
+
+bool FieldReader::isPublisherAttached() const
+{
+	return region != nullptr && region->isValid() && region->publisherAttached.load(std::memory_order_acquire) != 0;
+}
+
+const std::vector<FieldColumn>& FieldReader::getColumns()
+{
+	if (region != nullptr && region->layoutSequence.load(std::memory_order_acquire) != layout)
+		for (int attempt = 0; attempt < 1000 && !readLayout(); ++attempt) {}
+	return columns;
+}
+
+int FieldReader::indexOf(const std::string& element, const std::string& component)
+{
+	const auto& current = getColumns();
+	const auto it = std::find_if(current.begin(), current.end(), [&](const FieldColumn& column) {
+		return column.element == element && column.component == component;
+	});
+	return it == current.end() ? -1 : static_cast<int>(it - current.begin());
+}
+
+bool FieldReader::readLayout()
+{
+	const uint32_t sequence = region->layoutSequence.load(std::memory_order_acquire);
+	if (sequence & 1)
+		return false;
+	std::vector<FieldColumn> read;
+	size_t samples = 0;
+	const uint32_t count = std::min<uint32_t>(region->columnCount, FieldReadoutRegion::MAX_COLUMNS);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const FieldReadoutRegion::Column& column = region->columns[i];
+		read.push_back({ std::string(column.element, strnlen(column.element, FieldReadoutRegion::NAME_LENGTH)),
+			std::string(column.component, strnlen(column.component, FieldReadoutRegion::NAME_LENGTH)),
+			static_cast<int>(column.offset), static_cast<int>(column.size) });
+		samples = std::max<size_t>(samples, column.offset + column.size);
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (region->layoutSequence.load(std::memory_order_relaxed) != sequence)
+		return false;
+	columns = std::move(read);
+	sampleCount = std::min<size_t>(samples, FieldReadoutRegion::MAX_SAMPLES);
+	layout = sequence;
+	return true;
+}
+
+bool FieldReader::acquire(FieldView& view) const
+{
+	if (region == nullptr || region->layoutSequence.load(std::memory_order_acquire) != layout)
+		return false; // no layout yet, or the publisher restarted: call getColumns()
+	const uint64_t latest = region->latest.load(std::memory_order_acquire);
+	if (latest == 0)
+		return false;
+	const FieldReadoutRegion::Slot& slot = region->slots[latest % FieldReadoutRegion::SLOT_COUNT];
+	view.sequence = slot.sequence.load(std::memory_order_acquire);
+	if (view.sequence & 1)
+		return false;
+	view.slot = &slot;
+	view.publication = slot.publication;
+	view.step = slot.step;
+	view.inputFrame = slot.inputFrame;
+	view.time = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::nanoseconds(slot.time)));
+	view.targetObject = slot.targetObject;
+	view.bump = slot.bump;
+	view.samples = slot.samples;
+	return true;
+}
+
+bool FieldReader::validate(const FieldView& view) const
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return view.slot != nullptr && view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
+
+bool FieldReader::read(FieldView& view, std::vector<double>& samples) const
+{
+	samples.resize(sampleCount);
+	for (int attempt = 0; attempt < 1000; ++attempt)
+	{
+		if (!acquire(view))
+		{
+			if (region == nullptr || region->latest.load(std::memory_order_relaxed) == 0
+				|| region->layoutSequence.load(std::memory_order_relaxed) != layout)
+				return false;
+			continue;
+		}
+		std::memcpy(samples.data(), view.samples, sampleCount * sizeof(double));
+		if (validate(view))
+		{
+			view.samples = samples.data();
+			return true;
+		}
+	}
+	return false;
+}
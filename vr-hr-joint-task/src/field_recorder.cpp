@@ -0,0 +1,203 @@
+#include "field_recorder.h"
+
+#include <cstring>
+
+#include <zlib.h>
+#include <tools/logger.h>
+
+#include "thread_layout.h"
+
+FieldRecorder::FieldRecorder(const FieldRecorderParameters& parameters)
+	: parameters(parameters)
+	, current(nullptr)
+	, stopRequested(false)
+	, stepCounter(0)
+	, droppedChunks(Metrics::counter("recorder.droppedChunks"))
+	, captureTime(Metrics::histogram("recorder.capture"))
+{
+	this->parameters.decimation = std::max(1, parameters.decimation);
+	this->parameters.ticksPerChunk = std::max(1, parameters.ticksPerChunk);
+}
+
+FieldRecorder::~FieldRecorder()
+{
+	stop();
+}
+
+bool FieldRecorder::start(const std::shared_ptr<dnf_composer::Simulation>& simulation, const std::string& directory)
+{
+	for (const auto& field : parameters.fields)
+	{
+		for (const char* component : COMPONENT_NAMES)
+		{
+			const std::vector<double>* source = simulation->getComponentPtr(field, component);
+			if (source == nullptr)
+			{
+				log(dnf_composer::tools::logger::LogLevel::WARNING, "Field recorder: '" + field + "' has no component " + component + ", recording disabled.\n");
+				return false;
+			}
+			sources.push_back(source);
+		}
+		sizes.push_back(sources.back()->size());
+	}
+
+	file.open(directory + "/fields.bin", std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!file.is_open())
+		return false;
+
+	const uint32_t fieldCount = static_cast<uint32_t>(parameters.fields.size());
+	const uint32_t decimation = static_cast<uint32_t>(parameters.decimation);
+	const uint32_t ticksPerChunk = static_cast<uint32_t>(parameters.ticksPerChunk);
+	file.write("HRVRFLD2", 8);
+	file.write(reinterpret_cast<const char*>(&fieldCount), sizeof(fieldCount));
+	file.write(reinterpret_cast<const char*>(&decimation), sizeof(decimation));
+	file.write(reinterpret_cast<const char*>(&ticksPerChunk), sizeof(ticksPerChunk));
+	for (size_t i = 0; i < parameters.fields.size(); ++i)
+	{
+		char name[32] = {};
+		std::strncpy(name, parameters.fields[i].c_str(), sizeof(name) - 1);
+		const uint32_t size = static_cast<uint32_t>(sizes[i]);
+		file.write(name, sizeof(name));
+		file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	}
+
+	// Every buffer the simulation thread touches is allocated here, up front.
+	size_t largestColumn = static_cast<size_t>(parameters.ticksPerChunk) * sizeof(double);
+	pool.resize(CHUNK_POOL_SIZE);
+	for (auto& chunk : pool)
+	{
+		chunk.steps.resize(parameters.ticksPerChunk);
+		chunk.times.resize(parameters.ticksPerChunk);
+		chunk.inputFrames.resize(parameters.ticksPerChunk);
+		for (size_t field = 0; field < sizes.size(); ++field)
+			for (int component = 0; component < COMPONENTS; ++component)
+				chunk.columns.emplace_back(sizes[field] * parameters.ticksPerChunk);
+		freeChunks.push(&chunk);
+	}
+	for (const size_t size : sizes)
+		largestColumn = std::max(largestColumn, size * parameters.ticksPerChunk * sizeof(double));
+	compressed.resize(compressBound(static_cast<uLong>(largestColumn)));
+
+	current = freeChunks.front();
+	freeChunks.pop();
+	stopRequested = false;
+	writerThread = std::thread(&FieldRecorder::writerLoop, this);
+	log(dnf_composer::tools::logger::LogLevel::INFO, "Field recorder writing to " + directory + "/fields.bin.\n");
+	return true;
+}
+
+void FieldRecorder::capture(double time, uint64_t inputFrame)
+{
+	const uint64_t step = stepCounter++;
+	if (current == nullptr || step % parameters.decimation != 0)
+		return;
+
+	const ScopedTimer timer(captureTime);
+	Chunk& chunk = *current;
+	const int tick = chunk.ticks;
+	chunk.steps[tick] = step;
+	chunk.times[tick] = time;
+	chunk.inputFrames[tick] = inputFrame;
+	for (size_t column = 0; column < sources.size(); ++column)
+	{
+		const size_t size = sizes[column / COMPONENTS];
+		const std::vector<double>& source = *sources[column];
+		std::memcpy(chunk.columns[column].data() + tick * size, source.data(), std::min(size, source.size()) * sizeof(double));
+	}
+	chunk.ticks++;
+
+	if (chunk.ticks == parameters.ticksPerChunk)
+		submitCurrentChunk();
+}
+
+void FieldRecorder::submitCurrentChunk()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		fullChunks.push(current);
+		if (freeChunks.empty())
+		{
+			// Writer is behind: reuse the oldest pending chunk instead of blocking the step.
+			current = fullChunks.front();
+			fullChunks.pop();
+			droppedChunks.increment();
+		}
+		else
+		{
+			current = freeChunks.front();
+			freeChunks.pop();
+		}
+		current->ticks = 0;
+	}
+	wakeUp.notify_one();
+}
+
+void FieldRecorder::stop()
+{
+	if (!writerThread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (current != nullptr && current->ticks > 0)
+			fullChunks.push(current);
+		current = nullptr;
+		stopRequested = true;
+	}
+	wakeUp.notify_one();
+	writerThread.join();
+	file.close();
+}
+
+void FieldRecorder::writerLoop()
+{
+	ThreadLayout::applyToCurrentThread("recorder");
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		wakeUp.wait(lock, [this] { return stopRequested || !fullChunks.empty(); });
+		if (fullChunks.empty())
+			break;
+		Chunk* chunk = fullChunks.front();
+		fullChunks.pop();
+
+		lock.unlock();
+		writeChunk(*chunk);
+		lock.lock();
+
+		freeChunks.push(chunk);
+	}
+}
+
+void FieldRecorder::writeChunk(const Chunk& chunk)
+{
+	const uint32_t ticks = static_cast<uint32_t>(chunk.ticks);
+	file.write("CHNK", 4);
+	file.write(reinterpret_cast<const char*>(&ticks), sizeof(ticks));
+	writeColumn(chunk.steps.data(), ticks * sizeof(uint64_t));
+	writeColumn(chunk.times.data(), ticks * sizeof(double));
+	writeColumn(chunk.inputFrames.data(), ticks * sizeof(uint64_t));
+	for (size_t column = 0; column < chunk.columns.size(); ++column)
+		writeColumn(chunk.columns[column].data(), ticks * sizes[column / COMPONENTS] * sizeof(double));
+	file.flush();
+}
+
+void FieldRecorder::writeColumn(const void* data, size_t bytes)
+{
+	uLongf compressedBytes = static_cast<uLongf>(compressed.size());
+	const int result = compress2(compressed.data(), &compressedBytes,
+		static_cast<const Bytef*>(data), static_cast<uLong>(bytes), parameters.compressionLevel);
+	const uint32_t rawSize = static_cast<uint32_t>(bytes);
+	if (result != Z_OK || compressedBytes >= bytes)
+	{
+		// Stored uncompressed; a reader recognizes this by compressedBytes == rawBytes.
+		file.write(reinterpret_cast<const char*>(&rawSize), sizeof(rawSize));
+		file.write(reinterpret_cast<const char*>(&rawSize), sizeof(rawSize));
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+		return;
+	}
+	const uint32_t compressedSize = static_cast<uint32_t>(compressedBytes);
+	file.write(reinterpret_cast<const char*>(&rawSize), sizeof(rawSize));
+	file.write(reinterpret_cast<const char*>(&compressedSize), sizeof(compressedSize));
+	file.write(reinterpret_cast<const char*>(compressed.data()), compressedSize);
+}
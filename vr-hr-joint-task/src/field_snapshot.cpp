@@ -0,0 +1,75 @@
+#include "field_snapshot.h"
+
+#include <algorithm>
+
+FieldSnapshot::FieldSnapshot()
+	: middle(1), back(0), front(2)
+{}
+
+int FieldSnapshot::addSource(const std::shared_ptr<dnf_composer::Simulation>& simulation,
+	const std::string& element, const std::string& component)
+{
+	const std::vector<double>* source = simulation->getComponentPtr(element, component);
+	if (source == nullptr)
+		return -1;
+	keys.emplace_back(element, component);
+	sources.push_back(source);
+	for (auto& slot : slots)
+		slot.columns.emplace_back(source->size(), 0.0);
+	return static_cast<int>(sources.size()) - 1;
+}
+
+int FieldSnapshot::indexOf(const std::string& element, const std::string& component) const
+{
+	const auto it = std::find(keys.begin(), keys.end(), std::make_pair(element, component));
+	return it == keys.end() ? -1 : static_cast<int>(it - keys.begin());
+}
+
+void FieldSnapshot::publish(uint64_t step)
+{
+	Slot& slot = slots[back];
+	for (size_t i = 0; i < sources.size(); ++i)
+		std::copy_n(sources[i]->begin(), std::min(sources[i]->size(), slot.columns[i].size()), slot.columns[i].begin());
+	slot.step = step;
+	back = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel) & INDEX;
+}
+
+bool FieldSnapshot::acquire()
+{
+	if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+		return false;
+	front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+	return true;
+}
+
+SnapshotElement::SnapshotElement(const dnf_composer::element::ElementCommonParameters& parameters,
+	std::shared_ptr<FieldSnapshot> snapshot)
+	: Element(parameters), snapshot(std::move(snapshot))
+{
+	const std::string name = getUniqueName();
+	for (const char* component : { "activation", "input", "output" })
+	{
+		const int column = this->snapshot->indexOf(name, component);
+		if (column < 0)
+			continue;
+		mirroredComponents.emplace_back(component, column);
+		components[component] = std::vector<double>(this->snapshot->get(column).size(), 0.0);
+	}
+}
+
+void SnapshotElement::init()
+{}
+
+void SnapshotElement::step(double, double)
+{
+	for (const auto& [component, column] : mirroredComponents)
+		components[component] = snapshot->get(column);
+}
+
+void SnapshotElement::printParameters()
+{}
+
+std::shared_ptr<dnf_composer::element::Element> SnapshotElement::clone() const
+{
+	return std::make_shared<SnapshotElement>(*this);
+}
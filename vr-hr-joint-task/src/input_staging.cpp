@@ -0,0 +1,114 @@
+#include "input_staging.h"
+
+#include <limits>
+#include <string>
+
+InputStaging::InputStaging()
+	: middle(1), back(0), front(2), sequence(0)
+{}
+
+uint64_t InputStaging::publish(const InputFrame& frame)
+{
+	InputFrame& slot = slots[back];
+	slot = frame;
+	slot.sequence = ++sequence;
+	slot.published = InputFrame::Clock::now();
+	back = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel) & INDEX;
+	return sequence;
+}
+
+bool InputStaging::acquire()
+{
+	if ((middle.load(std::memory_order_relaxed) & FRESH) == 0)
+		return false;
+	front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+	return true;
+}
+
+InputEncoder::InputEncoder(DnfArchitectureType dnf, const DnfArchitectureDescription& description)
+	: dnf(dnf), handPrevious(0, 0, 0), hasPrevious(false)
+{
+	const auto initial = [&description](const std::string& name) {
+		const DnfElementDescription* element = description.find(name);
+		return element != nullptr ? StimulusInput{ element->amplitude, element->position } : StimulusInput{};
+	};
+	switch (dnf)
+	{
+	case DnfArchitectureType::HAND_MOTION:
+		frame.handStimulusCount = 1;
+		frame.hand[0] = initial("hand position stimulus");
+		break;
+	case DnfArchitectureType::ACTION_LIKELIHOOD:
+		frame.handStimulusCount = static_cast<int>(frame.hand.size());
+		for (size_t i = 0; i < frame.hand.size(); ++i)
+			frame.hand[i] = initial("hand position stimulus " + std::to_string(i + 1));
+		break;
+	}
+	for (size_t i = 0; i < frame.hand.size(); ++i)
+		handLikelihood[i] = frame.hand[i].amplitude;
+}
+
+const InputFrame& InputEncoder::encode(const Position& handPosition, bool object1, bool object2, bool object3)
+{
+	return encode(handPosition, object1, object2, object3, InputFrame::Clock::now());
+}
+
+const InputFrame& InputEncoder::encode(const Position& handPosition, bool object1, bool object2, bool object3,
+	InputFrame::Clock::time_point time)
+{
+	switch (dnf)
+	{
+	case DnfArchitectureType::HAND_MOTION:
+		encodeHandMotion(handPosition);
+		break;
+	case DnfArchitectureType::ACTION_LIKELIHOOD:
+		encodeActionLikelihood(handPosition, time);
+		break;
+	}
+	return encodeObjects(object1, object2, object3);
+}
+
+const InputFrame& InputEncoder::encodeObjects(bool object1, bool object2, bool object3)
+{
+	frame.objectPresent = { object1, object2, object3 };
+	// Only objects that are there can be reached for.
+	if (dnf == DnfArchitectureType::ACTION_LIKELIHOOD)
+		for (size_t i = 0; i < frame.hand.size(); ++i)
+			frame.hand[i].amplitude = frame.objectPresent[i] ? handLikelihood[i] : 0.0;
+	return frame;
+}
+
+void InputEncoder::encodeActionLikelihood(const Position& position, InputFrame::Clock::time_point currentTime)
+{
+	if (!hasPrevious)
+	{
+		handPrevious = position;
+		lastTime = currentTime;
+		hasPrevious = true;
+		return;
+	}
+	const double scalar = likelihood.scalar;
+
+	const std::chrono::duration<double> elapsed = currentTime - lastTime;
+	const double deltaTime = elapsed.count();
+
+	// Check if elapsed time is too small
+	if (deltaTime < std::numeric_limits<double>::epsilon())
+		return;
+
+	const std::array<double, 3> likelihoods = calculateLikelihoodOfHumanActions(position, handPrevious, deltaTime, likelihood);
+	for (size_t i = 0; i < likelihoods.size(); ++i)
+		handLikelihood[i] = scalar * likelihoods[i];
+
+	handPrevious = position;
+	lastTime = currentTime;
+}
+
+void InputEncoder::encodeHandMotion(const Position& position)
+{
+	const double proximity = calculateHandProximityToObjects(
+		calculateHandDistanceToObjects(position));
+	const double y = normalizeHandPosition(position.y);
+
+	frame.hand[0] = { proximity, y };
+}
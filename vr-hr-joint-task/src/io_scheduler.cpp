@@ -0,0 +1,102 @@
+#include "io_scheduler.h"
+
+#include <algorithm>
+
+IoScheduler::IoScheduler()
+	: stopRequested(false)
+{}
+
+int IoScheduler::add(const std::string& name, int priority, TaskFunction function)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	tasks.push_back({ name, priority, std::move(function), Clock::now(), false, &Metrics::loop("io." + name) });
+	return static_cast<int>(tasks.size()) - 1;
+}
+
+int IoScheduler::addPeriodic(const std::string& name, int priority, double rate, std::function<void()> function)
+{
+	const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(rate, 1e-3)));
+	return add(name, priority, [function = std::move(function), period](Clock::time_point due) {
+		function();
+		// Keep the cadence, but do not burst to catch up after a stall.
+		return std::max(due + period, Clock::now());
+	});
+}
+
+void IoScheduler::run(const std::function<bool()>& keepRunning)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const auto start = Clock::now();
+	for (auto& task : tasks)
+	{
+		task.due = start;
+		task.triggered = false;
+	}
+
+	while (!stopRequested)
+	{
+		lock.unlock();
+		const bool running = keepRunning();
+		lock.lock();
+		if (!running || stopRequested)
+			break;
+
+		const auto now = Clock::now();
+		const int index = findNextTask(now);
+		if (index < 0)
+		{
+			wakeUp.wait_until(lock, getEarliestDue());
+			continue;
+		}
+
+		Task& task = tasks[index];
+		task.triggered = false;
+		const auto due = task.due;
+		lock.unlock();
+		task.meter->tick();
+		const auto next = task.function(due);
+		lock.lock();
+		task.due = task.triggered ? std::min(next, Clock::now()) : next;
+	}
+}
+
+void IoScheduler::trigger(int task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks[task].due = std::min(tasks[task].due, Clock::now());
+		tasks[task].triggered = true;
+	}
+	wakeUp.notify_one();
+}
+
+void IoScheduler::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopRequested = true;
+	}
+	wakeUp.notify_all();
+}
+
+int IoScheduler::findNextTask(Clock::time_point now) const
+{
+	int next = -1;
+	for (size_t i = 0; i < tasks.size(); ++i)
+	{
+		if (tasks[i].due > now)
+			continue;
+		if (next < 0 || tasks[i].priority < tasks[next].priority
+			|| (tasks[i].priority == tasks[next].priority && tasks[i].due < tasks[next].due))
+			next = static_cast<int>(i);
+	}
+	return next;
+}
+
+IoScheduler::Clock::time_point IoScheduler::getEarliestDue() const
+{
+	Clock::time_point earliest = Clock::time_point::max();
+	for (const auto& task : tasks)
+		earliest = std::min(earliest, task.due);
+	return earliest;
+}
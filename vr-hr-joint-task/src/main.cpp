@@ -4,16 +4,21 @@
 
 
 #include "experiment.h"
+#include "startup_profile.h"
 
 int main(int argc, char* argv[])
 {
+	StartupProfile::start();
 
 	try
 	{
 		constexpr double deltaT = 65;
 		constexpr DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION;
 
-		const ExperimentParameters params{architecture, deltaT};
+		ExperimentParameters params{architecture, deltaT};
+		// SOCKET for the legacy remote API, SHARED_MEMORY for a peer on this host,
+		// REPLAY to serve params.transport.replayFile instead of a scene.
+		params.transport.type = TransportType::SOCKET;
 		Experiment experiment(params);
 
 		experiment.init();
@@ -0,0 +1,124 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: address(nullptr), size(0), opened(false)
+#ifdef _WIN32
+	, file(nullptr), mapping(nullptr)
+#else
+	, fd(-1)
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		file = nullptr;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		close();
+		return false;
+	}
+	size = static_cast<size_t>(fileSize.QuadPart);
+	opened = true;
+	if (size == 0)
+		return true; // empty files cannot be mapped
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+	address = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (address == nullptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (address != nullptr)
+		UnmapViewOfFile(address);
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	if (file != nullptr)
+		CloseHandle(file);
+	address = nullptr;
+	mapping = nullptr;
+	file = nullptr;
+	size = 0;
+	opened = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info{};
+	if (fstat(fd, &info) != 0)
+	{
+		close();
+		return false;
+	}
+	size = static_cast<size_t>(info.st_size);
+	opened = true;
+	if (size == 0)
+		return true; // empty files cannot be mapped
+
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	address = static_cast<const char*>(mapped);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (address != nullptr)
+		munmap(const_cast<char*>(address), size);
+	if (fd >= 0)
+		::close(fd);
+	address = nullptr;
+	fd = -1;
+	size = 0;
+	opened = false;
+}
+
+#endif
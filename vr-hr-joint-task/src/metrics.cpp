@@ -0,0 +1,235 @@
+#include "metrics.h"
+
+#include <bit>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include "thread_layout.h"
+
+std::map<std::string, std::unique_ptr<Counter>> Metrics::counters;
+std::map<std::string, std::unique_ptr<Gauge>> Metrics::gauges;
+std::map<std::string, std::unique_ptr<Histogram>> Metrics::histograms;
+std::map<std::string, std::unique_ptr<LoopMeter>> Metrics::loops;
+std::mutex Metrics::mutex;
+std::thread Metrics::exporterThread;
+std::condition_variable Metrics::exporterWakeUp;
+bool Metrics::exporterRunning = false;
+
+int Histogram::bucketOf(uint64_t nanoseconds)
+{
+	if (nanoseconds < 4)
+		return static_cast<int>(nanoseconds);
+	const int msb = std::bit_width(nanoseconds) - 1;
+	const int sub = static_cast<int>((nanoseconds >> (msb - 2)) & 3);
+	return msb * 4 + sub;
+}
+
+uint64_t Histogram::upperBoundOf(int bucket)
+{
+	if (bucket < 4)
+		return static_cast<uint64_t>(bucket) + 1;
+	const int msb = bucket / 4;
+	const uint64_t sub = static_cast<uint64_t>(bucket % 4);
+	return (4 + sub + 1) << (msb - 2);
+}
+
+void Histogram::record(uint64_t nanoseconds)
+{
+	std::atomic<uint64_t>& bucket = buckets[bucketOf(nanoseconds)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	sum.store(sum.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+	if (nanoseconds > maximum.load(std::memory_order_relaxed))
+		maximum.store(nanoseconds, std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::snapshot() const
+{
+	HistogramSnapshot result;
+	std::array<uint64_t, BUCKETS> counts{};
+	uint64_t total = 0;
+	for (int i = 0; i < BUCKETS; ++i)
+	{
+		counts[i] = buckets[i].load(std::memory_order_relaxed);
+		total += counts[i];
+	}
+	result.count = total;
+	if (total == 0)
+		return result;
+
+	result.mean = static_cast<double>(sum.load(std::memory_order_relaxed)) / static_cast<double>(total);
+	result.max = static_cast<double>(maximum.load(std::memory_order_relaxed));
+
+	const auto percentile = [&](double fraction) {
+		const auto rank = static_cast<uint64_t>(fraction * static_cast<double>(total));
+		uint64_t seen = 0;
+		for (int i = 0; i < BUCKETS; ++i)
+		{
+			seen += counts[i];
+			if (seen > rank)
+				return std::min(static_cast<double>(upperBoundOf(i)), result.max);
+		}
+		return result.max;
+	};
+	result.p50 = percentile(0.50);
+	result.p90 = percentile(0.90);
+	result.p99 = percentile(0.99);
+	return result;
+}
+
+void LoopMeter::tick()
+{
+	const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	iterations.increment();
+	if (lastTick != 0)
+	{
+		const int64_t currentPeriod = now - lastTick;
+		period.record(static_cast<uint64_t>(currentPeriod));
+		if (lastPeriod != 0)
+			jitter.record(static_cast<uint64_t>(std::abs(currentPeriod - lastPeriod)));
+		lastPeriod = currentPeriod;
+	}
+	lastTick = now;
+}
+
+Counter& Metrics::counter(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& instrument = counters[name];
+	if (!instrument)
+		instrument = std::make_unique<Counter>();
+	return *instrument;
+}
+
+Gauge& Metrics::gauge(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& instrument = gauges[name];
+	if (!instrument)
+		instrument = std::make_unique<Gauge>();
+	return *instrument;
+}
+
+Histogram& Metrics::histogram(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& instrument = histograms[name];
+	if (!instrument)
+		instrument = std::make_unique<Histogram>();
+	return *instrument;
+}
+
+LoopMeter& Metrics::loop(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& instrument = loops[name];
+	if (!instrument)
+		instrument = std::make_unique<LoopMeter>();
+	return *instrument;
+}
+
+static std::string formatMicroseconds(const HistogramSnapshot& snapshot)
+{
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(1)
+		<< "count " << snapshot.count
+		<< "  mean " << snapshot.mean / 1e3
+		<< "  p50 " << snapshot.p50 / 1e3
+		<< "  p90 " << snapshot.p90 / 1e3
+		<< "  p99 " << snapshot.p99 / 1e3
+		<< "  max " << snapshot.max / 1e3 << " us";
+	return ss.str();
+}
+
+std::string Metrics::format(double elapsedSeconds, std::map<std::string, uint64_t>& previousIterations)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(1);
+
+	ss << "[loops]\n";
+	for (const auto& [name, meter] : loops)
+	{
+		const uint64_t iterations = meter->getIterations();
+		const double rate = elapsedSeconds > 0 ? static_cast<double>(iterations - previousIterations[name]) / elapsedSeconds : 0;
+		previousIterations[name] = iterations;
+		ss << name << "\n"
+			<< "  rate " << rate << " /s, iterations " << iterations << "\n"
+			<< "  period " << formatMicroseconds(meter->periodSnapshot()) << "\n"
+			<< "  jitter " << formatMicroseconds(meter->jitterSnapshot()) << "\n";
+	}
+
+	ss << "[latencies]\n";
+	for (const auto& [name, histogram] : histograms)
+		ss << name << "  " << formatMicroseconds(histogram->snapshot()) << "\n";
+
+	ss << "[counters]\n";
+	for (const auto& [name, counter] : counters)
+		ss << name << "  " << counter->get() << "\n";
+
+	ss << "[gauges]\n";
+	for (const auto& [name, gauge] : gauges)
+		ss << name << "  " << gauge->get() << "\n";
+
+	return ss.str();
+}
+
+void Metrics::startExporter(const std::string& directory, std::chrono::milliseconds period)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (exporterRunning)
+			return;
+		exporterRunning = true;
+	}
+	exporterThread = std::thread(&Metrics::exporterLoop, directory, period);
+}
+
+void Metrics::stopExporter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		exporterRunning = false;
+	}
+	exporterWakeUp.notify_all();
+	if (exporterThread.joinable())
+		exporterThread.join();
+}
+
+void Metrics::exporterLoop(std::string directory, std::chrono::milliseconds period)
+{
+	ThreadLayout::applyToCurrentThread("metrics");
+
+	const std::filesystem::path statsFile = std::filesystem::path(directory) / "stats.txt";
+	const std::filesystem::path tempFile = std::filesystem::path(directory) / "stats.txt.tmp";
+	std::map<std::string, uint64_t> previousIterations;
+	auto lastExport = std::chrono::steady_clock::now();
+	const auto start = lastExport;
+	bool running = true;
+
+	while (running)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			exporterWakeUp.wait_for(lock, period, [] { return !exporterRunning; });
+			running = exporterRunning;
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		const double elapsed = std::chrono::duration<double>(now - lastExport).count();
+		lastExport = now;
+
+		{
+			std::ofstream file(tempFile, std::ofstream::out | std::ofstream::trunc);
+			file << "uptime " << std::fixed << std::setprecision(1)
+				<< std::chrono::duration<double>(now - start).count() << " s\n"
+				<< format(elapsed, previousIterations);
+		}
+		// Readers always see a complete file.
+		std::error_code error;
+		std::filesystem::rename(tempFile, statsFile, error);
+	}
+}
@@ -1,5 +1,7 @@
 #include "misc.h"
 
+#include <algorithm>
+
 
 double calculateEuclideanDistance(const Position& a, const Position& b)
 {
@@ -28,4 +30,62 @@ double calculateLikelihoodOfHumanAction(const Position& handPos, const Position&
 	return likelihood;
 }
 
+const std::array<Position, 3>& getTableObjectPositions()
+{
+	static const std::array<Position, 3> positions = { {
+		{ 0.000,  0.125, 0.716 },
+		{ 0.000,  0.000, 0.716 },
+		{ 0.000, -0.125, 0.716 },
+	} };
+	return positions;
+}
+
+std::array<double, 3> calculateLikelihoodOfHumanActions(const Position& handPos, const Position& handPosPrev, double deltaTime,
+	const LikelihoodParameters& parameters)
+{
+	const double tau = parameters.tau;
+	const double sigma = parameters.sigma;
+	const auto& objects = getTableObjectPositions();
+
+	return {
+		calculateLikelihoodOfHumanAction(handPos, handPosPrev, objects[0], deltaTime, tau, sigma),
+		calculateLikelihoodOfHumanAction(handPos, handPosPrev, objects[1], deltaTime, tau, sigma),
+		calculateLikelihoodOfHumanAction(handPos, handPosPrev, objects[2], deltaTime, tau, sigma)
+	};
+}
+
+double calculateHandDistanceToObjects(const Position& position)
+{
+	// Table center and dimensions
+	static constexpr double tableCenterX = 0.0;
+	static constexpr double tableCenterZ = 0.641 + 0.08;
+
+	const double distanceX = std::abs(position.x - tableCenterX);
+	const double distanceZ = std::abs(position.z - tableCenterZ);
+	const double distance = std::sqrt(distanceX * distanceX + distanceZ * distanceZ);
 
+	return distance;
+}
+
+double calculateHandProximityToObjects(double distance)
+{
+	// Ensure distance is always greater than zero to avoid division by zero
+	static constexpr double safeZone = 0.01;
+	distance = std::max(distance, safeZone);
+	return 1.0 / distance;
+}
+
+double normalizeHandPosition(double handPositionY)
+{
+	// Define the min and max of the table in Y dimension
+	static constexpr double yMin = -0.25;
+	static constexpr double yMax = 0.25;
+	// Define the min and max of the scale
+	static constexpr double scaleMin = 0;
+	static constexpr double scaleMax = 50;
+
+	// Normalize posY to the 0-50 scale
+	const double normalizedScale = scaleMin + (scaleMax - scaleMin) * (handPositionY - yMin) / (yMax - yMin);
+
+	return normalizedScale;
+}
@@ -0,0 +1,229 @@
+#include "parallel_stepper.h"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+
+#include "thread_layout.h"
+
+StepGraph::StepGraph(const std::shared_ptr<dnf_composer::Simulation>& simulation)
+	: levelCount(0)
+{
+	using namespace dnf_composer::element;
+
+	const auto& elements = simulation->elements;
+	std::unordered_map<const Element*, int> indices;
+	for (size_t i = 0; i < elements.size(); ++i)
+	{
+		indices[elements[i].get()] = static_cast<int>(i);
+		names.push_back(elements[i]->getUniqueName());
+	}
+
+	dependencies.resize(elements.size());
+	const auto addEdge = [this](int from, int to) {
+		auto& list = dependencies[std::max(from, to)];
+		const int lower = std::min(from, to);
+		if (from != to && std::find(list.begin(), list.end(), lower) == list.end())
+			list.push_back(lower);
+	};
+	int previousNoise = -1;
+	for (size_t i = 0; i < elements.size(); ++i)
+	{
+		for (const auto& input : elements[i]->getInputs())
+		{
+			const auto it = indices.find(input.get());
+			if (it != indices.end())
+				addEdge(it->second, static_cast<int>(i));
+		}
+		// Noise generators may draw from a shared random engine; keep their serial order.
+		if (elements[i]->getLabel() == NORMAL_NOISE)
+		{
+			if (previousNoise >= 0)
+				addEdge(previousNoise, static_cast<int>(i));
+			previousNoise = static_cast<int>(i);
+		}
+	}
+
+	levels.resize(elements.size(), 0);
+	for (size_t i = 0; i < elements.size(); ++i)
+	{
+		for (const int dependency : dependencies[i])
+			levels[i] = std::max(levels[i], levels[dependency] + 1);
+		levelCount = std::max(levelCount, levels[i] + 1);
+	}
+}
+
+std::string StepGraph::toString() const
+{
+	std::stringstream ss;
+	for (int level = 0; level < levelCount; ++level)
+	{
+		ss << "level " << level << ":";
+		for (size_t i = 0; i < levels.size(); ++i)
+			if (levels[i] == level)
+				ss << " [" << names[i] << "]";
+		ss << "\n";
+	}
+	return ss.str();
+}
+
+SpinBarrier::SpinBarrier(uint32_t participants)
+	: participants(participants), arrived(0), phase(0)
+{}
+
+void SpinBarrier::arriveAndWait()
+{
+	const uint32_t current = phase.load(std::memory_order_acquire);
+	if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == participants)
+	{
+		arrived.store(0, std::memory_order_relaxed);
+		phase.store(current + 1, std::memory_order_release);
+		return;
+	}
+	for (int spins = 0; phase.load(std::memory_order_acquire) == current; ++spins)
+		if (spins > 4096)
+			std::this_thread::yield();
+}
+
+namespace
+{
+	// Spinning workers must never share a CPU.
+	int clampWorkerCount(int requested)
+	{
+		const int available = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+		return std::clamp(requested, 1, available);
+	}
+}
+
+ParallelStepper::ParallelStepper(const std::shared_ptr<dnf_composer::Simulation>& simulation, int workerCount)
+	: simulation(simulation)
+	, graph(simulation)
+	, workerCount(clampWorkerCount(workerCount))
+	, barrier(static_cast<uint32_t>(clampWorkerCount(workerCount)))
+	, generation(0)
+	, stopping(false)
+	, t(0)
+	, deltaT(simulation->getDeltaT())
+{
+	buildPlan();
+}
+
+ParallelStepper::~ParallelStepper()
+{
+	stop();
+}
+
+double ParallelStepper::estimateCost(const std::shared_ptr<dnf_composer::element::Element>& element)
+{
+	using namespace dnf_composer::element;
+
+	// Kernels convolve the whole field; everything else is linear in the field size.
+	const double size = std::max(1, element->getSize());
+	switch (element->getLabel())
+	{
+	case GAUSS_KERNEL:
+	case MEXICAN_HAT_KERNEL:
+	case LATERAL_INTERACTIONS:
+	case GAUSS_FIELD_COUPLING:
+	case FIELD_COUPLING:
+		return size * size;
+	default:
+		return size;
+	}
+}
+
+void ParallelStepper::buildPlan()
+{
+	// Longest-processing-time-first assignment of each level onto the workers.
+	const auto& elements = simulation->elements;
+	plan.assign(workerCount, std::vector<std::vector<int>>(graph.getLevelCount()));
+	for (int level = 0; level < graph.getLevelCount(); ++level)
+	{
+		std::vector<int> members;
+		for (int i = 0; i < graph.getElementCount(); ++i)
+			if (graph.getLevel(i) == level)
+				members.push_back(i);
+		std::stable_sort(members.begin(), members.end(), [&](int a, int b) {
+			return estimateCost(elements[a]) > estimateCost(elements[b]);
+		});
+
+		std::vector<double> load(workerCount, 0.0);
+		for (const int element : members)
+		{
+			const auto worker = std::min_element(load.begin(), load.end()) - load.begin();
+			load[worker] += estimateCost(elements[element]);
+			plan[worker][level].push_back(element);
+		}
+	}
+}
+
+void ParallelStepper::start()
+{
+	stop();
+	t = simulation->getT();
+	{
+		// New workers start from generation 0, so a restarted stepper counts from there too.
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = false;
+		generation = 0;
+	}
+	for (int worker = 1; worker < workerCount; ++worker)
+		workers.emplace_back(&ParallelStepper::runWorker, this, worker);
+}
+
+void ParallelStepper::step()
+{
+	t += deltaT;
+	if (!workers.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			generation++;
+		}
+		stepRequested.notify_all();
+	}
+	runLevels(0);
+}
+
+void ParallelStepper::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	stepRequested.notify_all();
+	for (auto& worker : workers)
+		if (worker.joinable())
+			worker.join();
+	workers.clear();
+}
+
+void ParallelStepper::runWorker(int worker)
+{
+	ThreadLayout::applyToCurrentThread("stepWorker" + std::to_string(worker));
+
+	uint64_t seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			stepRequested.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+		}
+		runLevels(worker);
+	}
+}
+
+void ParallelStepper::runLevels(int worker)
+{
+	const auto& elements = simulation->elements;
+	for (const auto& level : plan[worker])
+	{
+		for (const int element : level)
+			elements[element]->step(t, deltaT);
+		barrier.arriveAndWait();
+	}
+}
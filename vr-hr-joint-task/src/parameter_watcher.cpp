@@ -0,0 +1,257 @@
+#include "parameter_watcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+#include <tools/logger.h>
+
+#include "event_logger.h"
+#include "profile_cache.h"
+#include "thread_layout.h"
+
+namespace
+{
+	bool isKernel(DnfElementType type)
+	{
+		return type == DnfElementType::GAUSS_KERNEL || type == DnfElementType::LATERAL_INTERACTIONS;
+	}
+
+	// The parameter of element a file entry names, nullptr if the element has no such parameter.
+	double* kernelParameter(DnfElementDescription& element, const std::string& key)
+	{
+		if (key == "sigma")
+			return &element.sigma;
+		if (key == "amplitude")
+			return &element.amplitude;
+		if (element.type != DnfElementType::LATERAL_INTERACTIONS)
+			return nullptr;
+		if (key == "sigmaInhibitory")
+			return &element.sigmaInhibitory;
+		if (key == "amplitudeInhibitory")
+			return &element.amplitudeInhibitory;
+		if (key == "amplitudeGlobal")
+			return &element.amplitudeGlobal;
+		return nullptr;
+	}
+
+	bool sameKernel(const DnfElementDescription& a, const DnfElementDescription& b)
+	{
+		return a.sigma == b.sigma && a.amplitude == b.amplitude && a.sigmaInhibitory == b.sigmaInhibitory
+			&& a.amplitudeInhibitory == b.amplitudeInhibitory && a.amplitudeGlobal == b.amplitudeGlobal;
+	}
+}
+
+std::string ArchitectureUpdate::toString() const
+{
+	std::stringstream ss;
+	ss << "v" << version << " (";
+	for (size_t i = 0; i < changedElements.size(); ++i)
+		ss << (i ? ", " : "") << description.elements[changedElements[i]].name;
+	if (likelihoodChanged)
+		ss << (changedElements.empty() ? "" : ", ") << "likelihood tau = " << likelihood.tau
+			<< ", sigma = " << likelihood.sigma << ", scalar = " << likelihood.scalar;
+	ss << ")";
+	return ss.str();
+}
+
+ParameterWatcher::ParameterWatcher(const ParameterWatcherParameters& parameters, const DnfArchitectureDescription& base)
+	: parameters(parameters)
+	, base(base)
+	, seen(false)
+	, stopRequested(false)
+{
+	auto initial = std::make_shared<ArchitectureUpdate>();
+	initial->description = base;
+	current = std::move(initial);
+}
+
+ParameterWatcher::~ParameterWatcher()
+{
+	stop();
+}
+
+void ParameterWatcher::start(Listener listener)
+{
+	this->listener = std::move(listener);
+	if (!std::filesystem::exists(parameters.file))
+		log(dnf_composer::tools::logger::LogLevel::INFO, "No architecture parameters found at " + parameters.file
+			+ ", using the built-in ones until the file appears.\n");
+	poll();
+	stopRequested = false;
+	thread = std::thread(&ParameterWatcher::run, this);
+}
+
+void ParameterWatcher::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopRequested = true;
+	}
+	wakeUp.notify_all();
+	if (thread.joinable())
+		thread.join();
+}
+
+void ParameterWatcher::run()
+{
+	ThreadLayout::applyToCurrentThread("parameters");
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!wakeUp.wait_for(lock, parameters.pollPeriod, [this] { return stopRequested; }))
+	{
+		lock.unlock();
+		poll();
+		lock.lock();
+	}
+}
+
+void ParameterWatcher::poll()
+{
+	std::error_code error;
+	const auto modified = std::filesystem::last_write_time(parameters.file, error);
+	if (error || (seen && modified == lastModified))
+		return;
+	seen = true;
+	lastModified = modified;
+
+	std::ifstream file(parameters.file);
+	std::stringstream text;
+	text << file.rdbuf();
+	std::string reason;
+	const auto update = parse(text.str(), base, *current, reason);
+	if (!update)
+	{
+		log(dnf_composer::tools::logger::LogLevel::WARNING, "Architecture parameters rejected: " + reason + "\n");
+		EventLogger::log(LogLevel::CONTROL, "Architecture parameters in " + parameters.file + " rejected: " + reason + ".");
+		return;
+	}
+	if (update->changedElements.empty() && !update->likelihoodChanged)
+		return;
+
+	current = update;
+	EventLogger::log(LogLevel::CONTROL, "Architecture parameters " + update->toString() + " staged.");
+	if (listener)
+		listener(update);
+}
+
+std::shared_ptr<ArchitectureUpdate> ParameterWatcher::parse(const std::string& text, const DnfArchitectureDescription& base,
+	const ArchitectureUpdate& previous, std::string& error, bool skipUnknownElements)
+{
+	auto update = std::make_shared<ArchitectureUpdate>();
+	update->version = previous.version + 1;
+	update->description = base;
+	update->source = text;
+	DnfArchitectureDescription& description = update->description;
+
+	const auto number = [&error](const std::string& what, const nlohmann::json& value, double& target) {
+		if (!value.is_number() || !std::isfinite(value.get<double>()))
+		{
+			error = what + " is not a finite number";
+			return false;
+		}
+		target = value.get<double>();
+		return true;
+	};
+
+	try
+	{
+		const nlohmann::json config = nlohmann::json::parse(text);
+		if (!config.is_object())
+		{
+			error = "the file does not hold a JSON object";
+			return nullptr;
+		}
+		for (const auto& [key, value] : config.items())
+		{
+			if (key != "elements" && key != "likelihood")
+			{
+				error = "unknown entry '" + key + "'";
+				return nullptr;
+			}
+		}
+
+		const nlohmann::json elements = config.value("elements", nlohmann::json::object());
+		for (const auto& [name, entry] : elements.items())
+		{
+			auto element = std::find_if(description.elements.begin(), description.elements.end(),
+				[&name](const DnfElementDescription& e) { return e.name == name; });
+			if (skipUnknownElements && (element == description.elements.end() || !isKernel(element->type)))
+				continue;
+			if (element == description.elements.end())
+			{
+				error = "the architecture has no element '" + name + "'";
+				return nullptr;
+			}
+			if (!isKernel(element->type))
+			{
+				error = "'" + name + "' is not a kernel; only kernel parameters can change at run time";
+				return nullptr;
+			}
+			if (!entry.is_object())
+			{
+				error = "the entry of '" + name + "' is not an object";
+				return nullptr;
+			}
+			for (const auto& [key, value] : entry.items())
+			{
+				double* target = kernelParameter(*element, key);
+				if (target == nullptr)
+				{
+					error = "'" + name + "' has no parameter '" + key + "'";
+					return nullptr;
+				}
+				if (!number(name + "." + key, value, *target))
+					return nullptr;
+			}
+			// Widths must give a kernel that fits the field.
+			const auto validWidth = [&description](double sigma) { return sigma > 0 && sigma <= description.xMax; };
+			if (!validWidth(element->sigma)
+				|| (element->type == DnfElementType::LATERAL_INTERACTIONS && !validWidth(element->sigmaInhibitory)))
+			{
+				error = "a width of '" + name + "' is not positive or is wider than the field";
+				return nullptr;
+			}
+		}
+
+		const nlohmann::json likelihood = config.value("likelihood", nlohmann::json::object());
+		for (const auto& [key, value] : likelihood.items())
+		{
+			double* target = key == "tau" ? &update->likelihood.tau
+				: key == "sigma" ? &update->likelihood.sigma
+				: key == "scalar" ? &update->likelihood.scalar : nullptr;
+			if (target == nullptr)
+			{
+				error = "the likelihood has no parameter '" + key + "'";
+				return nullptr;
+			}
+			if (!number("likelihood." + key, value, *target))
+				return nullptr;
+		}
+		if (update->likelihood.tau < 0 || update->likelihood.sigma <= 0)
+		{
+			error = "the likelihood needs tau >= 0 and sigma > 0";
+			return nullptr;
+		}
+	}
+	catch (const nlohmann::json::exception& e)
+	{
+		error = e.what();
+		return nullptr;
+	}
+
+	for (size_t i = 0; i < description.elements.size(); ++i)
+	{
+		const DnfElementDescription& element = description.elements[i];
+		if (!isKernel(element.type) || sameKernel(element, previous.description.elements[i]))
+			continue;
+		update->changedElements.push_back(static_cast<int>(i));
+		update->kernelProfiles.push_back(ProfileCache::kernel<double>(element, description.dx, description.getSize()));
+		update->kernelProfiles.push_back(ProfileCache::kernel<float>(element, description.dx, description.getSize()));
+	}
+	update->likelihoodChanged = update->likelihood.tau != previous.likelihood.tau
+		|| update->likelihood.sigma != previous.likelihood.sigma
+		|| update->likelihood.scalar != previous.likelihood.scalar;
+	return update;
+}
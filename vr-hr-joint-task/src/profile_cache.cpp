@@ -0,0 +1,131 @@
+#include "profile_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "metrics.h"
+
+std::mutex ProfileCache::mutex;
+std::unordered_map<ProfileCache::Key, ProfileCache::Entry, ProfileCache::KeyHash> ProfileCache::entries;
+size_t ProfileCache::insertsSinceSweep = 0;
+
+size_t ProfileCache::KeyHash::operator()(const Key& key) const
+{
+	size_t hash = std::hash<int>()(static_cast<int>(key.type));
+	const auto combine = [&hash](size_t value) { hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2); };
+	combine(std::hash<int>()(key.size));
+	combine(std::hash<int>()(key.storageBytes));
+	for (const double parameter : key.parameters)
+		combine(std::hash<double>()(parameter));
+	return hash;
+}
+
+template <typename T, typename Compute>
+ProfileHandle<T> ProfileCache::getOrCompute(const Key& key, Compute compute)
+{
+	static Counter& hits = Metrics::counter("profileCache.hits");
+	static Counter& misses = Metrics::counter("profileCache.misses");
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const auto it = entries.find(key);
+		if (it != entries.end())
+			if (auto profile = it->second.profile.lock())
+			{
+				hits.increment();
+				return std::static_pointer_cast<const std::vector<T>>(profile);
+			}
+	}
+
+	// Computed outside the lock; if another thread got there first its copy wins.
+	auto computed = std::make_shared<const std::vector<T>>(compute());
+	std::lock_guard<std::mutex> lock(mutex);
+	Entry& entry = entries[key];
+	if (auto profile = entry.profile.lock())
+	{
+		hits.increment();
+		return std::static_pointer_cast<const std::vector<T>>(profile);
+	}
+	misses.increment();
+	entry = { computed, computed->size() * sizeof(T) };
+
+	// Drop expired entries once the map has had as many inserts as it holds entries.
+	if (++insertsSinceSweep > std::max<size_t>(64, entries.size()))
+	{
+		std::erase_if(entries, [](const auto& item) { return item.second.profile.expired(); });
+		insertsSinceSweep = 0;
+	}
+	return computed;
+}
+
+template <typename T>
+ProfileHandle<T> ProfileCache::kernel(const DnfElementDescription& element, double dx, int size)
+{
+	const bool lateral = element.type == DnfElementType::LATERAL_INTERACTIONS;
+	const Key key{ element.type, size, static_cast<int>(sizeof(T)),
+		{ element.sigma, element.amplitude, lateral ? element.sigmaInhibitory : 0, lateral ? element.amplitudeInhibitory : 0, dx, 0 } };
+
+	return getOrCompute<T>(key, [&] {
+		const double widest = lateral ? std::max(element.sigma, element.sigmaInhibitory) : element.sigma;
+		const int radius = std::min(size - 1, static_cast<int>(std::ceil(5 * widest / dx)));
+		std::vector<T> weights(2 * radius + 1);
+		for (int k = -radius; k <= radius; ++k)
+		{
+			const double distance = k * dx;
+			double weight = element.amplitude * std::exp(-0.5 * distance * distance / (element.sigma * element.sigma));
+			if (lateral)
+				weight -= element.amplitudeInhibitory
+					* std::exp(-0.5 * distance * distance / (element.sigmaInhibitory * element.sigmaInhibitory));
+			weights[k + radius] = static_cast<T>(weight);
+		}
+		return weights;
+	});
+}
+
+template <typename T>
+ProfileHandle<T> ProfileCache::stimulus(const DnfElementDescription& element, double dx, double xMax, int size, bool circular)
+{
+	const Key key{ DnfElementType::GAUSS_STIMULUS, size, static_cast<int>(sizeof(T)),
+		{ element.sigma, element.amplitude, element.position, dx, xMax, circular ? 1.0 : 0.0 } };
+
+	return getOrCompute<T>(key, [&] {
+		std::vector<T> samples(size);
+		sampleStimulus(element, dx, xMax, size, circular, samples.data());
+		return samples;
+	});
+}
+
+template <typename T>
+void ProfileCache::sampleStimulus(const DnfElementDescription& element, double dx, double xMax, int size, bool circular, T* samples)
+{
+	for (int x = 0; x < size; ++x)
+	{
+		double distance = std::abs(x * dx - element.position);
+		if (circular)
+			distance = std::min(distance, xMax - distance);
+		samples[x] = static_cast<T>(element.amplitude * std::exp(-0.5 * distance * distance / (element.sigma * element.sigma)));
+	}
+}
+
+size_t ProfileCache::getEntryCount()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::count_if(entries.begin(), entries.end(), [](const auto& item) { return !item.second.profile.expired(); });
+}
+
+size_t ProfileCache::getMemoryFootprint()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t bytes = 0;
+	for (const auto& [key, entry] : entries)
+		if (!entry.profile.expired())
+			bytes += entry.bytes;
+	return bytes;
+}
+
+template ProfileHandle<float> ProfileCache::kernel<float>(const DnfElementDescription&, double, int);
+template ProfileHandle<double> ProfileCache::kernel<double>(const DnfElementDescription&, double, int);
+template ProfileHandle<float> ProfileCache::stimulus<float>(const DnfElementDescription&, double, double, int, bool);
+template ProfileHandle<double> ProfileCache::stimulus<double>(const DnfElementDescription&, double, double, int, bool);
+template void ProfileCache::sampleStimulus<float>(const DnfElementDescription&, double, double, int, bool, float*);
+template void ProfileCache::sampleStimulus<double>(const DnfElementDescription&, double, double, int, bool, double*);
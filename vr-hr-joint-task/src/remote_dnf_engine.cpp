@@ -0,0 +1,372 @@
+#include "remote_dnf_engine.h"
+
+#include <tools/logger.h>
+
+#include "event_logger.h"
+#include "profile_cache.h"
+#include "startup_profile.h"
+#include "thread_layout.h"
+
+RemoteDnfEngine::RemoteDnfEngine(DnfArchitectureType dnf, const DnfEngineParameters& parameters)
+	: dnf(dnf)
+	, parameters(parameters)
+	, region(nullptr)
+	, encoder(dnf, getDnfArchitectureDescription(dnf))
+	, sequence(0)
+	, stopRequested(false)
+	, engineLost(false)
+	, likelihoodPending(false)
+{
+	// Mapped here rather than in init(), so updates staged before init() reach the engine.
+	if (!memory.open(parameters.sharedMemoryName, sizeof(DnfEngineRegion)))
+	{
+		log(dnf_composer::tools::logger::LogLevel::ERROR, "Could not open the DNF engine region " + parameters.sharedMemoryName + ".\n");
+		return;
+	}
+	region = static_cast<DnfEngineRegion*>(memory.data());
+	region->initialize();
+	if (!region->isValid())
+	{
+		log(dnf_composer::tools::logger::LogLevel::ERROR, "The DNF engine region " + parameters.sharedMemoryName + " has an unknown layout.\n");
+		region = nullptr;
+	}
+}
+
+RemoteDnfEngine::~RemoteDnfEngine()
+{
+	stopRequested = true;
+	end();
+}
+
+void RemoteDnfEngine::init()
+{
+	if (region == nullptr)
+		return;
+	stopRequested = false;
+	engineLost = false;
+	// Events an earlier session left unread are stale.
+	DecisionEvent stale;
+	while (region->decisions.pop(stale)) {}
+	region->clientAttached.store(1, std::memory_order_release);
+	EventLogger::log(LogLevel::CONTROL, "Using the out-of-process DNF engine on " + parameters.sharedMemoryName + ".");
+	listenerThread = std::thread(&RemoteDnfEngine::listen, this);
+}
+
+void RemoteDnfEngine::end()
+{
+	stopRequested = true;
+	if (region != nullptr)
+		region->stopRequested.store(1, std::memory_order_release);
+	if (listenerThread.joinable())
+		listenerThread.join();
+	if (region != nullptr)
+		region->clientAttached.store(0, std::memory_order_release);
+}
+
+void RemoteDnfEngine::listen()
+{
+	using Clock = std::chrono::steady_clock;
+
+	ThreadLayout::applyToCurrentThread("engineClient");
+	if (region->engineAttached.load(std::memory_order_acquire) == 0)
+		log(dnf_composer::tools::logger::LogLevel::INFO, "Waiting for the DNF engine process...\n");
+
+	bool attached = false;
+	uint64_t lastStep = 0;
+	auto lastProgress = Clock::now();
+	while (!stopRequested.load(std::memory_order_relaxed))
+	{
+		const uint32_t doorbell = region->decisionDoorbell.load(std::memory_order_acquire);
+		if (region->engineAttached.load(std::memory_order_acquire) != 0 && !attached)
+		{
+			attached = true;
+			lastProgress = Clock::now();
+			const auto architecture = static_cast<DnfArchitectureType>(region->architecture.load());
+			const auto precision = static_cast<FieldPrecision>(region->precision.load());
+			EventLogger::log(LogLevel::CONTROL, std::string("DNF engine attached: ") + toString(architecture)
+				+ " architecture in " + toString(precision) + ".");
+			StartupProfile::milestone("engineAttached");
+			if (architecture != dnf)
+				log(dnf_composer::tools::logger::LogLevel::ERROR, std::string("The DNF engine runs the ") + toString(architecture)
+					+ " architecture, but the experiment expects " + toString(dnf) + ".\n");
+		}
+
+		if (waitForDoorbell(region->decisionDoorbell, doorbell, std::chrono::milliseconds(100)) && decisionListener)
+			decisionListener();
+
+		if (!attached)
+			continue;
+		// The step count is the engine's heartbeat; a crashed engine cannot clear engineAttached.
+		const uint64_t step = region->step.load(std::memory_order_acquire);
+		const auto now = Clock::now();
+		if (step != lastStep)
+		{
+			lastStep = step;
+			lastProgress = now;
+		}
+		const bool exited = region->engineAttached.load(std::memory_order_acquire) == 0;
+		if (exited || now - lastProgress > parameters.heartbeatTimeout)
+		{
+			// A decision of a lost engine no longer holds.
+			region->targetObject.store(0, std::memory_order_relaxed);
+			engineLost = true;
+			EventLogger::log(LogLevel::CONTROL, exited ? "DNF engine exited." : "DNF engine stopped stepping.");
+			if (decisionListener)
+				decisionListener();
+			return;
+		}
+	}
+}
+
+uint64_t RemoteDnfEngine::setInputs(const Position& handPosition, bool object1, bool object2, bool object3)
+{
+	if (likelihoodPending.exchange(false, std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lock(likelihoodMutex);
+		encoder.setLikelihood(stagedLikelihood);
+	}
+	return publish(encoder.encode(handPosition, object1, object2, object3));
+}
+
+uint64_t RemoteDnfEngine::setObjects(bool object1, bool object2, bool object3)
+{
+	return publish(encoder.encodeObjects(object1, object2, object3));
+}
+
+uint64_t RemoteDnfEngine::publish(const InputFrame& encoded)
+{
+	InputFrame frame = encoded;
+	frame.sequence = ++sequence;
+	frame.published = InputFrame::Clock::now();
+	if (region != nullptr)
+		region->inputs.push(frame);
+	return sequence;
+}
+
+bool RemoteDnfEngine::isLost() const
+{
+	return engineLost.load(std::memory_order_relaxed);
+}
+
+int RemoteDnfEngine::getTargetObject() const
+{
+	return region != nullptr ? region->targetObject.load(std::memory_order_relaxed) : 0;
+}
+
+void RemoteDnfEngine::setDecisionListener(std::function<void()> listener)
+{
+	decisionListener = std::move(listener);
+}
+
+bool RemoteDnfEngine::pollDecisionEvent(DecisionEvent& event)
+{
+	return region != nullptr && region->decisions.pop(event);
+}
+
+uint64_t RemoteDnfEngine::getDecisionCount() const
+{
+	return region != nullptr ? region->decisions.head.load(std::memory_order_acquire) : 0;
+}
+
+void RemoteDnfEngine::stageArchitectureUpdate(std::shared_ptr<const ArchitectureUpdate> update)
+{
+	if (update->likelihoodChanged)
+	{
+		std::lock_guard<std::mutex> lock(likelihoodMutex);
+		stagedLikelihood = update->likelihood;
+		likelihoodPending.store(true, std::memory_order_release);
+	}
+	if (region == nullptr)
+		return;
+	for (const int index : update->changedElements)
+	{
+		const DnfElementDescription& kernel = update->description.elements[index];
+		if (!region->kernels.push({ index, kernel.sigma, kernel.amplitude,
+			kernel.sigmaInhibitory, kernel.amplitudeInhibitory, kernel.amplitudeGlobal }))
+			log(dnf_composer::tools::logger::LogLevel::WARNING, "DNF engine kernel queue full, " + kernel.name + " not updated.\n");
+	}
+}
+
+DnfEngineServer::DnfEngineServer(const DnfEngineServerParameters& parameters)
+	: parameters(parameters)
+	, region(nullptr)
+	, appliedInputFrame(0)
+	, stepTime(Metrics::histogram("engine.step"))
+	, inputAge(Metrics::histogram("engine.inputAge"))
+	, kernelThreadStop(false)
+	, kernelsPending(false)
+{
+	description = getDnfArchitectureDescription(parameters.architecture);
+	description.precision = parameters.precision;
+	engine = createFieldEngine(description, parameters.deltaT);
+	detector = BumpDetector(parameters.decision, false, description.xMax);
+
+	actionExecutionField = engine->indexOf("ael");
+	for (int i = 0; i < 3; ++i)
+	{
+		handStimuli[i] = parameters.architecture == DnfArchitectureType::HAND_MOTION
+			? (i == 0 ? engine->indexOf("hand position stimulus") : -1)
+			: engine->indexOf("hand position stimulus " + std::to_string(i + 1));
+		objectStimuli[i] = engine->indexOf("object stimulus " + std::to_string(i + 1));
+		objectPositions[i] = description.elements[objectStimuli[i]].position;
+	}
+}
+
+DnfEngineServer::~DnfEngineServer()
+{
+	if (region != nullptr)
+		region->engineAttached.store(0, std::memory_order_release);
+}
+
+bool DnfEngineServer::open()
+{
+	if (!memory.open(parameters.sharedMemoryName, sizeof(DnfEngineRegion)))
+	{
+		log(dnf_composer::tools::logger::LogLevel::ERROR, "Could not open the DNF engine region " + parameters.sharedMemoryName + ".\n");
+		return false;
+	}
+	region = static_cast<DnfEngineRegion*>(memory.data());
+	region->initialize();
+	if (!region->isValid())
+	{
+		log(dnf_composer::tools::logger::LogLevel::ERROR, "The DNF engine region " + parameters.sharedMemoryName + " has an unknown layout.\n");
+		region = nullptr;
+		return false;
+	}
+	if (region->engineAttached.exchange(1, std::memory_order_acq_rel) != 0)
+		log(dnf_composer::tools::logger::LogLevel::WARNING, "Another DNF engine was attached to " + parameters.sharedMemoryName
+			+ "; taking over.\n");
+
+	// Frames and kernel updates left over from an earlier engine are stale.
+	InputFrame frame;
+	while (region->inputs.pop(frame)) {}
+	KernelUpdateRecord kernel;
+	while (region->kernels.pop(kernel)) {}
+	region->architecture.store(static_cast<uint32_t>(parameters.architecture));
+	region->precision.store(static_cast<uint32_t>(parameters.precision));
+	region->targetObject.store(0);
+	region->stopRequested.store(0);
+	return true;
+}
+
+void DnfEngineServer::run(const std::atomic<bool>& stop)
+{
+	using Clock = std::chrono::steady_clock;
+
+	ThreadLayout::applyToCurrentThread("engine");
+	engine->init();
+	detector.reset();
+	appliedInputFrame = 0;
+	kernelThreadStop = false;
+	kernelThread = std::thread(&DnfEngineServer::prepareKernelUpdates, this);
+
+	auto nextStep = Clock::now();
+	uint64_t step = region->step.load();
+	while (!stop.load(std::memory_order_relaxed) && region->stopRequested.load(std::memory_order_relaxed) == 0)
+	{
+		applyKernelUpdates();
+		applyInputs();
+		{
+			const ScopedTimer timer(stepTime);
+			engine->step();
+		}
+		DecisionEvent event;
+		if (engine->updateDetector(actionExecutionField, detector, step, event))
+		{
+			event.inputFrame = appliedInputFrame;
+			region->targetObject.store(event.object, std::memory_order_relaxed);
+			region->decisions.push(event);
+			ringDoorbell(region->decisionDoorbell);
+		}
+		region->step.store(++step, std::memory_order_release);
+
+		if (parameters.stepPeriod.count() > 0)
+		{
+			nextStep += parameters.stepPeriod;
+			const auto now = Clock::now();
+			if (nextStep > now)
+				std::this_thread::sleep_until(nextStep);
+			else
+				nextStep = now;
+		}
+	}
+	kernelThreadStop = true;
+	kernelThread.join();
+	region->engineAttached.store(0, std::memory_order_release);
+	ringDoorbell(region->decisionDoorbell);
+}
+
+void DnfEngineServer::prepareKernelUpdates()
+{
+	ThreadLayout::applyToCurrentThread("engineKernels");
+	// The watcher is the only source of updates and polls its file every 500 ms at most.
+	constexpr auto pollPeriod = std::chrono::milliseconds(10);
+	while (!kernelThreadStop.load(std::memory_order_relaxed))
+	{
+		std::this_thread::sleep_for(pollPeriod);
+		std::vector<PreparedKernel> prepared;
+		KernelUpdateRecord record;
+		while (region->kernels.pop(record))
+		{
+			if (record.index < 0 || record.index >= static_cast<int>(description.elements.size()))
+				continue;
+			DnfElementDescription& kernel = description.elements[record.index];
+			kernel.sigma = record.sigma;
+			kernel.amplitude = record.amplitude;
+			kernel.sigmaInhibitory = record.sigmaInhibitory;
+			kernel.amplitudeInhibitory = record.amplitudeInhibitory;
+			kernel.amplitudeGlobal = record.amplitudeGlobal;
+			std::shared_ptr<const void> profile;
+			if (parameters.precision == FieldPrecision::DOUBLE)
+				profile = ProfileCache::kernel<double>(kernel, description.dx, description.getSize());
+			else
+				profile = ProfileCache::kernel<float>(kernel, description.dx, description.getSize());
+			prepared.push_back({ record.index, kernel, std::move(profile) });
+		}
+		if (prepared.empty())
+			continue;
+
+		std::vector<PreparedKernel> retired;
+		{
+			std::lock_guard<std::mutex> lock(kernelMutex);
+			// Kernels the engine applied last time come back here to be freed; ones it has not
+			// taken yet stay in front of the newer ones, so the newest parameters win.
+			if (!kernelsPending.load(std::memory_order_relaxed))
+				retired.swap(preparedKernels);
+			preparedKernels.insert(preparedKernels.end(), std::make_move_iterator(prepared.begin()),
+				std::make_move_iterator(prepared.end()));
+			kernelsPending.store(true, std::memory_order_release);
+		}
+	}
+}
+
+void DnfEngineServer::applyKernelUpdates()
+{
+	if (!kernelsPending.load(std::memory_order_acquire))
+		return;
+	std::unique_lock<std::mutex> lock(kernelMutex, std::try_to_lock);
+	if (!lock.owns_lock())
+		return; // being prepared; take the kernels at the next step
+	// The applied kernels go back in exchange, so nothing is freed or allocated here.
+	appliedKernels.swap(preparedKernels);
+	kernelsPending.store(false, std::memory_order_relaxed);
+	lock.unlock();
+	for (const PreparedKernel& prepared : appliedKernels)
+		engine->setKernel(prepared.index, prepared.kernel);
+}
+
+void DnfEngineServer::applyInputs()
+{
+	// Only the newest frame matters; older ones are skipped.
+	bool received = false;
+	while (region->inputs.pop(frame))
+		received = true;
+	if (!received)
+		return;
+	inputAge.record(InputFrame::Clock::now() - frame.published);
+	appliedInputFrame = frame.sequence;
+	for (int i = 0; i < frame.handStimulusCount; ++i)
+		engine->setStimulus(handStimuli[i], frame.hand[i].amplitude, frame.hand[i].position);
+	for (int i = 0; i < 3; ++i)
+		engine->setStimulus(objectStimuli[i], frame.objectPresent[i] ? 5 : 0, objectPositions[i]);
+}
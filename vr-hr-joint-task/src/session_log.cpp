@@ -0,0 +1,537 @@
+#include "session_log.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <zlib.h>
+
+#include "mapped_file.h"
+
+namespace
+{
+	bool nextLine(std::string_view& text, std::string_view& line)
+	{
+		if (text.empty())
+			return false;
+		const size_t end = text.find('\n');
+		line = text.substr(0, end);
+		text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+		return true;
+	}
+
+	bool parseDigits(std::string_view text, size_t position, size_t count, int& value)
+	{
+		if (position + count > text.size())
+			return false;
+		value = 0;
+		for (size_t i = position; i < position + count; ++i)
+		{
+			const char c = text[i];
+			if (c < '0' || c > '9')
+				return false;
+			value = value * 10 + (c - '0');
+		}
+		return true;
+	}
+
+	// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil).
+	int64_t daysFromCivil(int64_t year, unsigned month, unsigned day)
+	{
+		year -= month <= 2;
+		const int64_t era = (year >= 0 ? year : year - 399) / 400;
+		const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+		const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+		const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+		return era * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+	}
+
+	// Object number following a message prefix, e.g. "Robot is grasping object 2."
+	bool matchObjectMessage(std::string_view message, std::string_view prefix, int& object)
+	{
+		if (!message.starts_with(prefix))
+			return false;
+		const char* begin = message.data() + prefix.size();
+		const char* end = message.data() + message.size();
+		return std::from_chars(begin, end, object).ec == std::errc();
+	}
+
+	bool parseAssignedValue(std::string_view& text, double& value)
+	{
+		const size_t equals = text.find("= ");
+		if (equals == std::string_view::npos)
+			return false;
+		text.remove_prefix(equals + 2);
+		const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (result.ec != std::errc())
+			return false;
+		text.remove_prefix(static_cast<size_t>(result.ptr - text.data()));
+		return true;
+	}
+
+	// "<stream>.NNNNNN.txt", "<stream>.NNNNNN.txt.gz" or, for a single-file session, "<stream>.txt".
+	bool parseSegmentFile(std::string_view name, std::string& stream, int& segment, bool& compressed)
+	{
+		compressed = name.ends_with(".txt.gz");
+		if (compressed)
+			name.remove_suffix(3);
+		if (!name.ends_with(".txt"))
+			return false;
+		name.remove_suffix(4);
+		const size_t dot = name.rfind('.');
+		if (dot == std::string_view::npos)
+		{
+			stream = name;
+			segment = 0;
+			return !compressed && (name == "logs" || name == "logs_human");
+		}
+		const std::string_view digits = name.substr(dot + 1);
+		if (digits.size() != 6 || std::from_chars(digits.data(), digits.data() + digits.size(), segment).ec != std::errc())
+			return false;
+		stream = name.substr(0, dot);
+		return true;
+	}
+
+	std::vector<std::string_view> splitFields(std::string_view line)
+	{
+		std::vector<std::string_view> fields;
+		while (true)
+		{
+			const size_t comma = line.find(',');
+			fields.push_back(line.substr(0, comma));
+			if (comma == std::string_view::npos)
+				return fields;
+			line.remove_prefix(comma + 1);
+		}
+	}
+
+	template <typename T>
+	T parseNumber(std::string_view text)
+	{
+		T value = 0;
+		std::from_chars(text.data(), text.data() + text.size(), value);
+		return value;
+	}
+
+	bool decompress(const std::string& path, size_t expectedBytes, std::string& text)
+	{
+		gzFile file = gzopen(path.c_str(), "rb");
+		if (file == nullptr)
+			return false;
+		text.clear();
+		text.reserve(expectedBytes);
+		char buffer[1 << 16];
+		int count;
+		while ((count = gzread(file, buffer, sizeof(buffer))) > 0)
+			text.append(buffer, static_cast<size_t>(count));
+		return gzclose(file) == Z_OK && count == 0;
+	}
+
+	struct TrialState
+	{
+		int currentTarget = 0;
+		double targetTime = 0;
+		bool targetGrasped = false;
+		double robotGraspTime[4] = { -1, -1, -1, -1 };
+		double humanGraspTime[4] = { -1, -1, -1, -1 };
+		double robotGraspToPlaceSum = 0;
+		int robotGraspToPlaceCount = 0;
+		double humanGraspToPlaceSum = 0;
+		int humanGraspToPlaceCount = 0;
+		double leadSum = 0;
+		double lastEventTime = 0;
+	};
+
+	void finishTrial(TrialMetrics& metrics, const TrialState& state)
+	{
+		metrics.duration = state.lastEventTime - metrics.startTime;
+		if (state.robotGraspToPlaceCount > 0)
+			metrics.robotGraspToPlace = state.robotGraspToPlaceSum / state.robotGraspToPlaceCount;
+		if (state.humanGraspToPlaceCount > 0)
+			metrics.humanGraspToPlace = state.humanGraspToPlaceSum / state.humanGraspToPlaceCount;
+		if (metrics.anticipatedGrasps > 0)
+			metrics.anticipationLead = state.leadSum / metrics.anticipatedGrasps;
+	}
+}
+
+bool SessionIndex::load(const std::string& directory)
+{
+	this->directory = directory;
+	segments.clear();
+	marks.clear();
+
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+	{
+		SessionSegment segment;
+		bool compressed;
+		if (!entry.is_regular_file() || !parseSegmentFile(entry.path().filename().string(), segment.stream, segment.segment, compressed))
+			continue;
+		const auto existing = std::find_if(segments.begin(), segments.end(), [&](const SessionSegment& other) {
+			return other.stream == segment.stream && other.segment == segment.segment;
+		});
+		// While a segment is being compressed both files exist; only the text one is complete.
+		if (existing != segments.end())
+		{
+			if (compressed)
+				continue;
+			segments.erase(existing);
+		}
+		segment.file = entry.path().filename().string();
+		segment.bytes = compressed ? 0 : entry.file_size(error);
+		segment.storedBytes = entry.file_size(error);
+		segments.push_back(segment);
+	}
+
+	MappedFile indexFile;
+	if (indexFile.open(directory + "/index.csv"))
+	{
+		std::string_view text = indexFile.view();
+		std::string_view line;
+		while (nextLine(text, line))
+		{
+			const std::vector<std::string_view> fields = splitFields(line);
+			if (fields.size() < 9)
+				continue;
+			const std::string stream(fields[1]);
+			const int number = parseNumber<int>(fields[2]);
+			const auto segment = std::find_if(segments.begin(), segments.end(), [&](const SessionSegment& other) {
+				return other.stream == stream && other.segment == number;
+			});
+			if (fields[0] == "mark")
+			{
+				SessionMarkEntry mark;
+				mark.stream = stream;
+				mark.label = fields[8];
+				SessionLogParser::parseTimestamp(fields[6], mark.time);
+				mark.position = { number, parseNumber<uint64_t>(fields[3]) };
+				marks.push_back(mark);
+			}
+			else if (fields[0] == "segment" && segment != segments.end())
+			{
+				segment->bytes = parseNumber<uint64_t>(fields[4]);
+				SessionLogParser::parseTimestamp(fields[6], segment->firstTime);
+				SessionLogParser::parseTimestamp(fields[7], segment->lastTime);
+			}
+			else if (fields[0] == "removed")
+			{
+				SessionSegment removed;
+				removed.stream = stream;
+				removed.segment = number;
+				removed.file = fields[8];
+				removed.removed = true;
+				if (segment == segments.end())
+					segments.push_back(removed);
+			}
+		}
+	}
+
+	std::sort(segments.begin(), segments.end(), [](const SessionSegment& a, const SessionSegment& b) {
+		return a.stream != b.stream ? a.stream < b.stream : a.segment < b.segment;
+	});
+	return std::any_of(segments.begin(), segments.end(), [](const SessionSegment& segment) {
+		return segment.stream == "logs" || segment.stream == "logs_human";
+	});
+}
+
+bool SessionIndex::isSession(const std::string& directory)
+{
+	SessionIndex index;
+	return index.load(directory);
+}
+
+bool SessionIndex::findTrial(const std::string& stream, int trial, SessionPosition& begin, SessionPosition& end, double& time) const
+{
+	int found = 0;
+	for (const SessionMarkEntry& mark : marks)
+	{
+		if (mark.stream != stream || !mark.label.starts_with("trial "))
+			continue;
+		found++;
+		if (found == trial)
+		{
+			begin = mark.position;
+			end = SESSION_END;
+			time = mark.time;
+		}
+		else if (found == trial + 1)
+		{
+			end = mark.position;
+			break;
+		}
+	}
+	return found >= trial && trial > 0;
+}
+
+void SessionIndex::read(const std::string& stream, const SessionPosition& begin, const SessionPosition& end,
+	const std::function<void(std::string_view)>& consumer) const
+{
+	std::string buffer;
+	for (const SessionSegment& segment : segments)
+	{
+		if (segment.stream != stream || segment.removed || segment.segment < begin.segment || segment.segment > end.segment)
+			continue;
+		MappedFile mapped;
+		std::string_view text;
+		const std::string path = directory + "/" + segment.file;
+		if (segment.file.ends_with(".gz"))
+		{
+			if (!decompress(path, segment.bytes, buffer))
+				continue;
+			text = buffer;
+		}
+		else
+		{
+			if (!mapped.open(path))
+				continue;
+			text = mapped.view();
+		}
+		if (segment.segment == end.segment)
+			text = text.substr(0, std::min<uint64_t>(end.offset, text.size()));
+		if (segment.segment == begin.segment)
+			text.remove_prefix(std::min<uint64_t>(begin.offset, text.size()));
+		consumer(text);
+	}
+}
+
+bool SessionLogParser::parseTimestamp(std::string_view text, double& seconds)
+{
+	// "YYYY-MM-DD HH:MM:SS" optionally followed by ".mmm"
+	int year, month, day, hour, minute, second;
+	if (!parseDigits(text, 0, 4, year) || !parseDigits(text, 5, 2, month) || !parseDigits(text, 8, 2, day)
+		|| !parseDigits(text, 11, 2, hour) || !parseDigits(text, 14, 2, minute) || !parseDigits(text, 17, 2, second))
+		return false;
+	seconds = static_cast<double>(daysFromCivil(year, month, day)) * 86400.0 + hour * 3600.0 + minute * 60.0 + second;
+	int milliseconds;
+	if (text.size() > 19 && text[19] == '.' && parseDigits(text, 20, 3, milliseconds))
+		seconds += milliseconds / 1000.0;
+	return true;
+}
+
+void SessionLogParser::parseEvents(std::string_view text, std::vector<SessionEvent>& events)
+{
+	std::string_view line;
+	while (nextLine(text, line))
+	{
+		double time;
+		if (!parseTimestamp(line, time))
+			continue;
+		// "<timestamp> <LEVEL> <message>"
+		const size_t levelStart = line.find(' ', 19);
+		if (levelStart == std::string_view::npos)
+			continue;
+		const size_t messageStart = line.find(' ', levelStart + 1);
+		if (messageStart == std::string_view::npos)
+			continue;
+		const std::string_view message = line.substr(messageStart + 1);
+
+		SessionEvent event{ time, SessionEventType::OTHER, 0 };
+		if (message == "Simulation has started.")
+			event.type = SessionEventType::SIMULATION_STARTED;
+		else if (matchObjectMessage(message, "Robot will target object ", event.object))
+			event.type = SessionEventType::ROBOT_TARGET;
+		else if (matchObjectMessage(message, "Robot is grasping object ", event.object))
+			event.type = SessionEventType::ROBOT_GRASP;
+		else if (matchObjectMessage(message, "Robot is placing object ", event.object))
+			event.type = SessionEventType::ROBOT_PLACE;
+		else if (matchObjectMessage(message, "Human is grasping object ", event.object))
+			event.type = SessionEventType::HUMAN_GRASP;
+		else if (matchObjectMessage(message, "Human is placing object ", event.object))
+			event.type = SessionEventType::HUMAN_PLACE;
+		else
+			continue;
+		if (event.object < 0 || event.object > 3)
+			continue;
+		events.push_back(event);
+	}
+}
+
+bool SessionLogParser::parseHandPose(std::string_view line, double& time, Pose& pose)
+{
+	// "<timestamp> Hand pose: x = .., y = .., z = .., alpha = .., beta = .., gamma = .."
+	if (!parseTimestamp(line, time))
+		return false;
+	line.remove_prefix(19);
+	return parseAssignedValue(line, pose.position.x) && parseAssignedValue(line, pose.position.y)
+		&& parseAssignedValue(line, pose.position.z) && parseAssignedValue(line, pose.orientation.alpha)
+		&& parseAssignedValue(line, pose.orientation.beta) && parseAssignedValue(line, pose.orientation.gamma);
+}
+
+void SessionLogParser::parseHandTrajectory(std::string_view text, std::vector<HandSample>& samples)
+{
+	std::string_view line;
+	HandSample sample;
+	while (nextLine(text, line))
+		if (parseHandPose(line, sample.time, sample.pose))
+			samples.push_back(sample);
+}
+
+std::vector<TrialMetrics> SessionLogParser::computeTrialMetrics(const std::vector<SessionEvent>& events)
+{
+	std::vector<TrialMetrics> trials;
+	if (events.empty())
+		return trials;
+
+	TrialState state;
+	const auto startTrial = [&](double time) {
+		if (!trials.empty())
+			finishTrial(trials.back(), state);
+		TrialMetrics metrics;
+		metrics.trial = static_cast<int>(trials.size()) + 1;
+		metrics.startTime = time;
+		trials.push_back(metrics);
+		state = TrialState{};
+		state.lastEventTime = time;
+	};
+
+	for (const SessionEvent& event : events)
+	{
+		if (event.type == SessionEventType::SIMULATION_STARTED || trials.empty())
+			startTrial(event.time);
+		TrialMetrics& trial = trials.back();
+		state.lastEventTime = event.time;
+
+		switch (event.type)
+		{
+		case SessionEventType::ROBOT_TARGET:
+			trial.robotTargetChanges++;
+			state.currentTarget = event.object;
+			state.targetTime = event.time;
+			state.targetGrasped = false;
+			break;
+		case SessionEventType::ROBOT_GRASP:
+			trial.robotGrasps++;
+			state.robotGraspTime[event.object] = event.time;
+			if (event.object == state.currentTarget)
+				state.targetGrasped = true;
+			break;
+		case SessionEventType::ROBOT_PLACE:
+			trial.robotPlaces++;
+			if (state.robotGraspTime[event.object] >= 0)
+			{
+				state.robotGraspToPlaceSum += event.time - state.robotGraspTime[event.object];
+				state.robotGraspToPlaceCount++;
+				state.robotGraspTime[event.object] = -1;
+			}
+			break;
+		case SessionEventType::HUMAN_GRASP:
+			trial.humanGrasps++;
+			state.humanGraspTime[event.object] = event.time;
+			if (state.currentTarget != 0 && !state.targetGrasped)
+			{
+				if (state.currentTarget == event.object)
+					trial.conflicts++;
+				else
+				{
+					state.leadSum += event.time - state.targetTime;
+					trial.anticipatedGrasps++;
+				}
+			}
+			break;
+		case SessionEventType::HUMAN_PLACE:
+			trial.humanPlaces++;
+			if (state.humanGraspTime[event.object] >= 0)
+			{
+				state.humanGraspToPlaceSum += event.time - state.humanGraspTime[event.object];
+				state.humanGraspToPlaceCount++;
+				state.humanGraspTime[event.object] = -1;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	finishTrial(trials.back(), state);
+	return trials;
+}
+
+std::vector<TrialMetrics> SessionLogParser::analyzeSession(const std::string& directory, int trial)
+{
+	SessionIndex index;
+	if (!index.load(directory))
+		return {};
+	SessionPosition eventsBegin, eventsEnd = SESSION_END;
+	SessionPosition handBegin, handEnd = SESSION_END;
+	double trialTime = 0;
+	if (trial > 0)
+	{
+		// Only the segments of the one trial are read.
+		if (!index.findTrial("logs", trial, eventsBegin, eventsEnd, trialTime))
+			return {};
+		index.findTrial("logs_human", trial, handBegin, handEnd, trialTime);
+	}
+
+	std::vector<SessionEvent> events;
+	index.read("logs", eventsBegin, eventsEnd, [&](std::string_view text) { parseEvents(text, events); });
+
+	std::vector<TrialMetrics> trials = computeTrialMetrics(events);
+	const std::string session = std::filesystem::path(directory).filename().string();
+	for (auto& metrics : trials)
+		metrics.session = session;
+	if (trials.empty())
+		return trials;
+
+	// Hand poses are streamed into the trial they fall in; both streams are chronological.
+	size_t trialIndex = 0;
+	bool hasPrevious = false;
+	Position previous;
+	index.read("logs_human", handBegin, handEnd, [&](std::string_view text)
+	{
+		std::string_view line;
+		while (nextLine(text, line))
+		{
+			double time;
+			Pose pose;
+			if (!parseHandPose(line, time, pose) || time < trials.front().startTime)
+				continue;
+			while (trialIndex + 1 < trials.size() && time >= trials[trialIndex + 1].startTime)
+			{
+				trialIndex++;
+				hasPrevious = false;
+			}
+			TrialMetrics& metrics = trials[trialIndex];
+			metrics.handSamples++;
+			if (hasPrevious)
+				metrics.handPathLength += calculateEuclideanDistance(previous, pose.position);
+			previous = pose.position;
+			hasPrevious = true;
+		}
+	});
+
+	// A single trial is numbered and timed as in the whole session, from the first trial mark.
+	double sessionStart = events.front().time;
+	if (trial > 0)
+	{
+		SessionPosition first, next;
+		index.findTrial("logs", 1, first, next, sessionStart);
+		trials.front().trial = trial;
+	}
+	for (auto& metrics : trials)
+		metrics.startTime -= sessionStart;
+	return trials;
+}
+
+std::string SessionLogParser::formatHeader()
+{
+	return "session,trial,start_s,duration_s,robot_target_changes,robot_grasps,robot_places,"
+		"human_grasps,human_places,robot_grasp_to_place_s,human_grasp_to_place_s,conflicts,"
+		"anticipated_grasps,anticipation_lead_s,hand_samples,hand_path_m";
+}
+
+std::string SessionLogParser::format(const TrialMetrics& metrics)
+{
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(3)
+		<< metrics.session << ',' << metrics.trial << ',' << metrics.startTime << ',' << metrics.duration << ','
+		<< metrics.robotTargetChanges << ',' << metrics.robotGrasps << ',' << metrics.robotPlaces << ','
+		<< metrics.humanGrasps << ',' << metrics.humanPlaces << ','
+		<< metrics.robotGraspToPlace << ',' << metrics.humanGraspToPlace << ',' << metrics.conflicts << ','
+		<< metrics.anticipatedGrasps << ',' << metrics.anticipationLead << ','
+		<< metrics.handSamples << ',' << metrics.handPathLength;
+	return ss.str();
+}
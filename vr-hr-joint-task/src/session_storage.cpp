@@ -0,0 +1,232 @@
+#include "session_storage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include <zlib.h>
+#include <tools/logger.h>
+
+#include "thread_layout.h"
+
+SessionStorage::SessionStorage()
+	: stopRequested(false)
+	, storedBytes(0)
+	, segmentCount(Metrics::counter("storage.segments"))
+	, removedSegments(Metrics::counter("storage.removedSegments"))
+	, diskBytes(Metrics::gauge("storage.diskBytes"))
+	, compressTime(Metrics::histogram("storage.compress"))
+{
+}
+
+SessionStorage::~SessionStorage()
+{
+	close();
+}
+
+bool SessionStorage::open(const std::string& directory, const SessionStorageParameters& parameters)
+{
+	this->directory = directory;
+	this->parameters = parameters;
+	index.open(directory + "/index.csv", std::ofstream::out | std::ofstream::trunc);
+	if (!index.is_open())
+		return false;
+	writeIndex("entry,stream,segment,offset,bytes,storedBytes,firstTime,lastTime,name");
+	stopRequested = false;
+	compressorThread = std::thread(&SessionStorage::compress, this);
+	return true;
+}
+
+void SessionStorage::close()
+{
+	for (const auto& stream : streams)
+	{
+		std::lock_guard<std::mutex> lock(stream->mutex);
+		if (stream->file.is_open())
+			closeSegment(*stream);
+	}
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopRequested = true;
+	}
+	wakeUp.notify_one();
+	if (compressorThread.joinable())
+		compressorThread.join();
+	std::lock_guard<std::mutex> lock(indexMutex);
+	if (index.is_open())
+		index.close();
+}
+
+int SessionStorage::addStream(const std::string& name)
+{
+	auto stream = std::make_unique<Stream>();
+	stream->name = name;
+	openSegment(*stream);
+	streams.push_back(std::move(stream));
+	return static_cast<int>(streams.size()) - 1;
+}
+
+void SessionStorage::write(int id, const char* data, size_t length)
+{
+	Stream& stream = *streams[id];
+	std::lock_guard<std::mutex> lock(stream.mutex);
+	if (!stream.file.is_open())
+		return;
+	if (stream.bytes > 0 && (stream.bytes + length > parameters.segmentBytes
+		|| Clock::now() - stream.opened >= parameters.segmentDuration))
+	{
+		closeSegment(stream);
+		if (!openSegment(stream))
+			return;
+	}
+	if (length >= TIMESTAMP_LENGTH)
+	{
+		if (stream.lines == 0)
+			std::memcpy(stream.firstTime, data, TIMESTAMP_LENGTH);
+		std::memcpy(stream.lastTime, data, TIMESTAMP_LENGTH);
+	}
+	stream.file.write(data, static_cast<std::streamsize>(length));
+	stream.file.flush(); // Ensure that each line is immediately written to the file
+	stream.bytes += length;
+	stream.lines++;
+}
+
+void SessionStorage::mark(const char* timestamp, const std::string& label)
+{
+	for (const auto& stream : streams)
+	{
+		std::lock_guard<std::mutex> lock(stream->mutex);
+		if (!stream->file.is_open())
+			continue;
+		writeIndex("mark," + stream->name + "," + std::to_string(stream->segment) + "," + std::to_string(stream->bytes)
+			+ ",,," + timestamp + ",," + label);
+	}
+}
+
+std::string SessionStorage::segmentFile(const std::string& stream, int segment)
+{
+	char suffix[32];
+	std::snprintf(suffix, sizeof(suffix), ".%06d.txt", segment);
+	return stream + suffix;
+}
+
+bool SessionStorage::openSegment(Stream& stream)
+{
+	stream.segment++;
+	// Binary, so the offsets in the index are byte offsets on every platform.
+	stream.file.open(directory + "/" + segmentFile(stream.name, stream.segment), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	stream.bytes = 0;
+	stream.lines = 0;
+	stream.firstTime[0] = '\0';
+	stream.lastTime[0] = '\0';
+	stream.opened = Clock::now();
+	if (!stream.file.is_open())
+		log(dnf_composer::tools::logger::LogLevel::ERROR, "Could not open session segment " + segmentFile(stream.name, stream.segment) + ".\n");
+	return stream.file.is_open();
+}
+
+void SessionStorage::closeSegment(Stream& stream)
+{
+	stream.file.close();
+	if (stream.bytes == 0)
+	{
+		std::error_code error;
+		std::filesystem::remove(directory + "/" + segmentFile(stream.name, stream.segment), error);
+		return;
+	}
+	segmentCount.increment();
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		closedSegments.push_back({ stream.name, stream.segment, stream.bytes, stream.firstTime, stream.lastTime });
+	}
+	wakeUp.notify_one();
+}
+
+void SessionStorage::writeIndex(const std::string& line)
+{
+	std::lock_guard<std::mutex> lock(indexMutex);
+	if (!index.is_open())
+		return;
+	index << line << '\n';
+	index.flush();
+}
+
+void SessionStorage::compress()
+{
+	ThreadLayout::applyToCurrentThread("storage");
+	std::unique_lock<std::mutex> lock(queueMutex);
+	while (true)
+	{
+		wakeUp.wait(lock, [this] { return stopRequested || !closedSegments.empty(); });
+		if (closedSegments.empty())
+			return; // stopped, and every closed segment is stored
+		const ClosedSegment segment = std::move(closedSegments.front());
+		closedSegments.pop_front();
+		lock.unlock();
+
+		std::string file;
+		uint64_t bytes = 0;
+		{
+			const ScopedTimer timer(compressTime);
+			store(segment, file, bytes);
+		}
+		writeIndex("segment," + segment.stream + "," + std::to_string(segment.segment) + ",," + std::to_string(segment.bytes)
+			+ "," + std::to_string(bytes) + "," + segment.firstTime + "," + segment.lastTime + "," + file);
+		storedSegments.push_back({ segment.stream, segment.segment, file, bytes });
+		storedBytes += bytes;
+
+		// Retention: the oldest segments go first, whichever stream they belong to.
+		while (parameters.maxSessionBytes > 0 && storedBytes > parameters.maxSessionBytes && !storedSegments.empty())
+		{
+			const StoredSegment& oldest = storedSegments.front();
+			std::error_code error;
+			std::filesystem::remove(directory + "/" + oldest.file, error);
+			writeIndex("removed," + oldest.stream + "," + std::to_string(oldest.segment) + ",,,,,," + oldest.file);
+			storedBytes -= oldest.bytes;
+			removedSegments.increment();
+			storedSegments.pop_front();
+		}
+		diskBytes.set(static_cast<int64_t>(storedBytes));
+		lock.lock();
+	}
+}
+
+bool SessionStorage::store(const ClosedSegment& segment, std::string& file, uint64_t& bytes)
+{
+	const std::string text = segmentFile(segment.stream, segment.segment);
+	file = text;
+	bytes = segment.bytes;
+	if (parameters.compressionLevel <= 0)
+		return true;
+
+	const std::string compressed = text + ".gz";
+	std::ifstream input(directory + "/" + text, std::ifstream::binary);
+	const std::string mode = "wb" + std::to_string(std::min(parameters.compressionLevel, 9));
+	gzFile output = gzopen((directory + "/" + compressed).c_str(), mode.c_str());
+	bool stored = input.is_open() && output != nullptr;
+	std::vector<char> buffer(1 << 16);
+	while (stored && input)
+	{
+		input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		const auto count = static_cast<unsigned>(input.gcount());
+		if (count > 0 && gzwrite(output, buffer.data(), count) != static_cast<int>(count))
+			stored = false;
+	}
+	if (output != nullptr && gzclose(output) != Z_OK)
+		stored = false;
+	input.close();
+
+	std::error_code error;
+	if (!stored)
+	{
+		// The text segment stays; it is still a complete segment.
+		std::filesystem::remove(directory + "/" + compressed, error);
+		log(dnf_composer::tools::logger::LogLevel::WARNING, "Could not compress session segment " + text + ".\n");
+		return false;
+	}
+	bytes = std::filesystem::file_size(directory + "/" + compressed, error);
+	std::filesystem::remove(directory + "/" + text, error);
+	file = compressed;
+	return true;
+}
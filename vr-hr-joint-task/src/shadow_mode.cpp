@@ -0,0 +1,227 @@
+#include "shadow_mode.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "event_logger.h"
+#include "parameter_watcher.h"
+#include "startup_profile.h"
+#include "thread_layout.h"
+
+ShadowRunner::ShadowRunner(int id, const ShadowArchitecture& architecture, double deltaT,
+	std::chrono::microseconds stepPeriod, const BumpDetectorParameters& decisionParameters)
+	: architecture(architecture)
+	, name("shadow" + std::to_string(id))
+	, deltaT(deltaT)
+	, stepPeriod(stepPeriod)
+	, decisionParameters(decisionParameters)
+	, description(getDnfArchitectureDescription(architecture.type))
+	, encoder(architecture.type, description)
+	, appliedInputFrame(0)
+	, stopRequested(false)
+	, stepTime(Metrics::histogram(name + ".step"))
+	, updatePending(false)
+	, likelihoodPending(false)
+{
+	description.precision = architecture.precision;
+	auto initial = std::make_shared<ArchitectureUpdate>();
+	initial->description = description;
+	parsedUpdate = std::move(initial);
+}
+
+ShadowRunner::~ShadowRunner()
+{
+	stop();
+}
+
+void ShadowRunner::build()
+{
+	const StartupPhase phase(name);
+	engine = createFieldEngine(description, deltaT);
+	detector = BumpDetector(decisionParameters, description.circular, description.xMax);
+
+	actionExecutionField = engine->indexOf("ael");
+	for (int i = 0; i < 3; ++i)
+	{
+		handStimuli[i] = architecture.type == DnfArchitectureType::HAND_MOTION
+			? (i == 0 ? engine->indexOf("hand position stimulus") : -1)
+			: engine->indexOf("hand position stimulus " + std::to_string(i + 1));
+		objectStimuli[i] = engine->indexOf("object stimulus " + std::to_string(i + 1));
+		objectPositions[i] = description.elements[objectStimuli[i]].position;
+	}
+}
+
+void ShadowRunner::start()
+{
+	stopRequested = false;
+	thread = std::thread(&ShadowRunner::run, this);
+}
+
+void ShadowRunner::stop()
+{
+	stopRequested = true;
+	if (thread.joinable())
+		thread.join();
+}
+
+void ShadowRunner::setInputs(const Position& handPosition, bool object1, bool object2, bool object3)
+{
+	if (likelihoodPending.exchange(false, std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lock(updateMutex);
+		encoder.setLikelihood(stagedLikelihood);
+	}
+	inputs.publish(encoder.encode(handPosition, object1, object2, object3));
+}
+
+void ShadowRunner::setObjects(bool object1, bool object2, bool object3)
+{
+	inputs.publish(encoder.encodeObjects(object1, object2, object3));
+}
+
+bool ShadowRunner::pollDecisionEvent(DecisionEvent& event)
+{
+	return events.pop(event);
+}
+
+void ShadowRunner::stageArchitectureUpdate(std::shared_ptr<const ArchitectureUpdate> update)
+{
+	// The update describes the primary's architecture. Its file is parsed again against this one,
+	// so only the parameters the file sets carry over, to the kernels of the same name here.
+	std::string error;
+	std::shared_ptr<ArchitectureUpdate> mapped = ParameterWatcher::parse(update->source, description, *parsedUpdate, error, true);
+	if (mapped)
+	{
+		mapped->version = update->version;
+		parsedUpdate = mapped;
+	}
+	else
+		EventLogger::log(LogLevel::CONTROL, name + " keeps its kernels, architecture parameters v"
+			+ std::to_string(update->version) + " do not fit its architecture: " + error + ".");
+
+	std::shared_ptr<const ArchitectureUpdate> retired;
+	{
+		std::lock_guard<std::mutex> lock(updateMutex);
+		retired = std::move(retiredUpdate);
+		if (update->likelihoodChanged)
+		{
+			stagedLikelihood = update->likelihood;
+			likelihoodPending.store(true, std::memory_order_release);
+		}
+		if (mapped && !mapped->changedElements.empty())
+		{
+			// As on the primary: an update not applied yet is carried by the next one.
+			if (pendingUpdate)
+			{
+				for (const int index : pendingUpdate->changedElements)
+					if (std::find(mapped->changedElements.begin(), mapped->changedElements.end(), index) == mapped->changedElements.end())
+						mapped->changedElements.push_back(index);
+				mapped->kernelProfiles.insert(mapped->kernelProfiles.end(),
+					pendingUpdate->kernelProfiles.begin(), pendingUpdate->kernelProfiles.end());
+				retired = std::move(pendingUpdate);
+			}
+			pendingUpdate = std::move(mapped);
+			updatePending.store(true, std::memory_order_release);
+		}
+	}
+}
+
+void ShadowRunner::run()
+{
+	using Clock = std::chrono::steady_clock;
+
+	ThreadLayout::applyToCurrentThread(name);
+	if (!engine)
+		build();
+	engine->init();
+	detector.reset();
+	appliedInputFrame = 0;
+
+	auto nextStep = Clock::now();
+	uint64_t step = 0;
+	while (!stopRequested.load(std::memory_order_relaxed))
+	{
+		applyArchitectureUpdate();
+		applyInputs();
+		{
+			const ScopedTimer timer(stepTime);
+			engine->step();
+		}
+		DecisionEvent event;
+		if (engine->updateDetector(actionExecutionField, detector, step, event))
+		{
+			event.inputFrame = appliedInputFrame;
+			events.push(event);
+		}
+		step++;
+
+		if (stepPeriod.count() > 0)
+		{
+			nextStep += stepPeriod;
+			const auto now = Clock::now();
+			if (nextStep > now)
+				std::this_thread::sleep_until(nextStep);
+			else
+				nextStep = now;
+		}
+	}
+}
+
+void ShadowRunner::applyInputs()
+{
+	if (!inputs.acquire())
+		return;
+	const InputFrame& frame = inputs.get();
+	appliedInputFrame = frame.sequence;
+	for (int i = 0; i < frame.handStimulusCount; ++i)
+		engine->setStimulus(handStimuli[i], frame.hand[i].amplitude, frame.hand[i].position);
+	for (int i = 0; i < 3; ++i)
+		engine->setStimulus(objectStimuli[i], frame.objectPresent[i] ? 5 : 0, objectPositions[i]);
+}
+
+void ShadowRunner::applyArchitectureUpdate()
+{
+	if (!updatePending.load(std::memory_order_acquire))
+		return;
+	std::unique_lock<std::mutex> lock(updateMutex, std::try_to_lock);
+	if (!lock.owns_lock())
+		return; // the watcher is staging; take the update at the next step
+	std::shared_ptr<const ArchitectureUpdate> update = std::move(pendingUpdate);
+	updatePending.store(false, std::memory_order_relaxed);
+	if (!update)
+		return;
+	for (const int index : update->changedElements)
+		engine->setKernel(index, update->description.elements[index]);
+	retiredUpdate = std::move(appliedUpdate);
+	appliedUpdate = std::move(update);
+}
+
+bool DecisionLog::open(const std::string& path)
+{
+	file.open(path, std::ofstream::out | std::ofstream::trunc);
+	if (!file.is_open())
+		return false;
+	start = Clock::now();
+	file << "source,architecture,engine,event,object,previousObject,step,inputFrame,time,peak,position\n";
+	file.flush();
+	return true;
+}
+
+void DecisionLog::close()
+{
+	if (file.is_open())
+		file.close();
+}
+
+void DecisionLog::write(const char* source, DnfArchitectureType architecture, const char* engine, const DecisionEvent& event)
+{
+	if (!file.is_open())
+		return;
+	char line[256];
+	const int written = std::snprintf(line, sizeof(line), "%s,%s,%s,%s,%d,%d,%llu,%llu,%.6f,%.4f,%.4f\n",
+		source, toString(architecture), engine, toString(event.type), event.object, event.previousObject,
+		static_cast<unsigned long long>(event.step), static_cast<unsigned long long>(event.inputFrame),
+		std::chrono::duration<double>(event.time - start).count(), event.bump.amplitude, event.bump.position);
+	file.write(line, std::min<std::streamsize>(std::max(written, 0), sizeof(line) - 1));
+	file.flush();
+}
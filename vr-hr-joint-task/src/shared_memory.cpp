@@ -0,0 +1,163 @@
+#include "shared_memory.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+SharedMemory::SharedMemory()
+	: size(0), address(nullptr), created(false)
+#ifdef _WIN32
+	, mapping(nullptr)
+#else
+	, fd(-1)
+#endif
+{}
+
+SharedMemory::~SharedMemory()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool SharedMemory::open(const std::string& mappingName, size_t mappingSize)
+{
+	close();
+	name = "Local\\" + mappingName;
+	size = mappingSize;
+
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), name.c_str());
+	if (mapping == nullptr)
+		return false;
+	// Pages of a new pagefile-backed mapping are zero-initialized.
+	created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+	address = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (address == nullptr)
+	{
+		CloseHandle(mapping);
+		mapping = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void SharedMemory::close()
+{
+	if (address != nullptr)
+		UnmapViewOfFile(address);
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	address = nullptr;
+	mapping = nullptr;
+	created = false;
+}
+
+void ringDoorbell(std::atomic<uint32_t>& word)
+{
+	word.fetch_add(1, std::memory_order_release);
+	WakeByAddressAll(&word);
+}
+
+bool waitForDoorbell(const std::atomic<uint32_t>& word, uint32_t lastSeen, std::chrono::microseconds timeout)
+{
+	// WakeByAddressAll only reaches waiters in the same process, so the wait is cut into short
+	// slices and a ring from the peer process is seen when the current slice ends.
+	constexpr std::chrono::milliseconds slice(1);
+	const auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (word.load(std::memory_order_acquire) == lastSeen)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		if (now >= deadline)
+			return false;
+		const auto wait = std::min(slice, std::chrono::ceil<std::chrono::milliseconds>(deadline - now));
+		WaitOnAddress(const_cast<std::atomic<uint32_t>*>(&word), &lastSeen, sizeof(lastSeen), static_cast<DWORD>(wait.count()));
+	}
+	return true;
+}
+
+#else
+
+bool SharedMemory::open(const std::string& mappingName, size_t mappingSize)
+{
+	close();
+	name = "/" + mappingName;
+	size = mappingSize;
+
+	fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	created = fd >= 0;
+	if (!created)
+		fd = shm_open(name.c_str(), O_RDWR, 0600);
+	if (fd < 0)
+		return false;
+
+	// A new object is sized here; ftruncate zero-fills it.
+	struct stat info{};
+	if (fstat(fd, &info) != 0 || (static_cast<size_t>(info.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0))
+	{
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+
+	address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (address == MAP_FAILED)
+	{
+		address = nullptr;
+		::close(fd);
+		fd = -1;
+		return false;
+	}
+	return true;
+}
+
+void SharedMemory::close()
+{
+	if (address != nullptr)
+		munmap(address, size);
+	if (fd >= 0)
+		::close(fd);
+	address = nullptr;
+	fd = -1;
+	created = false;
+}
+
+void ringDoorbell(std::atomic<uint32_t>& word)
+{
+	word.fetch_add(1, std::memory_order_release);
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+bool waitForDoorbell(const std::atomic<uint32_t>& word, uint32_t lastSeen, std::chrono::microseconds timeout)
+{
+	const auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (word.load(std::memory_order_acquire) == lastSeen)
+	{
+		const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+		if (remaining.count() <= 0)
+			return false;
+		timespec relative{};
+		relative.tv_sec = static_cast<time_t>(remaining.count() / 1000000000);
+		relative.tv_nsec = static_cast<long>(remaining.count() % 1000000000);
+		// Not FUTEX_PRIVATE: the word is shared with another process.
+		syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&word), FUTEX_WAIT, lastSeen, &relative, nullptr, 0);
+	}
+	return true;
+}
+
+#endif
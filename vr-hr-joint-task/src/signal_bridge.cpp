@@ -0,0 +1,230 @@
+#include "signal_bridge.h"
+
+#include <cstdio>
+
+#include "event_logger.h"
+#include "startup_profile.h"
+
+SignalBridge::SignalBridge(CoppeliasimHandler& coppeliasimHandler, DnfEngine& dnfEngine,
+	const std::vector<std::unique_ptr<ShadowRunner>>& shadows, DecisionLog& decisionLog,
+	AsyncCondition& updates, const std::atomic<bool>& stopRequested)
+	: coppeliasimHandler(coppeliasimHandler)
+	, dnfEngine(dnfEngine)
+	, shadows(shadows)
+	, decisionLog(decisionLog)
+	, updates(updates)
+	, stopRequested(stopRequested)
+	, handPose({},{})
+	, handledUpdate(0)
+	, handledDecision(0)
+	, handledPose(0)
+	, sentObjects{}
+	, bridgeLoopMeter(Metrics::loop("loop.bridge"))
+	, decisionDelivery(Metrics::histogram("dnf.decisionDelivery"))
+{
+}
+
+Coroutine SignalBridge::run()
+{
+	handledUpdate = 0;
+	handledDecision = 0;
+	handledPose = 0;
+	while (true)
+	{
+		co_await updates.until([this] {
+			return isSessionOver() || (coppeliasimHandler.isConnected() && (coppeliasimHandler.getUpdateCount() != handledUpdate
+				|| dnfEngine.getDecisionCount() != handledDecision));
+		});
+		if (isSessionOver())
+			co_return;
+		const bool newUpdate = coppeliasimHandler.getUpdateCount() != handledUpdate;
+		handledUpdate = coppeliasimHandler.getUpdateCount();
+		handledDecision = dnfEngine.getDecisionCount();
+
+		bridgeLoopMeter.tick();
+		if (newUpdate)
+		{
+			inSignals = coppeliasimHandler.getSignals();
+			sendInputsToDnf();
+		}
+		sendTargetObjectToRobot();
+		handleDecisionEvents();
+		if (newUpdate)
+			interpretAndLogSystemState();
+		coppeliasimHandler.setSignals(outSignals);
+	}
+}
+
+bool SignalBridge::isSessionOver() const
+{
+	return stopRequested || dnfEngine.isLost();
+}
+
+void SignalBridge::sendInputsToDnf()
+{
+	uint64_t poseNumber;
+	const Pose pose = coppeliasimHandler.getHandPose(poseNumber);
+	const std::array<bool, 3> objects = { inSignals.object1, inSignals.object2, inSignals.object3 };
+	if (poseNumber != handledPose)
+	{
+		handledPose = poseNumber;
+		handPose = pose;
+		dnfEngine.setInputs({ handPose.position.x,
+			handPose.position.y,
+			handPose.position.z},
+			objects[0],
+			objects[1],
+			objects[2]);
+		// Right after the primary's, so every shadow frame carries the primary frame's sequence number.
+		for (const auto& shadow : shadows)
+			shadow->setInputs(handPose.position, objects[0], objects[1], objects[2]);
+	}
+	else if (objects != sentObjects)
+	{
+		dnfEngine.setObjects(objects[0], objects[1], objects[2]);
+		for (const auto& shadow : shadows)
+			shadow->setObjects(objects[0], objects[1], objects[2]);
+	}
+	sentObjects = objects;
+}
+
+void SignalBridge::sendTargetObjectToRobot()
+{
+	outSignals.targetObject = dnfEngine.getTargetObject();
+}
+
+void SignalBridge::handleDecisionEvents()
+{
+	DecisionEvent event;
+	while (dnfEngine.pollDecisionEvent(event))
+	{
+		decisionDelivery.record(DecisionEvent::Clock::now() - event.time);
+		char message[160];
+		switch (event.type)
+		{
+		case DecisionEventType::ONSET:
+			std::snprintf(message, sizeof(message), "Decision onset: object %d (step %llu, peak %.2f at %.2f).",
+				event.object, static_cast<unsigned long long>(event.step), event.bump.amplitude, event.bump.position);
+			break;
+		case DecisionEventType::CHANGE:
+			std::snprintf(message, sizeof(message), "Decision change: object %d to object %d (step %llu, peak %.2f at %.2f).",
+				event.previousObject, event.object, static_cast<unsigned long long>(event.step), event.bump.amplitude, event.bump.position);
+			break;
+		case DecisionEventType::RELEASE:
+			std::snprintf(message, sizeof(message), "Decision release: object %d (step %llu).",
+				event.previousObject, static_cast<unsigned long long>(event.step));
+			break;
+		}
+		EventLogger::log(LogLevel::ROBOT, message);
+		if (event.type == DecisionEventType::ONSET)
+			StartupProfile::milestone("firstDecision");
+		decisionLog.write("primary", dnfEngine.getArchitectureType(), dnfEngine.getEngineName(), event);
+	}
+	// Shadow decisions only go to the decision log. They are picked up whenever the bridge
+	// wakes; the times written are those of the shadow's own steps.
+	for (const auto& shadow : shadows)
+	{
+		while (shadow->pollDecisionEvent(event))
+			decisionLog.write(shadow->getName().c_str(), shadow->getArchitecture().type,
+				toString(shadow->getArchitecture().precision), event);
+	}
+}
+
+void SignalBridge::interpretAndLogSystemState()
+{
+	EventLogger::logHumanHandPose(handPose);
+
+	if(inSignals.simStarted && logMsgs.prevSimStarted == false)
+	{
+		EventLogger::mark(SessionMark::TRIAL);
+		EventLogger::log(LogLevel::CONTROL, "Simulation has started.");
+		logMsgs.prevSimStarted = true;
+	}
+	logMsgs.prevSimStarted = inSignals.simStarted;
+
+	// Grasping events for robot, logged every time it passes from 0 to 1.
+	if (inSignals.robotGraspObj1 && logMsgs.prevRobotGraspObj1 == 0) {
+		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 1.");
+	}
+	logMsgs.prevRobotGraspObj1 = inSignals.robotGraspObj1;
+
+	if (inSignals.robotGraspObj2 && logMsgs.prevRobotGraspObj2 == 0) {
+		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 2.");
+	}
+	logMsgs.prevRobotGraspObj2 = inSignals.robotGraspObj2;
+
+	if (inSignals.robotGraspObj3 && logMsgs.prevRobotGraspObj3 == 0) {
+		EventLogger::log(LogLevel::ROBOT, "Robot is grasping object 3.");
+	}
+	logMsgs.prevRobotGraspObj3 = inSignals.robotGraspObj3;
+
+	// Grasping events for human, logged every time it passes from 0 to 1.
+	if (inSignals.humanGraspObj1 && logMsgs.prevHumanGraspObj1 == 0) {
+		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 1.");
+	}
+	logMsgs.prevHumanGraspObj1 = inSignals.humanGraspObj1;
+
+	if (inSignals.humanGraspObj2 && logMsgs.prevHumanGraspObj2 == 0) {
+		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 2.");
+	}
+	logMsgs.prevHumanGraspObj2 = inSignals.humanGraspObj2;
+
+	if (inSignals.humanGraspObj3 && logMsgs.prevHumanGraspObj3 == 0) {
+		EventLogger::log(LogLevel::HUMAN, "Human is grasping object 3.");
+	}
+	logMsgs.prevHumanGraspObj3 = inSignals.humanGraspObj3;
+
+	// Placement events for robot, logged every time it passes from 0 to 1.
+	if (inSignals.robotPlaceObj1 && logMsgs.prevRobotPlaceObj1 == 0) {
+		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 1.");
+	}
+	logMsgs.prevRobotPlaceObj1 = inSignals.robotPlaceObj1;
+
+	if (inSignals.robotPlaceObj2 && logMsgs.prevRobotPlaceObj2 == 0) {
+		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 2.");
+	}
+	logMsgs.prevRobotPlaceObj2 = inSignals.robotPlaceObj2;
+
+	if (inSignals.robotPlaceObj3 && logMsgs.prevRobotPlaceObj3 == 0) {
+		EventLogger::log(LogLevel::ROBOT, "Robot is placing object 3.");
+	}
+	logMsgs.prevRobotPlaceObj3 = inSignals.robotPlaceObj3;
+
+	// Placement events for human, logged every time it passes from 0 to 1.
+	if (inSignals.humanPlaceObj1 && logMsgs.prevHumanPlaceObj1 == 0) {
+		EventLogger::log(LogLevel::HUMAN, "Human is placing object 1.");
+	}
+	logMsgs.prevHumanPlaceObj1 = inSignals.humanPlaceObj1;
+
+	if (inSignals.humanPlaceObj2 && logMsgs.prevHumanPlaceObj2 == 0) {
+		EventLogger::log(LogLevel::HUMAN, "Human is placing object 2.");
+	}
+	logMsgs.prevHumanPlaceObj2 = inSignals.humanPlaceObj2;
+
+	if (inSignals.humanPlaceObj3 && logMsgs.prevHumanPlaceObj3 == 0) {
+		EventLogger::log(LogLevel::HUMAN, "Human is placing object 3.");
+	}
+	logMsgs.prevHumanPlaceObj3 = inSignals.humanPlaceObj3;
+
+	// Check if the robot is approaching a new object.
+	if (inSignals.robotApproaching && /*!inSignals.robotGrasping && */outSignals.targetObject != logMsgs.lastTargetObject) {
+		if (outSignals.targetObject != 0)
+		{
+			char message[48];
+			std::snprintf(message, sizeof(message), "Robot will target object %d.", outSignals.targetObject);
+			EventLogger::log(LogLevel::ROBOT, message);
+		}
+		logMsgs.lastTargetObject = outSignals.targetObject;
+	}
+}
+
+bool SignalBridge::areObjectsPresent() const
+{
+	const bool isPresent = inSignals.object1 != 0 || inSignals.object2 != 0 || inSignals.object3 != 0;
+	return isPresent;
+}
+
+bool SignalBridge::areAllObjectsPresent() const
+{
+	return inSignals.object1 != 0 && inSignals.object2 != 0 && inSignals.object3 != 0;
+}
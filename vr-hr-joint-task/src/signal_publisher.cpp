@@ -0,0 +1,122 @@
+#include "signal_publisher.h"
+
+SignalPublisher::SignalPublisher(const SignalPublisherParameters& parameters)
+	: parameters(parameters)
+	, hasSent(false)
+	, isDirty(true)
+	, hasChange(false)
+	, firstChangeTime(Clock::now())
+	, timedWrites(0)
+	, lastWriteTime(Clock::now())
+	, lastChangeWriteTime(Clock::now() - parameters.coalesceWindow)
+	, writeTime(Metrics::histogram("rtt.setIntegerSignal"))
+	, remoteWrites(Metrics::counter("publisher.remoteWrites"))
+{}
+
+bool SignalPublisher::publish(const OutgoingSignals& signals)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (signals == pending)
+		return false;
+	pending = signals;
+	statistics.changes++;
+	if (!hasChange)
+	{
+		hasChange = true;
+		firstChangeTime = Clock::now();
+	}
+	if (isDirty)
+		return false; // merged into the burst already waiting for its window
+	isDirty = true;
+	return true;
+}
+
+SignalPublisher::Clock::time_point SignalPublisher::service(const CoppeliasimTransport& transport)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const auto now = Clock::now();
+
+	if (isDirty && hasSent && pending == sent)
+	{
+		isDirty = false;
+		hasChange = false;
+	}
+
+	if (isDirty)
+	{
+		const auto windowEnd = lastChangeWriteTime + parameters.coalesceWindow;
+		if (hasSent && now < windowEnd)
+			return windowEnd;
+
+		const OutgoingSignals signals = pending;
+		const OutgoingSignals previous = sent;
+		const bool all = !hasSent;
+		const bool timed = hasChange;
+		const auto changeTime = firstChangeTime;
+		isDirty = false;
+		hasChange = false;
+		lock.unlock();
+		write(transport, signals, previous, all);
+		const auto acknowledgedTime = Clock::now();
+		lock.lock();
+
+		statistics.writes++;
+		if (timed)
+		{
+			const double latencyMs = std::chrono::duration<double, std::milli>(acknowledgedTime - changeTime).count();
+			timedWrites++;
+			statistics.lastLatencyMs = latencyMs;
+			statistics.meanLatencyMs += (latencyMs - statistics.meanLatencyMs) / static_cast<double>(timedWrites);
+			statistics.maxLatencyMs = std::max(statistics.maxLatencyMs, latencyMs);
+		}
+		sent = signals;
+		hasSent = true;
+		lastChangeWriteTime = acknowledgedTime;
+		lastWriteTime = acknowledgedTime;
+		// Changes made during the write wait for the next window.
+		return isDirty ? lastChangeWriteTime + parameters.coalesceWindow : lastWriteTime + parameters.refreshPeriod;
+	}
+
+	if (!hasSent)
+		return now + parameters.refreshPeriod;
+
+	const auto refreshTime = lastWriteTime + parameters.refreshPeriod;
+	if (now < refreshTime)
+		return refreshTime;
+
+	const OutgoingSignals signals = sent;
+	lock.unlock();
+	write(transport, signals, signals, true);
+	lock.lock();
+	statistics.refreshes++;
+	lastWriteTime = Clock::now();
+	return isDirty ? lastChangeWriteTime + parameters.coalesceWindow : lastWriteTime + parameters.refreshPeriod;
+}
+
+void SignalPublisher::reset()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	hasSent = false;
+	isDirty = true;
+}
+
+SignalPublisherStatistics SignalPublisher::getStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+void SignalPublisher::write(const CoppeliasimTransport& transport, const OutgoingSignals& signals, const OutgoingSignals& previous, bool all) const
+{
+	if (all || signals.startSim != previous.startSim)
+		writeSignal(transport, OutgoingSignals::START_SIM, signals.startSim);
+	if (all || signals.targetObject != previous.targetObject)
+		writeSignal(transport, OutgoingSignals::TARGET_OBJECT, signals.targetObject);
+}
+
+void SignalPublisher::writeSignal(const CoppeliasimTransport& transport, const char* name, int value) const
+{
+	const ScopedTimer timer(writeTime);
+	transport.setIntegerSignal(name, value);
+	remoteWrites.increment();
+}
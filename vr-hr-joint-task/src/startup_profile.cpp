@@ -0,0 +1,56 @@
+#include "startup_profile.h"
+
+#include <cstdio>
+
+#include <tools/logger.h>
+
+#include "event_logger.h"
+#include "metrics.h"
+
+StartupProfile::Clock::time_point StartupProfile::origin = StartupProfile::Clock::now();
+std::mutex StartupProfile::mutex;
+std::set<std::string> StartupProfile::reached;
+
+void StartupProfile::start()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	origin = Clock::now();
+}
+
+std::chrono::microseconds StartupProfile::elapsed()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin);
+}
+
+void StartupProfile::phase(const std::string& name, Clock::time_point begin, Clock::time_point end)
+{
+	Clock::time_point start;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		start = origin;
+	}
+	const auto milliseconds = [](Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+	Metrics::gauge("startup." + name).set(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count());
+	char message[160];
+	std::snprintf(message, sizeof(message), "Startup: %s %.2f ms, from +%.2f ms.", name.c_str(),
+		milliseconds(end - begin), milliseconds(begin - start));
+	EventLogger::log(LogLevel::CONTROL, message);
+	log(dnf_composer::tools::logger::LogLevel::INFO, std::string(message) + "\n");
+}
+
+void StartupProfile::milestone(const std::string& name)
+{
+	std::chrono::microseconds at;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!reached.insert(name).second)
+			return;
+		at = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin);
+	}
+	Metrics::gauge("startup." + name).set(at.count());
+	char message[160];
+	std::snprintf(message, sizeof(message), "Startup: %s at +%.2f ms.", name.c_str(), at.count() / 1000.0);
+	EventLogger::log(LogLevel::CONTROL, message);
+	log(dnf_composer::tools::logger::LogLevel::INFO, std::string(message) + "\n");
+}
@@ -0,0 +1,257 @@
+#include "synthetic_participant.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	Position add(const Position& a, const Position& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	Position subtract(const Position& a, const Position& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	Position scale(const Position& a, double factor) { return { a.x * factor, a.y * factor, a.z * factor }; }
+}
+
+SyntheticParticipant::SyntheticParticipant(const SyntheticParticipantParameters& parameters)
+	: parameters(parameters)
+{
+	reset();
+}
+
+void SyntheticParticipant::reset()
+{
+	generator.seed(parameters.seed);
+	spareNormal = 0;
+	hasSpareNormal = false;
+	sampleIndex = 0;
+	origin = parameters.restPosition;
+	movementCount = 0;
+	switchTime = std::numeric_limits<double>::infinity();
+	switchTarget = 0;
+	trial = 1;
+	object = 0;
+	objectPresent = { true, true, true };
+	humanGrasping = { false, false, false };
+	humanPlacing = { false, false, false };
+	enterPhase(Phase::WAIT, 0);
+}
+
+SyntheticSample SyntheticParticipant::next()
+{
+	const double time = static_cast<double>(sampleIndex++) / parameters.sampleRate;
+	advance(time);
+
+	SyntheticSample sample;
+	sample.time = time;
+	const Position position = positionAt(time);
+	sample.pose = Pose({ position.x + parameters.noise * normal(), position.y + parameters.noise * normal(),
+		position.z + parameters.noise * normal() }, Orientation());
+	sample.objectPresent = objectPresent;
+	sample.humanGrasping = humanGrasping;
+	sample.humanPlacing = humanPlacing;
+	switch (phase)
+	{
+	case Phase::REACH:
+		sample.intendedObject = time >= switchTime ? switchTarget : object;
+		break;
+	case Phase::GRASP:
+	case Phase::TRANSPORT:
+	case Phase::PLACE:
+		sample.intendedObject = object;
+		break;
+	default:
+		sample.intendedObject = 0;
+	}
+	sample.trial = trial;
+	return sample;
+}
+
+void SyntheticParticipant::generate(SyntheticSample* samples, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+		samples[i] = next();
+}
+
+double SyntheticParticipant::minimumJerk(double s)
+{
+	s = std::clamp(s, 0.0, 1.0);
+	return s * s * s * (10.0 + s * (-15.0 + s * 6.0));
+}
+
+void SyntheticParticipant::advance(double time)
+{
+	while (time >= phaseEnd)
+	{
+		const double end = phaseEnd;
+		switch (phase)
+		{
+		case Phase::WAIT:
+			enterPhase(Phase::REACH, end);
+			break;
+		case Phase::REACH:
+			if (switchTarget != 0)
+				object = switchTarget;
+			enterPhase(Phase::GRASP, end);
+			break;
+		case Phase::GRASP:
+			enterPhase(Phase::TRANSPORT, end);
+			break;
+		case Phase::TRANSPORT:
+			enterPhase(Phase::PLACE, end);
+			break;
+		case Phase::PLACE:
+			enterPhase(Phase::RETURN, end);
+			break;
+		case Phase::RETURN:
+		{
+			const bool tableCleared = std::none_of(objectPresent.begin(), objectPresent.end(), [](bool present) { return present; });
+			enterPhase(tableCleared ? Phase::PAUSE : Phase::WAIT, end);
+			break;
+		}
+		case Phase::PAUSE:
+			objectPresent = { true, true, true };
+			trial++;
+			enterPhase(Phase::WAIT, end);
+			break;
+		}
+	}
+}
+
+void SyntheticParticipant::enterPhase(Phase next, double time)
+{
+	// The previous movement has come to rest; the next one starts from there.
+	origin = positionAt(time);
+	movementCount = 0;
+	phase = next;
+
+	switch (next)
+	{
+	case Phase::WAIT:
+		phaseEnd = time + std::max(0.0, uniform(parameters.onsetDelay - parameters.onsetJitter, parameters.onsetDelay + parameters.onsetJitter));
+		break;
+	case Phase::REACH:
+		startReach(time);
+		break;
+	case Phase::GRASP:
+		switchTarget = 0;
+		switchTime = std::numeric_limits<double>::infinity();
+		humanGrasping[object - 1] = true;
+		phaseEnd = time + parameters.graspDuration;
+		break;
+	case Phase::TRANSPORT:
+		startMovement(time, parameters.placePosition);
+		break;
+	case Phase::PLACE:
+		humanPlacing[object - 1] = true;
+		phaseEnd = time + parameters.placeDuration;
+		break;
+	case Phase::RETURN:
+		objectPresent[object - 1] = false;
+		humanGrasping[object - 1] = false;
+		humanPlacing[object - 1] = false;
+		object = 0;
+		startMovement(time, parameters.restPosition);
+		break;
+	case Phase::PAUSE:
+		phaseEnd = time + parameters.trialPause;
+		break;
+	}
+}
+
+void SyntheticParticipant::startReach(double time)
+{
+	object = pickObject(0);
+	const Position target = targetOf(object);
+	const Position delta = subtract(target, origin);
+	const int remaining = static_cast<int>(std::count(objectPresent.begin(), objectPresent.end(), true));
+
+	if (remaining > 1 && uniform() < parameters.switchProbability)
+	{
+		// The second movement is added on top of the first, so the hand turns smoothly.
+		const double duration = movementDuration(origin, target);
+		switchTarget = pickObject(object);
+		switchTime = time + duration * uniform(0.25, 0.55);
+		const Position switchTargetPosition = targetOf(switchTarget);
+		movements[0] = { time, duration, delta };
+		movements[1] = { switchTime, movementDuration(target, switchTargetPosition), subtract(switchTargetPosition, target) };
+		movementCount = 2;
+		phaseEnd = std::max(time + duration, movements[1].start + movements[1].duration);
+	}
+	else if (uniform() < parameters.hesitationProbability)
+	{
+		// Stops part-way, waits, then completes the reach.
+		const double fraction = uniform(0.4, 0.7);
+		const Position halt = add(origin, scale(delta, fraction));
+		const double firstDuration = movementDuration(origin, halt);
+		const double pause = parameters.hesitationDuration * uniform(0.5, 1.5);
+		movements[0] = { time, firstDuration, scale(delta, fraction) };
+		movements[1] = { time + firstDuration + pause, movementDuration(halt, target), scale(delta, 1.0 - fraction) };
+		movementCount = 2;
+		phaseEnd = movements[1].start + movements[1].duration;
+	}
+	else
+		startMovement(time, target);
+}
+
+void SyntheticParticipant::startMovement(double time, const Position& target)
+{
+	movements[0] = { time, movementDuration(origin, target), subtract(target, origin) };
+	movementCount = 1;
+	phaseEnd = time + movements[0].duration;
+}
+
+Position SyntheticParticipant::positionAt(double time) const
+{
+	Position position = origin;
+	for (int i = 0; i < movementCount; ++i)
+		position = add(position, scale(movements[i].delta, minimumJerk((time - movements[i].start) / movements[i].duration)));
+	return position;
+}
+
+Position SyntheticParticipant::targetOf(int objectNumber) const
+{
+	return getTableObjectPositions()[objectNumber - 1];
+}
+
+int SyntheticParticipant::pickObject(int excluded)
+{
+	int candidates[3];
+	int count = 0;
+	for (int i = 0; i < 3; ++i)
+		if (objectPresent[i] && i + 1 != excluded)
+			candidates[count++] = i + 1;
+	if (count == 0)
+		return excluded;
+	return candidates[std::min(count - 1, static_cast<int>(uniform() * count))];
+}
+
+double SyntheticParticipant::movementDuration(const Position& from, const Position& to)
+{
+	static constexpr double minimumDuration = 0.2;
+	const double speed = parameters.meanSpeed * uniform(1.0 - parameters.speedJitter, 1.0 + parameters.speedJitter);
+	return std::max(minimumDuration, calculateEuclideanDistance(from, to) / std::max(speed, 1e-3));
+}
+
+// The standard distributions are implementation-defined, so uniform and normal variates are
+// derived from the raw 64-bit stream to keep a seed reproducible across compilers.
+double SyntheticParticipant::uniform()
+{
+	return static_cast<double>(generator() >> 11) * 0x1.0p-53;
+}
+
+double SyntheticParticipant::uniform(double low, double high)
+{
+	return low + (high - low) * uniform();
+}
+
+double SyntheticParticipant::normal()
+{
+	if (hasSpareNormal)
+	{
+		hasSpareNormal = false;
+		return spareNormal;
+	}
+	const double radius = std::sqrt(-2.0 * std::log(1.0 - uniform()));
+	const double angle = 2.0 * std::numbers::pi * uniform();
+	spareNormal = radius * std::sin(angle);
+	hasSpareNormal = true;
+	return radius * std::cos(angle);
+}
@@ -0,0 +1,206 @@
+#include "thread_layout.h"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+#include <tools/logger.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+#include "event_logger.h"
+
+std::unordered_map<std::string, ThreadPlacement> ThreadLayout::placements;
+std::mutex ThreadLayout::mutex;
+
+std::string ThreadPlacement::toString() const
+{
+	std::stringstream ss;
+	if (cpus.empty())
+		ss << "cpus = default";
+	else
+	{
+		ss << "cpus = {";
+		for (size_t i = 0; i < cpus.size(); ++i)
+			ss << (i ? "," : "") << cpus[i];
+		ss << "}";
+	}
+	if (realtime)
+		ss << ", realtime priority = " << priority;
+	else if (niceness != 0)
+		ss << ", niceness = " << niceness;
+	return ss.str();
+}
+
+void ThreadLayout::load(const std::string& filePath)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	placements.clear();
+
+	std::ifstream file(filePath);
+	if (!file.is_open())
+	{
+		log(dnf_composer::tools::logger::LogLevel::INFO, "No thread layout found at " + filePath + ", using default thread placement.\n");
+		return;
+	}
+
+	try
+	{
+		const nlohmann::json config = nlohmann::json::parse(file);
+		const int availableCpus = static_cast<int>(std::thread::hardware_concurrency());
+		for (const auto& [name, entry] : config.at("threads").items())
+		{
+			ThreadPlacement placement;
+			for (const int cpu : entry.value("cpus", std::vector<int>{}))
+			{
+				if (cpu < 0 || (availableCpus > 0 && cpu >= availableCpus))
+				{
+					log(dnf_composer::tools::logger::LogLevel::WARNING, "Thread layout: ignoring cpu " + std::to_string(cpu) + " for thread '" + name + "'.\n");
+					continue;
+				}
+				placement.cpus.push_back(cpu);
+			}
+			placement.realtime = entry.value("realtime", false);
+			placement.priority = entry.value("priority", placement.realtime ? 50 : 0);
+			placement.niceness = entry.value("niceness", 0);
+			placements[name] = placement;
+		}
+	}
+	catch (const nlohmann::json::exception& e)
+	{
+		placements.clear();
+		log(dnf_composer::tools::logger::LogLevel::WARNING, "Invalid thread layout " + filePath + ": " + e.what() + ". Using default thread placement.\n");
+	}
+}
+
+void ThreadLayout::applyToCurrentThread(const std::string& threadName)
+{
+	ThreadPlacement placement;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const auto it = placements.find(threadName);
+		if (it == placements.end())
+			return;
+		placement = it->second;
+	}
+
+	std::string result = placement.toString();
+	std::string error;
+	if (!placement.cpus.empty() && !setAffinity(placement.cpus, error))
+		result += " (affinity failed: " + error + ")";
+	error.clear();
+	if ((placement.realtime || placement.niceness != 0) && !setScheduling(placement, error))
+		result += " (scheduling failed: " + error + ")";
+
+	log(dnf_composer::tools::logger::LogLevel::INFO, "Thread '" + threadName + "' placed: " + result + ".\n");
+	EventLogger::log(LogLevel::CONTROL, "Thread '" + threadName + "' placed: " + result + ".");
+}
+
+void ThreadLayout::report()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (placements.empty())
+	{
+		EventLogger::log(LogLevel::CONTROL, "Thread layout: default placement for all threads.");
+		return;
+	}
+	log(dnf_composer::tools::logger::LogLevel::INFO, "Thread layout:\n");
+	for (const auto& [name, placement] : placements)
+	{
+		log(dnf_composer::tools::logger::LogLevel::INFO, "  " + name + ": " + placement.toString() + "\n");
+		EventLogger::log(LogLevel::CONTROL, "Thread layout: " + name + ": " + placement.toString() + ".");
+	}
+}
+
+#ifdef _WIN32
+
+bool ThreadLayout::setAffinity(const std::vector<int>& cpus, std::string& error)
+{
+	DWORD_PTR mask = 0;
+	for (const int cpu : cpus)
+		if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+			mask |= static_cast<DWORD_PTR>(1) << cpu;
+	if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+	{
+		error = "error " + std::to_string(GetLastError());
+		return false;
+	}
+	return true;
+}
+
+bool ThreadLayout::setScheduling(const ThreadPlacement& placement, std::string& error)
+{
+	// Windows has no per-thread niceness; map it onto the relative thread priorities.
+	int priority = THREAD_PRIORITY_NORMAL;
+	if (placement.realtime)
+		priority = THREAD_PRIORITY_TIME_CRITICAL;
+	else if (placement.niceness <= -10)
+		priority = THREAD_PRIORITY_HIGHEST;
+	else if (placement.niceness < 0)
+		priority = THREAD_PRIORITY_ABOVE_NORMAL;
+	else if (placement.niceness >= 10)
+		priority = THREAD_PRIORITY_LOWEST;
+	else if (placement.niceness > 0)
+		priority = THREAD_PRIORITY_BELOW_NORMAL;
+
+	if (!SetThreadPriority(GetCurrentThread(), priority))
+	{
+		error = "error " + std::to_string(GetLastError());
+		return false;
+	}
+	return true;
+}
+
+#else
+
+bool ThreadLayout::setAffinity(const std::vector<int>& cpus, std::string& error)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (const int cpu : cpus)
+		CPU_SET(cpu, &set);
+	const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (rc != 0)
+	{
+		error = std::strerror(rc);
+		return false;
+	}
+	return true;
+}
+
+bool ThreadLayout::setScheduling(const ThreadPlacement& placement, std::string& error)
+{
+	if (placement.realtime)
+	{
+		sched_param param{};
+		param.sched_priority = placement.priority;
+		const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (rc != 0)
+		{
+			error = std::strerror(rc);
+			return false;
+		}
+		return true;
+	}
+
+	// On Linux niceness is a per-thread attribute addressed by the kernel thread id.
+	const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+	if (setpriority(PRIO_PROCESS, tid, placement.niceness) != 0)
+	{
+		error = std::strerror(errno);
+		return false;
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,356 @@
+#include "traffic_capture.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "event_logger.h"
+
+using traffic::CallType;
+
+RecordingTransport::RecordingTransport(std::unique_ptr<CoppeliasimTransport> inner, std::string path)
+	: inner(std::move(inner))
+	, path(std::move(path))
+	, buffer(1 << 16)
+	, start(Clock::now())
+	, lastFlush(start)
+	, recordedCalls(Metrics::counter("traffic.recordedCalls"))
+{}
+
+RecordingTransport::~RecordingTransport()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (file.is_open())
+		file.close();
+}
+
+bool RecordingTransport::open()
+{
+	if (path.empty())
+		path = EventLogger::getSessionDirectory() + "/traffic.bin";
+	file.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	file.open(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!file.is_open())
+	{
+		EventLogger::log(LogLevel::CONTROL, "Could not open traffic capture " + path + ".");
+		return false;
+	}
+	start = Clock::now();
+	lastFlush = start;
+	const int64_t wallStart = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	file.write(traffic::MAGIC, sizeof(traffic::MAGIC));
+	put(wallStart);
+	EventLogger::log(LogLevel::CONTROL, "Recording simulator traffic to " + path + ".");
+	return true;
+}
+
+uint16_t RecordingTransport::nameId(const std::string& name) const
+{
+	const auto it = names.find(name);
+	if (it != names.end())
+		return it->second;
+	const uint16_t id = static_cast<uint16_t>(names.size());
+	const uint16_t length = static_cast<uint16_t>(std::min<size_t>(name.size(), UINT16_MAX));
+	names.emplace(name, id);
+	put(CallType::NAME);
+	put(id);
+	put(length);
+	file.write(name.data(), length);
+	return id;
+}
+
+void RecordingTransport::writeCall(CallType type, Clock::time_point begin) const
+{
+	const auto now = Clock::now();
+	put(type);
+	put(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(begin - start).count()));
+	put(static_cast<uint32_t>(std::min<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - begin).count(), UINT32_MAX)));
+	recordedCalls.increment();
+	// Buffered, but never more than a second behind, so a crash loses little.
+	if (now - lastFlush > std::chrono::seconds(1))
+	{
+		file.flush();
+		lastFlush = now;
+	}
+}
+
+bool RecordingTransport::initialize()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!file.is_open() && !open())
+		return inner->initialize();
+	const auto begin = Clock::now();
+	const bool result = inner->initialize();
+	writeCall(CallType::INITIALIZE, begin);
+	put(static_cast<uint8_t>(result));
+	return result;
+}
+
+bool RecordingTransport::isConnected() const
+{
+	return inner->isConnected();
+}
+
+void RecordingTransport::startSimulation() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto begin = Clock::now();
+	inner->startSimulation();
+	if (file.is_open())
+		writeCall(CallType::START_SIMULATION, begin);
+}
+
+void RecordingTransport::stopSimulation() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto begin = Clock::now();
+	inner->stopSimulation();
+	if (file.is_open())
+		writeCall(CallType::STOP_SIMULATION, begin);
+}
+
+int RecordingTransport::getIntegerSignal(const std::string& name) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto begin = Clock::now();
+	const int value = inner->getIntegerSignal(name);
+	if (file.is_open())
+	{
+		const uint16_t id = nameId(name);
+		writeCall(CallType::GET_SIGNAL, begin);
+		put(id);
+		put(static_cast<int32_t>(value));
+	}
+	return value;
+}
+
+void RecordingTransport::setIntegerSignal(const std::string& name, int value) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto begin = Clock::now();
+	inner->setIntegerSignal(name, value);
+	if (file.is_open())
+	{
+		const uint16_t id = nameId(name);
+		writeCall(CallType::SET_SIGNAL, begin);
+		put(id);
+		put(static_cast<int32_t>(value));
+	}
+}
+
+int RecordingTransport::getObjectHandle(const std::string& name) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto begin = Clock::now();
+	const int handle = inner->getObjectHandle(name);
+	if (file.is_open())
+	{
+		const uint16_t id = nameId(name);
+		writeCall(CallType::GET_HANDLE, begin);
+		put(id);
+		put(static_cast<int32_t>(handle));
+	}
+	return handle;
+}
+
+Pose RecordingTransport::getObjectPose(int handle) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto begin = Clock::now();
+	const Pose pose = inner->getObjectPose(handle);
+	if (file.is_open())
+	{
+		writeCall(CallType::GET_POSE, begin);
+		put(static_cast<int32_t>(handle));
+		const double values[6] = { pose.position.x, pose.position.y, pose.position.z,
+			pose.orientation.alpha, pose.orientation.beta, pose.orientation.gamma };
+		file.write(reinterpret_cast<const char*>(values), sizeof(values));
+	}
+	return pose;
+}
+
+ReplayTransport::ReplayTransport(std::string path, double speed)
+	: path(std::move(path))
+	, speed(speed)
+	, loaded(false)
+	, connected(false)
+	, exhausted(false)
+	, mismatches(Metrics::counter("traffic.replayMismatches"))
+{}
+
+bool ReplayTransport::load()
+{
+	std::ifstream file(path, std::ifstream::binary);
+	char magic[sizeof(traffic::MAGIC)];
+	int64_t wallStart = 0;
+	if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, traffic::MAGIC, sizeof(magic)) != 0
+		|| !file.read(reinterpret_cast<char*>(&wallStart), sizeof(wallStart)))
+	{
+		EventLogger::log(LogLevel::CONTROL, "Could not read traffic capture " + path + ".");
+		return false;
+	}
+
+	const auto get = [&file](auto& value) { return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(value))); };
+	size_t count = 0;
+	CallType type;
+	while (get(type))
+	{
+		if (type == CallType::NAME)
+		{
+			uint16_t id = 0, length = 0;
+			if (!get(id) || !get(length))
+				break;
+			std::string name(length, '\0');
+			if (!file.read(name.data(), length))
+				break;
+			names[name] = id;
+			continue;
+		}
+
+		Record record{};
+		if (!get(record.time) || !get(record.duration))
+			break;
+		uint32_t argument = 0;
+		int32_t value = 0;
+		bool complete = true;
+		switch (type)
+		{
+		case CallType::INITIALIZE:
+		{
+			uint8_t result = 0;
+			complete = get(result);
+			value = result;
+			break;
+		}
+		case CallType::START_SIMULATION:
+		case CallType::STOP_SIMULATION:
+			break;
+		case CallType::GET_SIGNAL:
+		case CallType::SET_SIGNAL:
+		case CallType::GET_HANDLE:
+		{
+			uint16_t id = 0;
+			complete = get(id) && get(value);
+			argument = id;
+			break;
+		}
+		case CallType::GET_POSE:
+		{
+			double values[6];
+			complete = get(value) && static_cast<bool>(file.read(reinterpret_cast<char*>(values), sizeof(values)));
+			argument = static_cast<uint32_t>(value);
+			record.pose = { { values[0], values[1], values[2] }, { values[3], values[4], values[5] } };
+			break;
+		}
+		default:
+			complete = false;
+		}
+		if (!complete)
+			break;
+		record.value = value;
+		sequences[keyOf(type, argument)].records.push_back(record);
+		count++;
+	}
+	EventLogger::log(LogLevel::CONTROL, "Replaying " + std::to_string(count) + " simulator calls from " + path
+		+ (speed > 0 ? " at " + std::to_string(speed) + "x speed." : " as fast as possible."));
+	return true;
+}
+
+uint64_t ReplayTransport::keyOf(CallType type, uint32_t argument)
+{
+	return static_cast<uint64_t>(type) << 32 | argument;
+}
+
+uint64_t ReplayTransport::keyOf(CallType type, const std::string& name) const
+{
+	const auto it = names.find(name);
+	// Names that were never captured get a key no sequence has.
+	return keyOf(type, it != names.end() ? it->second : 0x10000u);
+}
+
+const ReplayTransport::Record* ReplayTransport::next(uint64_t key) const
+{
+	const auto it = sequences.find(key);
+	if (it == sequences.end())
+	{
+		mismatches.increment();
+		return nullptr;
+	}
+	Sequence& sequence = it->second;
+	if (sequence.next >= sequence.records.size())
+	{
+		exhausted.store(true, std::memory_order_release);
+		connected.store(false, std::memory_order_release);
+		return nullptr;
+	}
+	const Record& record = sequence.records[sequence.next++];
+	if (speed > 0)
+	{
+		const auto scaled = [this](uint64_t nanoseconds) {
+			return std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(nanoseconds) / speed));
+		};
+		std::this_thread::sleep_until(start + scaled(record.time));
+		std::this_thread::sleep_for(scaled(record.duration));
+	}
+	return &record;
+}
+
+bool ReplayTransport::initialize()
+{
+	if (!loaded)
+	{
+		if (!load())
+			return false;
+		loaded = true;
+		start = Clock::now();
+	}
+	if (exhausted.load(std::memory_order_acquire))
+		return false;
+	const Record* record = next(keyOf(CallType::INITIALIZE, 0u));
+	connected.store(record != nullptr && record->value != 0, std::memory_order_release);
+	return isConnected();
+}
+
+bool ReplayTransport::isConnected() const
+{
+	return connected.load(std::memory_order_acquire);
+}
+
+void ReplayTransport::startSimulation() const
+{
+	next(keyOf(CallType::START_SIMULATION, 0u));
+}
+
+void ReplayTransport::stopSimulation() const
+{
+	next(keyOf(CallType::STOP_SIMULATION, 0u));
+}
+
+int ReplayTransport::getIntegerSignal(const std::string& name) const
+{
+	const Record* record = next(keyOf(CallType::GET_SIGNAL, name));
+	return record != nullptr ? record->value : 0;
+}
+
+void ReplayTransport::setIntegerSignal(const std::string& name, int value) const
+{
+	// Writes are consumed in order; one that differs from the capture means the pipeline
+	// under test decided differently from the one that was recorded.
+	const Record* record = next(keyOf(CallType::SET_SIGNAL, name));
+	if (record != nullptr && record->value != value)
+		mismatches.increment();
+}
+
+int ReplayTransport::getObjectHandle(const std::string& name) const
+{
+	const Record* record = next(keyOf(CallType::GET_HANDLE, name));
+	return record != nullptr ? record->value : -1;
+}
+
+Pose ReplayTransport::getObjectPose(int handle) const
+{
+	const Record* record = next(keyOf(CallType::GET_POSE, static_cast<uint32_t>(handle)));
+	return record != nullptr ? record->pose : Pose({ 0, 0, 0 }, { 0, 0, 0 });
+}
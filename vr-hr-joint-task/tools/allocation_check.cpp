@@ -0,0 +1,247 @@
+// Runs the experiment's own SignalBridge against an in-process stand-in for the simulator and
+// counts heap allocations per tick through an instrumented global allocator: pose and signal
+// reads on the I/O thread, the bridge with its input frames, decision log and hand pose log
+// line, the engine's steps and decisions, and the signal write. The engine is the production
+// default, dnf-composer without its plot windows, or with --engine remote the out-of-process
+// engine, stepped on a thread of this process. Exits with 1 if any tick after the warm-up allocates.
+// Usage: vr-hr-joint-task-allocation-check [--engine in-process|remote]
+//        [--architecture hand-motion|action-likelihood] [--precision double|float|mixed (remote)]
+//        [--warmup N] [--ticks N]
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "coppeliasim_handler.h"
+#include "coroutine_executor.h"
+#include "dnf_composer_handler.h"
+#include "event_logger.h"
+#include "remote_dnf_engine.h"
+#include "signal_bridge.h"
+
+namespace
+{
+	std::atomic<uint64_t> allocations{ 0 };
+
+	void* allocate(std::size_t size)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		if (void* pointer = std::malloc(size == 0 ? 1 : size))
+			return pointer;
+		throw std::bad_alloc();
+	}
+
+	void* allocateAligned(std::size_t size, std::align_val_t alignment)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+		if (void* pointer = _aligned_malloc(size == 0 ? 1 : size, align))
+#else
+		if (void* pointer = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align))
+#endif
+			return pointer;
+		throw std::bad_alloc();
+	}
+
+	void deallocateAligned(void* pointer)
+	{
+#ifdef _WIN32
+		_aligned_free(pointer);
+#else
+		std::free(pointer);
+#endif
+	}
+
+	// Stand-in for the scene: all objects present, the simulation started and the hand
+	// sweeping back and forth across the table.
+	class SyntheticTransport : public CoppeliasimTransport
+	{
+	private:
+		mutable uint64_t poseReads = 0;
+	public:
+		bool initialize() override { return true; }
+		bool isConnected() const override { return true; }
+		void startSimulation() const override {}
+		void stopSimulation() const override {}
+		int getIntegerSignal(const std::string& name) const override
+		{
+			return name == IncomingSignals::SIM_STARTED || name == IncomingSignals::OBJECT1_EXISTS
+				|| name == IncomingSignals::OBJECT2_EXISTS || name == IncomingSignals::OBJECT3_EXISTS;
+		}
+		void setIntegerSignal(const std::string&, int) const override {}
+		int getObjectHandle(const std::string&) const override { return 1; }
+		Pose getObjectPose(int) const override
+		{
+			const double phase = static_cast<double>(poseReads++) * 0.02;
+			return { { 0.3 + 0.1 * std::cos(phase), 0.25 * std::sin(phase), 0.8 }, { 0, 0, 0 } };
+		}
+	};
+
+	struct Options
+	{
+		DnfEngineLocation engine = DnfEngineLocation::IN_PROCESS;
+		DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION;
+		FieldPrecision precision = FieldPrecision::DOUBLE;
+		int warmup = 200;
+		int ticks = 1000;
+	};
+
+	// Every update the I/O thread delivers starts a tick. This coroutine is resumed in the same
+	// pass as the bridge, so everything allocated since the previous update, on any thread, is
+	// charged to the tick. Stops the bridge after the last tick.
+	Coroutine countAllocations(CoppeliasimHandler& handler, AsyncCondition& updates, std::atomic<bool>& stopRequested,
+		const Options& options, std::vector<uint64_t>& allocationsPerTick)
+	{
+		uint64_t handledUpdate = 0;
+		uint64_t tickStart = 0;
+		for (int tick = 0; tick < options.warmup + options.ticks; ++tick)
+		{
+			co_await updates.until([&handler, &handledUpdate] { return handler.getUpdateCount() != handledUpdate; });
+			handledUpdate = handler.getUpdateCount();
+
+			const uint64_t now = allocations.load(std::memory_order_relaxed);
+			if (tick > options.warmup)
+				allocationsPerTick[tick - options.warmup - 1] = now - tickStart;
+			tickStart = now;
+		}
+		allocationsPerTick.back() = allocations.load(std::memory_order_relaxed) - tickStart;
+		stopRequested = true;
+		updates.notify();
+	}
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size == 0 ? 1 : size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size == 0 ? 1 : size);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { deallocateAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { deallocateAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { deallocateAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { deallocateAligned(pointer); }
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--engine" && hasValue)
+			options.engine = std::string(argv[++i]) == "remote" ? DnfEngineLocation::OUT_OF_PROCESS : DnfEngineLocation::IN_PROCESS;
+		else if (argument == "--architecture" && hasValue)
+			options.architecture = std::string(argv[++i]) == "action-likelihood" ? DnfArchitectureType::ACTION_LIKELIHOOD : DnfArchitectureType::HAND_MOTION;
+		else if (argument == "--precision" && hasValue)
+		{
+			const std::string precision = argv[++i];
+			options.precision = precision == "float" ? FieldPrecision::FLOAT : precision == "mixed" ? FieldPrecision::MIXED : FieldPrecision::DOUBLE;
+		}
+		else if (argument == "--warmup" && hasValue)
+			options.warmup = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "--ticks" && hasValue)
+			options.ticks = std::max(1, std::atoi(argv[++i]));
+	}
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "vr-hr-joint-task-allocation-check";
+	EventLogger::initialize(directory.string());
+
+	std::vector<uint64_t> allocationsPerTick(options.ticks, 0);
+	uint64_t decisions = 0;
+	{
+		constexpr double deltaT = 65;
+		const std::chrono::microseconds stepPeriod(16667);
+		const std::string regionName = "vr-hr-joint-task-allocation-check";
+		std::unique_ptr<DnfEngineServer> server;
+		std::unique_ptr<DnfEngine> dnfEngine;
+		if (options.engine == DnfEngineLocation::OUT_OF_PROCESS)
+		{
+			server = std::make_unique<DnfEngineServer>(DnfEngineServerParameters{ options.architecture, options.precision,
+				deltaT, stepPeriod, {}, regionName });
+			if (!server->open())
+				return 2;
+			dnfEngine = std::make_unique<RemoteDnfEngine>(options.architecture, DnfEngineParameters{ DnfEngineLocation::OUT_OF_PROCESS, regionName });
+		}
+		else
+			dnfEngine = std::make_unique<DnfComposerHandler>(options.architecture, deltaT, FieldRecorderParameters{},
+				SimulationLoopParameters(stepPeriod, 30, 1, false));
+		DnfEngine& engine = *dnfEngine;
+		CoppeliasimHandler handler(std::make_unique<SyntheticTransport>());
+		const std::vector<std::unique_ptr<ShadowRunner>> shadows;
+		DecisionLog decisionLog;
+		decisionLog.open((directory / "decisions.csv").string());
+		Executor executor;
+		AsyncCondition updates(executor);
+		std::atomic<bool> stopRequested{ false };
+		SignalBridge bridge(handler, engine, shadows, decisionLog, updates, stopRequested);
+
+		std::atomic<bool> serverStop{ false };
+		std::thread engineThread;
+		if (server)
+			engineThread = std::thread([&] { server->run(serverStop); });
+		handler.setUpdateListener([&updates] { updates.notify(); });
+		engine.setDecisionListener([&updates] { updates.notify(); });
+		engine.init();
+		bridge.requestSimulationStart();
+		executor.spawn(bridge.run());
+		executor.spawn(countAllocations(handler, updates, stopRequested, options, allocationsPerTick));
+		handler.init();
+		executor.run();
+		handler.end();
+		engine.end();
+		serverStop = true;
+		if (engineThread.joinable())
+			engineThread.join();
+		decisions = engine.getDecisionCount();
+		decisionLog.close();
+	}
+	EventLogger::finalize();
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+
+	uint64_t total = 0, worst = 0;
+	int allocatingTicks = 0, firstAllocatingTick = -1;
+	for (int tick = 0; tick < options.ticks; ++tick)
+	{
+		total += allocationsPerTick[tick];
+		worst = std::max(worst, allocationsPerTick[tick]);
+		if (allocationsPerTick[tick] > 0)
+		{
+			allocatingTicks++;
+			if (firstAllocatingTick < 0)
+				firstAllocatingTick = tick;
+		}
+	}
+	const std::string engineName = options.engine == DnfEngineLocation::OUT_OF_PROCESS
+		? std::string("remote engine, ") + toString(options.precision) + " precision" : std::string("dnf-composer");
+	std::printf("%s, %s: %d ticks after %d warm-up ticks, %llu decisions\n",
+		options.architecture == DnfArchitectureType::HAND_MOTION ? "hand-motion" : "action-likelihood",
+		engineName.c_str(), options.ticks, options.warmup, static_cast<unsigned long long>(decisions));
+	std::printf("allocations: %llu total, %.3f per tick, %llu worst tick, %d ticks allocating",
+		static_cast<unsigned long long>(total), static_cast<double>(total) / options.ticks,
+		static_cast<unsigned long long>(worst), allocatingTicks);
+	if (firstAllocatingTick >= 0)
+		std::printf(" (first at tick %d)", firstAllocatingTick);
+	std::printf("\n");
+	return total == 0 ? 0 : 1;
+}
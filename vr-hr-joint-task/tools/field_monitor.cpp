@@ -0,0 +1,96 @@
+// Watches the fields the experiment publishes through the shared-memory field readout
+// (see include/field_readout_region.h) without touching the experiment process: prints the
+// decision state and the activation peak of every published field at a fixed rate.
+// Enable publishing with params.readout.enabled = true.
+// Usage: vr-hr-joint-task-field-monitor [--name shared-memory-name] [--rate Hz] [--count N]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "field_readout.h"
+
+int main(int argc, char* argv[])
+{
+	std::string name = FieldReadoutParameters().sharedMemoryName;
+	double rate = 10;
+	long count = -1;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--name" && hasValue)
+			name = argv[++i];
+		else if (argument == "--rate" && hasValue)
+			rate = std::max(0.1, std::atof(argv[++i]));
+		else if (argument == "--count" && hasValue)
+			count = std::atol(argv[++i]);
+		else
+		{
+			std::cerr << "Unknown argument " << argument << std::endl;
+			return 2;
+		}
+	}
+
+	FieldReader reader;
+	if (!reader.open(name))
+	{
+		std::cerr << "Could not open the field readout region " << name << "." << std::endl;
+		return 1;
+	}
+
+	const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate));
+	auto next = std::chrono::steady_clock::now();
+	uint64_t lastPublication = 0;
+	size_t retries = 0;
+	for (long line = 0; count < 0 || line < count; )
+	{
+		std::this_thread::sleep_until(next += period);
+		if (!reader.isPublisherAttached())
+		{
+			std::printf("waiting for the publisher\n");
+			continue;
+		}
+		const auto& columns = reader.getColumns();
+
+		// Read in place; the peaks only count if the slot was not rewritten meanwhile.
+		FieldView view;
+		std::string peaks;
+		bool consistent = false;
+		for (int attempt = 0; attempt < 8 && !consistent; ++attempt)
+		{
+			if (!reader.acquire(view))
+				continue;
+			peaks.clear();
+			for (const FieldColumn& column : columns)
+			{
+				if (column.component != "activation")
+					continue;
+				const double* samples = view.column(column);
+				const double* peak = std::max_element(samples, samples + column.size);
+				char text[64];
+				std::snprintf(text, sizeof(text), " %s %.2f@%d", column.element.c_str(),
+					column.size > 0 ? *peak : std::numeric_limits<double>::quiet_NaN(), static_cast<int>(peak - samples));
+				peaks += text;
+			}
+			consistent = reader.validate(view);
+			retries += consistent ? 0 : 1;
+		}
+		if (!consistent || view.publication == lastPublication)
+			continue;
+		lastPublication = view.publication;
+		const double age = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - view.time).count();
+		std::printf("step %llu frame %llu age %.2f ms target %d bump %s %.2f@%.2f |%s (retries %zu)\n",
+			static_cast<unsigned long long>(view.step), static_cast<unsigned long long>(view.inputFrame), age,
+			view.targetObject, view.bump.present ? "yes" : "no", view.bump.amplitude, view.bump.position,
+			peaks.c_str(), retries);
+		std::fflush(stdout);
+		line++;
+	}
+	return 0;
+}
@@ -0,0 +1,171 @@
+// Steps the same dnf-composer architecture serially with Simulation::step() and level by level
+// with a ParallelStepper, feeds both the same synthetic participant, and compares the outputs
+// of every element and the activation of every field after each step. Noise is switched off so
+// the two runs are deterministic. The stepper is stopped and started again every --restart
+// steps. Exits with 1 on the first step where the two differ in any sample.
+// Usage: vr-hr-joint-task-parallel-step-check [--architecture hand-motion|action-likelihood]
+//        [--workers N] [--steps N] [--restart N] [--deltaT ms] [--seed N]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <elements/element_factory.h>
+
+#include "input_staging.h"
+#include "parallel_stepper.h"
+#include "synthetic_participant.h"
+
+namespace
+{
+	struct Options
+	{
+		DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION;
+		int workers = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+		int steps = 5000;
+		int restart = 1000;
+		double deltaT = 65;
+		uint64_t seed = 1;
+	};
+
+	// The stimuli of one simulation, set the way DnfComposerHandler::applyInputs does.
+	class Stimuli
+	{
+	private:
+		std::vector<std::shared_ptr<dnf_composer::element::GaussStimulus>> hand;
+		std::vector<std::shared_ptr<dnf_composer::element::GaussStimulus>> objects;
+	public:
+		Stimuli(const std::shared_ptr<dnf_composer::Simulation>& simulation, DnfArchitectureType architecture)
+		{
+			using dnf_composer::element::GaussStimulus;
+			if (architecture == DnfArchitectureType::HAND_MOTION)
+				hand.push_back(std::dynamic_pointer_cast<GaussStimulus>(simulation->getElement("hand position stimulus")));
+			else
+				for (int i = 0; i < 3; ++i)
+					hand.push_back(std::dynamic_pointer_cast<GaussStimulus>(simulation->getElement("hand position stimulus " + std::to_string(i + 1))));
+			for (int i = 0; i < 3; ++i)
+				objects.push_back(std::dynamic_pointer_cast<GaussStimulus>(simulation->getElement("object stimulus " + std::to_string(i + 1))));
+		}
+
+		void apply(const InputFrame& frame)
+		{
+			const auto set = [](const std::shared_ptr<dnf_composer::element::GaussStimulus>& stimulus, double amplitude, double position) {
+				const auto parameters = stimulus->getParameters();
+				stimulus->setParameters({ parameters.sigma, amplitude, position, false, false });
+			};
+			for (size_t i = 0; i < hand.size(); ++i)
+				set(hand[i], frame.hand[i].amplitude, frame.hand[i].position);
+			for (size_t i = 0; i < objects.size(); ++i)
+				set(objects[i], frame.objectPresent[i] ? 5 : 0, objects[i]->getParameters().position);
+		}
+	};
+
+	// Every output, and the activation of the fields.
+	std::vector<std::pair<std::string, std::string>> getComponents(const DnfArchitectureDescription& description)
+	{
+		std::vector<std::pair<std::string, std::string>> components;
+		for (const auto& element : description.elements)
+		{
+			components.emplace_back(element.name, "output");
+			if (element.type == DnfElementType::NEURAL_FIELD)
+				components.emplace_back(element.name, "activation");
+		}
+		return components;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--architecture" && hasValue)
+			options.architecture = std::string(argv[++i]) == "action-likelihood" ? DnfArchitectureType::ACTION_LIKELIHOOD : DnfArchitectureType::HAND_MOTION;
+		else if (argument == "--workers" && hasValue)
+			options.workers = std::max(2, std::atoi(argv[++i]));
+		else if (argument == "--steps" && hasValue)
+			options.steps = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "--restart" && hasValue)
+			options.restart = std::max(0, std::atoi(argv[++i]));
+		else if (argument == "--deltaT" && hasValue)
+			options.deltaT = std::atof(argv[++i]);
+		else if (argument == "--seed" && hasValue)
+			options.seed = std::strtoull(argv[++i], nullptr, 10);
+		else
+		{
+			std::fprintf(stderr, "Unknown option %s\n", argument.c_str());
+			return 2;
+		}
+	}
+
+	DnfArchitectureDescription description = getDnfArchitectureDescription(options.architecture);
+	for (auto& element : description.elements)
+		if (element.type == DnfElementType::NORMAL_NOISE)
+			element.amplitude = 0;
+
+	const auto serial = createDnfComposerSimulation(description, "serial", options.deltaT);
+	const auto parallel = createDnfComposerSimulation(description, "parallel", options.deltaT);
+	serial->init();
+	parallel->init();
+	Stimuli serialStimuli(serial, options.architecture);
+	Stimuli parallelStimuli(parallel, options.architecture);
+
+	ParallelStepper stepper(parallel, options.workers);
+	stepper.start();
+	std::printf("%s: %d elements in %d levels on %d workers, %d steps, restart every %d\n",
+		toString(options.architecture), stepper.getGraph().getElementCount(), stepper.getGraph().getLevelCount(),
+		stepper.getWorkerCount(), options.steps, options.restart);
+
+	const auto components = getComponents(description);
+	SyntheticParticipantParameters participantParameters;
+	participantParameters.seed = options.seed;
+	SyntheticParticipant participant(participantParameters);
+	// One encoder for both, so both runs see the very same frame.
+	InputEncoder encoder(options.architecture, description);
+	for (int step = 1; step <= options.steps; ++step)
+	{
+		const SyntheticSample sample = participant.next();
+		const InputFrame& frame = encoder.encode(sample.pose.position,
+			sample.objectPresent[0], sample.objectPresent[1], sample.objectPresent[2]);
+		serialStimuli.apply(frame);
+		parallelStimuli.apply(frame);
+		serial->step();
+		stepper.step();
+
+		size_t differences = 0;
+		double maximum = 0;
+		std::string first;
+		for (const auto& [element, component] : components)
+		{
+			const std::vector<double>& a = *serial->getComponentPtr(element, component);
+			const std::vector<double>& b = *parallel->getComponentPtr(element, component);
+			for (size_t k = 0; k < std::min(a.size(), b.size()); ++k)
+			{
+				if (a[k] == b[k])
+					continue;
+				if (differences++ == 0)
+					first = element + " " + component;
+				maximum = std::max(maximum, std::abs(a[k] - b[k]));
+			}
+		}
+		if (differences > 0)
+		{
+			std::printf("step %d: %zu samples differ, first in %s, max %g\n", step, differences, first.c_str(), maximum);
+			return 1;
+		}
+		if (options.restart > 0 && step % options.restart == 0)
+		{
+			stepper.stop();
+			stepper.start();
+		}
+	}
+	stepper.stop();
+	std::printf("identical after %d steps\n", options.steps);
+	return 0;
+}
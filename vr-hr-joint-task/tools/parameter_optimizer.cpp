@@ -0,0 +1,856 @@
+// Searches the kernel parameters of an architecture, and with --fields the resting level and
+// time constant of its fields, for one deltaT. Candidates are replayed on recorded sessions, or
+// on synthetic participants when no session is given. The poses are encoded by the experiment's
+// InputEncoder, with the likelihood parameters of the parameter file, and stepped through the
+// FieldEngine; a BumpDetector with the experiment's parameters takes the robot's target.
+// A candidate is scored on how early the robot commits to an object other than the one the
+// human grasps and on how often it changes its mind. The search is sep-CMA-ES (Ros & Hansen, 2008), a CMA-ES with a
+// diagonal covariance, in parameter units scaled by the built-in values. The candidates of a
+// generation are evaluated on all cores, one trajectory of one candidate per task.
+//
+// After every generation the state of the search is written to the checkpoint, and the best
+// kernels so far to the output in the format of resources/architecture-parameters.json, so a
+// run can be stopped at any time and continued with --resume. Field parameters cannot change
+// at run time; they are printed and have to be set in getDnfArchitectureDescription.
+//
+// Cost of a candidate, lower is better, per human grasp:
+//   1 - (sum over anticipated grasps of (1 + min(lead, max-lead) / max-lead) / 2) / grasps
+//   + conflicts / grasps + stability * (target changes away from an object) / grasps
+// A grasp is anticipated when the robot targets another object at that moment; lead is how
+// long it has been targeting it. In recorded sessions the objects disappear as they were
+// grasped in the recording, by either side.
+// Usage: vr-hr-joint-task-parameter-optimizer [--architecture hand-motion|action-likelihood]
+//        [--precision double|float|mixed] [--deltaT ms] [--step-rate Hz] [--fields]
+//        [--generations N] [--population N] [--sigma s] [--seed N] [--threads N]
+//        [--max-lead s] [--stability w] [--participants N] [--duration s]
+//        [--parameters file] [--checkpoint file] [--output file] [--resume]
+//        [session-or-data-directory ...]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "field_engine.h"
+#include "input_staging.h"
+#include "parameter_watcher.h"
+#include "session_log.h"
+#include "synthetic_participant.h"
+
+namespace
+{
+	struct Options
+	{
+		DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION;
+		FieldPrecision precision = FieldPrecision::DOUBLE;
+		double deltaT = 65;
+		double stepRate = 60;
+		bool fields = false;
+		int generations = 100;
+		int population = 0;			// 0 = 4 + 3 ln(n)
+		double sigma = 0.3;
+		uint64_t seed = 1;
+		int threads = 0;			// 0 = one per core
+		double maxLead = 2.0;
+		double stability = 0.25;
+		int participants = 4;
+		double duration = 300;
+		std::string parameterFile = ParameterWatcherParameters().file;
+		LikelihoodParameters likelihood;	// read from parameterFile
+		std::string checkpoint = std::string(OUTPUT_DIRECTORY) + "/optimizer-checkpoint.txt";
+		std::string output = std::string(OUTPUT_DIRECTORY) + "/optimized-parameters.json";
+		bool resume = false;
+		std::vector<std::string> paths;
+	};
+
+	// One searched value: element.key = initial + scale * y, clamped to [lower, upper].
+	struct Parameter
+	{
+		int element;
+		std::string key;
+		double initial;
+		double scale;
+		double lower;
+		double upper;
+
+		std::string getName(const DnfArchitectureDescription& description) const
+		{
+			return description.elements[element].name + ":" + key;
+		}
+	};
+
+	struct Frame
+	{
+		double time;
+		Position hand;
+		std::array<bool, 3> objectPresent;
+	};
+
+	struct Grasp
+	{
+		double time;
+		int object;
+	};
+
+	// A trajectory the candidates are replayed on, with the human grasps it contains.
+	struct Episode
+	{
+		std::string name;
+		std::vector<Frame> frames;
+		std::vector<Grasp> grasps;
+	};
+
+	struct Score
+	{
+		int grasps = 0;
+		int anticipated = 0;
+		int conflicts = 0;
+		double leadSum = 0;
+		double credit = 0;		// sum of (1 + lead / max-lead) / 2 over anticipated grasps
+		int changes = 0;
+
+		Score& operator+=(const Score& other)
+		{
+			grasps += other.grasps;
+			anticipated += other.anticipated;
+			conflicts += other.conflicts;
+			leadSum += other.leadSum;
+			credit += other.credit;
+			changes += other.changes;
+			return *this;
+		}
+
+		double cost(double stability) const
+		{
+			if (grasps == 0)
+				return 0;
+			return 1.0 - credit / grasps + static_cast<double>(conflicts) / grasps + stability * changes / grasps;
+		}
+	};
+
+	// State of the search; everything the checkpoint holds.
+	struct SearchState
+	{
+		int lambda = 0;
+		int generation = 0;
+		uint64_t evaluations = 0;
+		double sigma = 0;
+		std::vector<double> mean;			// in scaled units y
+		std::vector<double> variance;		// diagonal of C
+		std::vector<double> pathSigma;
+		std::vector<double> pathC;
+		std::vector<double> best;
+		double bestCost = std::numeric_limits<double>::infinity();
+		Score bestScore;
+		std::mt19937_64 random;
+	};
+
+	DnfArchitectureType parseArchitecture(const std::string& name)
+	{
+		return name == "action-likelihood" ? DnfArchitectureType::ACTION_LIKELIHOOD : DnfArchitectureType::HAND_MOTION;
+	}
+
+	FieldPrecision parsePrecision(const std::string& name)
+	{
+		return name == "float" ? FieldPrecision::FLOAT : name == "mixed" ? FieldPrecision::MIXED : FieldPrecision::DOUBLE;
+	}
+
+	double& valueOf(DnfElementDescription& element, const std::string& key)
+	{
+		if (key == "sigma") return element.sigma;
+		if (key == "amplitude") return element.amplitude;
+		if (key == "sigmaInhibitory") return element.sigmaInhibitory;
+		if (key == "amplitudeInhibitory") return element.amplitudeInhibitory;
+		if (key == "amplitudeGlobal") return element.amplitudeGlobal;
+		if (key == "restingLevel") return element.restingLevel;
+		return element.tau;
+	}
+
+	double valueOf(const DnfElementDescription& element, const std::string& key)
+	{
+		return valueOf(const_cast<DnfElementDescription&>(element), key);
+	}
+
+	std::vector<Parameter> getParameters(const DnfArchitectureDescription& description, const Options& options)
+	{
+		std::vector<Parameter> parameters;
+		const auto add = [&](int element, const std::string& key, double lower, double upper) {
+			const double initial = valueOf(description.elements[element], key);
+			const double scale = std::max(std::abs(initial), 0.5);
+			parameters.push_back({ element, key, initial, scale,
+				std::max(lower, initial - 3 * scale), std::min(upper, initial + 3 * scale) });
+		};
+		// Amplitudes keep their sign, so an excitatory kernel stays excitatory.
+		const auto addAmplitude = [&](int element, const std::string& key) {
+			const double initial = valueOf(description.elements[element], key);
+			add(element, key, initial >= 0 ? 0 : -1e9, initial >= 0 ? 1e9 : 0);
+		};
+		const double minimumWidth = description.dx / 2;
+		const double maximumWidth = description.xMax / 2;
+		for (size_t i = 0; i < description.elements.size(); ++i)
+		{
+			const int index = static_cast<int>(i);
+			switch (description.elements[i].type)
+			{
+			case DnfElementType::GAUSS_KERNEL:
+				add(index, "sigma", minimumWidth, maximumWidth);
+				addAmplitude(index, "amplitude");
+				break;
+			case DnfElementType::LATERAL_INTERACTIONS:
+				add(index, "sigma", minimumWidth, maximumWidth);
+				addAmplitude(index, "amplitude");
+				add(index, "sigmaInhibitory", minimumWidth, maximumWidth);
+				addAmplitude(index, "amplitudeInhibitory");
+				addAmplitude(index, "amplitudeGlobal");
+				break;
+			case DnfElementType::NEURAL_FIELD:
+				if (!options.fields)
+					break;
+				add(index, "restingLevel", -1e9, -0.1);
+				// Euler steps are only stable for deltaT / tau <= 1.
+				add(index, "tau", options.deltaT, 1e9);
+				break;
+			default:
+				break;
+			}
+		}
+		return parameters;
+	}
+
+	// Maps scaled units to parameter values; returns the squared distance clamping moved them.
+	double applyCandidate(const std::vector<Parameter>& parameters, const std::vector<double>& y,
+		DnfArchitectureDescription& description)
+	{
+		double outside = 0;
+		for (size_t i = 0; i < parameters.size(); ++i)
+		{
+			const Parameter& parameter = parameters[i];
+			const double value = parameter.initial + parameter.scale * y[i];
+			const double clamped = std::clamp(value, parameter.lower, parameter.upper);
+			outside += std::pow((value - clamped) / parameter.scale, 2);
+			valueOf(description.elements[parameter.element], parameter.key) = clamped;
+		}
+		return outside;
+	}
+
+	std::vector<std::string> findSessions(const std::vector<std::string>& paths)
+	{
+		std::vector<std::string> sessions;
+		for (const auto& path : paths)
+		{
+			if (SessionIndex::isSession(path))
+			{
+				sessions.push_back(path);
+				continue;
+			}
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(path, error))
+				if (entry.is_directory() && SessionIndex::isSession(entry.path().string()))
+					sessions.push_back(entry.path().string());
+		}
+		std::sort(sessions.begin(), sessions.end());
+		return sessions;
+	}
+
+	bool loadSession(const std::string& directory, Episode& episode)
+	{
+		SessionIndex index;
+		if (!index.load(directory))
+			return false;
+		std::vector<SessionEvent> events;
+		std::vector<HandSample> trajectory;
+		index.read("logs", {}, SESSION_END, [&](std::string_view text) { SessionLogParser::parseEvents(text, events); });
+		index.read("logs_human", {}, SESSION_END, [&](std::string_view text) { SessionLogParser::parseHandTrajectory(text, trajectory); });
+
+		episode.name = std::filesystem::path(directory).filename().string();
+		std::array<bool, 3> present = { true, true, true };
+		size_t next = 0;
+		for (const HandSample& sample : trajectory)
+		{
+			for (; next < events.size() && events[next].time <= sample.time; ++next)
+			{
+				const SessionEvent& event = events[next];
+				const bool validObject = event.object >= 1 && event.object <= 3;
+				if (event.type == SessionEventType::SIMULATION_STARTED)
+					present = { true, true, true };
+				else if (event.type == SessionEventType::HUMAN_GRASP && validObject)
+				{
+					episode.grasps.push_back({ event.time, event.object });
+					present[event.object - 1] = false;
+				}
+				else if (event.type == SessionEventType::ROBOT_GRASP && validObject)
+					present[event.object - 1] = false;
+			}
+			episode.frames.push_back({ sample.time, sample.pose.position, present });
+		}
+		return !episode.frames.empty() && !episode.grasps.empty();
+	}
+
+	Episode generateEpisode(const Options& options, int participant)
+	{
+		SyntheticParticipantParameters parameters;
+		parameters.seed = options.seed + participant;
+		SyntheticParticipant generator(parameters);
+		Episode episode;
+		episode.name = "participant " + std::to_string(participant + 1);
+		const auto count = static_cast<size_t>(options.duration * parameters.sampleRate);
+		std::vector<SyntheticSample> samples(count);
+		generator.generate(samples.data(), count);
+		episode.frames.reserve(count);
+		for (size_t k = 0; k < count; ++k)
+		{
+			const SyntheticSample& sample = samples[k];
+			episode.frames.push_back({ sample.time, sample.pose.position, sample.objectPresent });
+			for (int i = 0; i < 3; ++i)
+				if (sample.humanGrasping[i] && (k == 0 || !samples[k - 1].humanGrasping[i]))
+					episode.grasps.push_back({ sample.time, i + 1 });
+		}
+		return episode;
+	}
+
+	// Replays one episode the way the bridge feeds the fields, stepping at the simulation rate.
+	Score evaluate(const DnfArchitectureDescription& description, const Episode& episode, const Options& options)
+	{
+		const std::unique_ptr<FieldEngineBase> engine = createFieldEngine(description, options.deltaT);
+		const bool handMotion = options.architecture == DnfArchitectureType::HAND_MOTION;
+		InputEncoder encoder(options.architecture, description);
+		encoder.setLikelihood(options.likelihood);
+		std::array<int, 3> handStimuli{}, objectStimuli{};
+		std::array<double, 3> objectPositions{};
+		for (int i = 0; i < 3; ++i)
+		{
+			handStimuli[i] = engine->indexOf(handMotion ? "hand position stimulus" : "hand position stimulus " + std::to_string(i + 1));
+			objectStimuli[i] = engine->indexOf("object stimulus " + std::to_string(i + 1));
+			objectPositions[i] = description.elements[objectStimuli[i]].position;
+		}
+		// The target is decided as the experiment decides it, not by the centroid.
+		const int actionExecutionField = engine->indexOf("ael");
+		BumpDetector detector(BumpDetectorParameters(), description.circular, description.xMax);
+		engine->init();
+
+		Score score;
+		int target = 0;
+		double targetTime = 0;
+		double pendingSteps = 0;
+		uint64_t step = 0;
+		size_t grasp = 0;
+		for (size_t k = 0; k < episode.frames.size(); ++k)
+		{
+			const Frame& frame = episode.frames[k];
+			const Frame& previous = episode.frames[k == 0 ? 0 : k - 1];
+			// The recorded time stands in for the clock the bridge encodes with.
+			const auto time = InputFrame::Clock::time_point(std::chrono::duration_cast<InputFrame::Clock::duration>(
+				std::chrono::duration<double>(frame.time)));
+			const InputFrame& input = encoder.encode(frame.hand,
+				frame.objectPresent[0], frame.objectPresent[1], frame.objectPresent[2], time);
+			for (int i = 0; i < input.handStimulusCount; ++i)
+				engine->setStimulus(handStimuli[i], input.hand[i].amplitude, input.hand[i].position);
+			for (int i = 0; i < 3; ++i)
+				engine->setStimulus(objectStimuli[i], input.objectPresent[i] ? 5 : 0, objectPositions[i]);
+
+			// The simulation thread steps at its own rate, not once per pose.
+			pendingSteps += std::clamp(k == 0 ? 1.0 : (frame.time - previous.time) * options.stepRate, 0.0, 600.0);
+			for (; pendingSteps >= 1; pendingSteps -= 1)
+			{
+				engine->step();
+				DecisionEvent event;
+				engine->updateDetector(actionExecutionField, detector, step++, event);
+			}
+
+			const int current = detector.getDecision();
+			if (current != target)
+			{
+				if (target != 0)
+					score.changes++;
+				target = current;
+				targetTime = frame.time;
+			}
+			for (; grasp < episode.grasps.size() && episode.grasps[grasp].time <= frame.time; ++grasp)
+			{
+				score.grasps++;
+				if (target == 0)
+					continue;
+				if (target == episode.grasps[grasp].object)
+				{
+					score.conflicts++;
+					continue;
+				}
+				const double lead = std::min(episode.grasps[grasp].time - targetTime, options.maxLead);
+				score.anticipated++;
+				score.leadSum += lead;
+				score.credit += (1 + lead / options.maxLead) / 2;
+			}
+		}
+		return score;
+	}
+
+	// Evaluates every candidate on every episode, spreading the pairs over the worker threads.
+	std::vector<Score> evaluatePopulation(const std::vector<DnfArchitectureDescription>& candidates,
+		const std::vector<Episode>& episodes, const Options& options, int threadCount)
+	{
+		const size_t taskCount = candidates.size() * episodes.size();
+		std::vector<Score> results(taskCount);
+		std::atomic<size_t> nextTask = 0;
+		const auto work = [&] {
+			for (size_t task = nextTask++; task < taskCount; task = nextTask++)
+				results[task] = evaluate(candidates[task / episodes.size()], episodes[task % episodes.size()], options);
+		};
+		std::vector<std::thread> workers;
+		for (int i = 1; i < std::min<int>(threadCount, static_cast<int>(taskCount)); ++i)
+			workers.emplace_back(work);
+		work();
+		for (auto& worker : workers)
+			worker.join();
+
+		std::vector<Score> scores(candidates.size());
+		for (size_t task = 0; task < taskCount; ++task)
+			scores[task / episodes.size()] += results[task];
+		return scores;
+	}
+
+	std::string describeData(const Options& options, const std::vector<std::string>& sessions)
+	{
+		if (sessions.empty())
+			return "synthetic " + std::to_string(options.participants) + "x" + std::to_string(static_cast<int>(options.duration))
+				+ "s seed " + std::to_string(options.seed);
+		std::string data = "sessions";
+		for (const auto& session : sessions)
+			data += " " + std::filesystem::path(session).filename().string();
+		return data;
+	}
+
+	// The header lines identify the search, everything that changes the cost of a candidate;
+	// resuming with different ones is refused.
+	std::string describeSearch(const Options& options, const std::string& data)
+	{
+		char numbers[240];
+		std::snprintf(numbers, sizeof(numbers), "deltaT\t%g\nstepRate\t%g\nmaxLead\t%g\nstability\t%g\nlikelihood\t%g %g %g\n",
+			options.deltaT, options.stepRate, options.maxLead, options.stability,
+			options.likelihood.tau, options.likelihood.sigma, options.likelihood.scalar);
+		return std::string("architecture\t") + toString(options.architecture) + "\n"
+			+ "precision\t" + toString(options.precision) + "\n"
+			+ numbers
+			+ "data\t" + data + "\n";
+	}
+
+	std::string formatNumber(double value)
+	{
+		char text[32];
+		std::snprintf(text, sizeof(text), "%.17g", value);
+		return text;
+	}
+
+	bool writeCheckpoint(const std::string& file, const std::string& search, const std::vector<Parameter>& parameters,
+		const DnfArchitectureDescription& description, const SearchState& state)
+	{
+		// Written next to the checkpoint and renamed over it, so an interrupted write leaves the previous one.
+		const std::string temporary = file + ".tmp";
+		{
+			std::ofstream out(temporary, std::ofstream::trunc);
+			if (!out.is_open())
+				return false;
+			out << search
+				<< "lambda\t" << state.lambda << "\n"
+				<< "generation\t" << state.generation << "\n"
+				<< "evaluations\t" << state.evaluations << "\n"
+				<< "sigma\t" << formatNumber(state.sigma) << "\n"
+				<< "bestCost\t" << formatNumber(state.bestCost) << "\n"
+				<< "bestScore\t" << state.bestScore.grasps << "\t" << state.bestScore.anticipated << "\t" << state.bestScore.conflicts
+				<< "\t" << formatNumber(state.bestScore.leadSum) << "\t" << formatNumber(state.bestScore.credit) << "\t" << state.bestScore.changes << "\n"
+				<< "random\t" << state.random << "\n";
+			// parameter, mean, variance, sigma path, covariance path, best
+			for (size_t i = 0; i < parameters.size(); ++i)
+				out << "parameter\t" << parameters[i].getName(description) << "\t" << formatNumber(state.mean[i])
+					<< "\t" << formatNumber(state.variance[i]) << "\t" << formatNumber(state.pathSigma[i])
+					<< "\t" << formatNumber(state.pathC[i]) << "\t" << formatNumber(state.best[i]) << "\n";
+			if (!out.good())
+				return false;
+		}
+		std::error_code error;
+		std::filesystem::rename(temporary, file, error);
+		return !error;
+	}
+
+	bool readCheckpoint(const std::string& file, const std::string& search, const std::vector<Parameter>& parameters,
+		const DnfArchitectureDescription& description, SearchState& state, std::string& reason)
+	{
+		std::ifstream in(file);
+		if (!in.is_open())
+		{
+			reason = "cannot read " + file;
+			return false;
+		}
+		std::string header;
+		const auto headerLines = std::count(search.begin(), search.end(), '\n');
+		for (int i = 0; i < headerLines; ++i)
+		{
+			std::string line;
+			std::getline(in, line);
+			header += line + "\n";
+		}
+		if (header != search)
+		{
+			reason = "the checkpoint is of another search:\n" + header;
+			return false;
+		}
+		size_t parameter = 0;
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::istringstream fields(line);
+			std::string key;
+			std::getline(fields, key, '\t');
+			if (key == "lambda") fields >> state.lambda;
+			else if (key == "generation") fields >> state.generation;
+			else if (key == "evaluations") fields >> state.evaluations;
+			else if (key == "sigma") fields >> state.sigma;
+			else if (key == "bestCost") fields >> state.bestCost;
+			else if (key == "bestScore")
+				fields >> state.bestScore.grasps >> state.bestScore.anticipated >> state.bestScore.conflicts
+					>> state.bestScore.leadSum >> state.bestScore.credit >> state.bestScore.changes;
+			else if (key == "random") fields >> state.random;
+			else if (key == "parameter")
+			{
+				std::string name;
+				std::getline(fields, name, '\t');
+				if (parameter >= parameters.size() || name != parameters[parameter].getName(description))
+				{
+					reason = "the checkpoint searches other parameters (" + name + ")";
+					return false;
+				}
+				fields >> state.mean[parameter] >> state.variance[parameter] >> state.pathSigma[parameter]
+					>> state.pathC[parameter] >> state.best[parameter];
+				parameter++;
+			}
+			if (fields.fail())
+			{
+				reason = "cannot parse '" + line + "'";
+				return false;
+			}
+		}
+		if (parameter != parameters.size() || state.lambda < 2 || !(state.sigma > 0))
+		{
+			reason = "the checkpoint is incomplete";
+			return false;
+		}
+		return true;
+	}
+
+	bool writeParameters(const std::string& file, const std::vector<Parameter>& parameters,
+		const DnfArchitectureDescription& best)
+	{
+		nlohmann::json elements = nlohmann::json::object();
+		for (const Parameter& parameter : parameters)
+		{
+			const DnfElementDescription& element = best.elements[parameter.element];
+			if (element.type == DnfElementType::NEURAL_FIELD)
+				continue;
+			elements[element.name][parameter.key] = valueOf(element, parameter.key);
+		}
+		const std::string temporary = file + ".tmp";
+		{
+			std::ofstream out(temporary, std::ofstream::trunc);
+			if (!out.is_open())
+				return false;
+			out << nlohmann::json{ { "elements", elements } }.dump(2) << "\n";
+		}
+		// Renamed into place, so a parameter watcher never reads half a file.
+		std::error_code error;
+		std::filesystem::rename(temporary, file, error);
+		return !error;
+	}
+
+	void printScore(const char* label, const Score& score, double cost)
+	{
+		std::printf("%s cost %.4f: %d grasps, %d anticipated (mean lead %.2f s), %d conflicts, %d target changes\n",
+			label, cost, score.grasps, score.anticipated, score.anticipated ? score.leadSum / score.anticipated : 0.0,
+			score.conflicts, score.changes);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--architecture" && hasValue)
+			options.architecture = parseArchitecture(argv[++i]);
+		else if (argument == "--precision" && hasValue)
+			options.precision = parsePrecision(argv[++i]);
+		else if (argument == "--deltaT" && hasValue)
+			options.deltaT = std::max(1.0, std::atof(argv[++i]));
+		else if (argument == "--step-rate" && hasValue)
+			options.stepRate = std::max(1.0, std::atof(argv[++i]));
+		else if (argument == "--fields")
+			options.fields = true;
+		else if (argument == "--generations" && hasValue)
+			options.generations = std::max(0, std::atoi(argv[++i]));
+		else if (argument == "--population" && hasValue)
+			options.population = std::max(2, std::atoi(argv[++i]));
+		else if (argument == "--sigma" && hasValue)
+			options.sigma = std::max(1e-6, std::atof(argv[++i]));
+		else if (argument == "--seed" && hasValue)
+			options.seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (argument == "--threads" && hasValue)
+			options.threads = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "--max-lead" && hasValue)
+			options.maxLead = std::max(0.01, std::atof(argv[++i]));
+		else if (argument == "--stability" && hasValue)
+			options.stability = std::max(0.0, std::atof(argv[++i]));
+		else if (argument == "--participants" && hasValue)
+			options.participants = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "--duration" && hasValue)
+			options.duration = std::max(1.0, std::atof(argv[++i]));
+		else if (argument == "--parameters" && hasValue)
+			options.parameterFile = argv[++i];
+		else if (argument == "--checkpoint" && hasValue)
+			options.checkpoint = argv[++i];
+		else if (argument == "--output" && hasValue)
+			options.output = argv[++i];
+		else if (argument == "--resume")
+			options.resume = true;
+		else if (argument.rfind("--", 0) == 0)
+		{
+			std::fprintf(stderr, "Unknown option %s\n", argument.c_str());
+			return 2;
+		}
+		else
+			options.paths.push_back(argument);
+	}
+	const int threadCount = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+	// Trajectories
+	std::vector<Episode> episodes;
+	const std::vector<std::string> sessions = findSessions(options.paths);
+	if (!options.paths.empty() && sessions.empty())
+	{
+		std::fprintf(stderr, "No session with hand poses found.\n");
+		return 2;
+	}
+	for (const auto& session : sessions)
+	{
+		Episode episode;
+		if (loadSession(session, episode))
+			episodes.push_back(std::move(episode));
+		else
+			std::fprintf(stderr, "Skipping %s: no hand poses or no human grasps.\n", session.c_str());
+	}
+	if (sessions.empty())
+		for (int i = 0; i < options.participants; ++i)
+			episodes.push_back(generateEpisode(options, i));
+	if (episodes.empty())
+	{
+		std::fprintf(stderr, "No trajectory to evaluate on.\n");
+		return 2;
+	}
+	size_t frameCount = 0, graspCount = 0;
+	for (const auto& episode : episodes)
+	{
+		frameCount += episode.frames.size();
+		graspCount += episode.grasps.size();
+	}
+	const std::string data = describeData(options, sessions);
+
+	// Search space
+	DnfArchitectureDescription base = getDnfArchitectureDescription(options.architecture);
+	base.precision = options.precision;
+	{
+		// Only the likelihood is taken; the kernels of the file are what the search replaces.
+		std::ifstream file(options.parameterFile);
+		if (!file)
+		{
+			std::fprintf(stderr, "Cannot read the parameter file %s\n", options.parameterFile.c_str());
+			return 2;
+		}
+		std::stringstream text;
+		text << file.rdbuf();
+		ArchitectureUpdate builtIn;
+		builtIn.description = base;
+		std::string reason;
+		const auto update = ParameterWatcher::parse(text.str(), base, builtIn, reason, true);
+		if (!update)
+		{
+			std::fprintf(stderr, "Parameter file %s rejected: %s\n", options.parameterFile.c_str(), reason.c_str());
+			return 2;
+		}
+		options.likelihood = update->likelihood;
+	}
+	const std::vector<Parameter> parameters = getParameters(base, options);
+	for (const Parameter& parameter : parameters)
+		if (parameter.lower > parameter.upper)
+		{
+			// Only a field's tau has a bound that depends on the options: it may not fall below deltaT.
+			std::fprintf(stderr, "Nothing to search for %s: its range [%g, %g] is empty at deltaT %g ms.\n",
+				parameter.getName(base).c_str(), parameter.lower, parameter.upper, options.deltaT);
+			return 2;
+		}
+	const int n = static_cast<int>(parameters.size());
+	const std::string search = describeSearch(options, data);
+
+	SearchState state;
+	state.mean.assign(n, 0);
+	state.variance.assign(n, 1);
+	state.pathSigma.assign(n, 0);
+	state.pathC.assign(n, 0);
+	state.best.assign(n, 0);
+	state.sigma = options.sigma;
+	state.lambda = options.population > 0 ? options.population : 4 + static_cast<int>(3 * std::log(n));
+	state.random.seed(options.seed);
+	if (options.resume)
+	{
+		std::string reason;
+		if (!readCheckpoint(options.checkpoint, search, parameters, base, state, reason))
+		{
+			std::fprintf(stderr, "Cannot resume: %s\n", reason.c_str());
+			return 2;
+		}
+		std::printf("Resuming at generation %d (%llu evaluations, best cost %.4f).\n",
+			state.generation, static_cast<unsigned long long>(state.evaluations), state.bestCost);
+	}
+
+	std::printf("%s architecture in %s, deltaT %g ms: %d parameters, population %d, %d threads\n",
+		toString(options.architecture), toString(options.precision), options.deltaT, n, state.lambda, threadCount);
+	std::printf("%s: %zu trajectories, %zu poses, %zu human grasps\n", data.c_str(), episodes.size(), frameCount, graspCount);
+
+	if (!options.resume)
+	{
+		DnfArchitectureDescription initial = base;
+		applyCandidate(parameters, state.best, initial);
+		const Score score = evaluatePopulation({ initial }, episodes, options, threadCount).front();
+		state.bestCost = score.cost(options.stability);
+		state.bestScore = score;
+		state.evaluations = 1;
+		printScore("built-in", score, state.bestCost);
+	}
+
+	// Strategy parameters of sep-CMA-ES; the learning rates of the covariance are raised by (n + 2) / 3.
+	const int lambda = state.lambda;
+	const int mu = lambda / 2;
+	std::vector<double> weights(mu);
+	for (int i = 0; i < mu; ++i)
+		weights[i] = std::log(mu + 0.5) - std::log(i + 1.0);
+	const double weightSum = std::accumulate(weights.begin(), weights.end(), 0.0);
+	for (double& weight : weights)
+		weight /= weightSum;
+	const double mueff = 1.0 / std::inner_product(weights.begin(), weights.end(), weights.begin(), 0.0);
+	const double cSigma = (mueff + 2) / (n + mueff + 5);
+	const double dSigma = 1 + 2 * std::max(0.0, std::sqrt((mueff - 1) / (n + 1)) - 1) + cSigma;
+	const double cC = (4 + mueff / n) / (n + 4 + 2 * mueff / n);
+	double c1 = 2 / ((n + 1.3) * (n + 1.3) + mueff) * (n + 2) / 3;
+	double cMu = std::min(1 - c1, 2 * (mueff - 2 + 1 / mueff) / ((n + 2) * (n + 2) + mueff) * (n + 2) / 3);
+	if (c1 + cMu > 1)
+	{
+		c1 /= c1 + cMu;
+		cMu = 1 - c1;
+	}
+	const double expectedNorm = std::sqrt(n) * (1 - 1.0 / (4 * n) + 1.0 / (21.0 * n * n));
+
+	std::normal_distribution<double> normal;
+	std::vector<std::vector<double>> z(lambda, std::vector<double>(n)), y(lambda, std::vector<double>(n));
+	std::vector<DnfArchitectureDescription> candidates(lambda, base);
+	std::vector<double> costs(lambda);
+	std::vector<int> order(lambda);
+	for (int generationsRun = 0; generationsRun < options.generations; ++generationsRun)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		std::vector<double> outside(lambda);
+		for (int k = 0; k < lambda; ++k)
+		{
+			std::vector<double> x(n);
+			for (int i = 0; i < n; ++i)
+			{
+				z[k][i] = normal(state.random);
+				y[k][i] = std::sqrt(state.variance[i]) * z[k][i];
+				x[i] = state.mean[i] + state.sigma * y[k][i];
+			}
+			candidates[k] = base;
+			outside[k] = applyCandidate(parameters, x, candidates[k]);
+		}
+		const std::vector<Score> scores = evaluatePopulation(candidates, episodes, options, threadCount);
+		for (int k = 0; k < lambda; ++k)
+			costs[k] = scores[k].cost(options.stability) + outside[k];
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&costs](int a, int b) { return costs[a] < costs[b]; });
+
+		const int leader = order.front();
+		if (costs[leader] < state.bestCost)
+		{
+			state.bestCost = costs[leader];
+			state.bestScore = scores[leader];
+			for (int i = 0; i < n; ++i)
+				state.best[i] = state.mean[i] + state.sigma * y[leader][i];
+		}
+
+		// Recombination and adaptation
+		std::vector<double> yWeighted(n, 0), zWeighted(n, 0);
+		for (int r = 0; r < mu; ++r)
+			for (int i = 0; i < n; ++i)
+			{
+				yWeighted[i] += weights[r] * y[order[r]][i];
+				zWeighted[i] += weights[r] * z[order[r]][i];
+			}
+		double pathSigmaNorm = 0;
+		for (int i = 0; i < n; ++i)
+		{
+			state.mean[i] += state.sigma * yWeighted[i];
+			state.pathSigma[i] = (1 - cSigma) * state.pathSigma[i] + std::sqrt(cSigma * (2 - cSigma) * mueff) * zWeighted[i];
+			pathSigmaNorm += state.pathSigma[i] * state.pathSigma[i];
+		}
+		pathSigmaNorm = std::sqrt(pathSigmaNorm);
+		const double correction = std::sqrt(1 - std::pow(1 - cSigma, 2.0 * (state.generation + 1)));
+		// Stalls the covariance path while the step size grows quickly.
+		const bool hSigma = pathSigmaNorm / correction < (1.4 + 2.0 / (n + 1)) * expectedNorm;
+		for (int i = 0; i < n; ++i)
+		{
+			state.pathC[i] = (1 - cC) * state.pathC[i] + (hSigma ? std::sqrt(cC * (2 - cC) * mueff) * yWeighted[i] : 0);
+			double rankMu = 0;
+			for (int r = 0; r < mu; ++r)
+				rankMu += weights[r] * y[order[r]][i] * y[order[r]][i];
+			state.variance[i] = (1 - c1 - cMu) * state.variance[i]
+				+ c1 * (state.pathC[i] * state.pathC[i] + (hSigma ? 0 : cC * (2 - cC) * state.variance[i]))
+				+ cMu * rankMu;
+		}
+		state.sigma *= std::exp(cSigma / dSigma * (pathSigmaNorm / expectedNorm - 1));
+		state.generation++;
+		state.evaluations += lambda;
+
+		DnfArchitectureDescription best = base;
+		applyCandidate(parameters, state.best, best);
+		if (!writeCheckpoint(options.checkpoint, search, parameters, base, state))
+			std::fprintf(stderr, "Could not write the checkpoint %s\n", options.checkpoint.c_str());
+		if (!writeParameters(options.output, parameters, best))
+			std::fprintf(stderr, "Could not write the parameters %s\n", options.output.c_str());
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		std::printf("generation %4d: best %.4f, generation best %.4f, median %.4f, sigma %.4f, %.1f s\n",
+			state.generation, state.bestCost, costs[leader], costs[order[lambda / 2]], state.sigma, seconds);
+		std::fflush(stdout);
+	}
+
+	printScore("best", state.bestScore, state.bestCost);
+	DnfArchitectureDescription best = base;
+	applyCandidate(parameters, state.best, best);
+	for (const Parameter& parameter : parameters)
+	{
+		DnfElementDescription& element = best.elements[parameter.element];
+		std::printf("  %-36s %10.4f (built-in %.4f)%s\n", parameter.getName(base).c_str(), valueOf(element, parameter.key),
+			parameter.initial, element.type == DnfElementType::NEURAL_FIELD ? ", built in" : "");
+	}
+	std::printf("Kernels written to %s, checkpoint %s\n", options.output.c_str(), options.checkpoint.c_str());
+	return 0;
+}
@@ -0,0 +1,270 @@
+// Generates synthetic participants (see include/synthetic_participant.h) on one thread each and
+// reports how fast samples are produced. With --pipeline every sample is also fed through the
+// FieldEngine the way the experiment bridge does, and the robot target is compared with the
+// object the participant is heading for. --session writes the first participant as a session
+// directory that the session analyzer and the precision check read like a recorded one.
+// Usage: vr-hr-joint-task-participant-benchmark [--participants N] [--duration s] [--seed N]
+//        [--rate Hz] [--pipeline] [--architecture hand-motion|action-likelihood]
+//        [--precision double|float|mixed] [--session directory]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "field_engine.h"
+#include "synthetic_participant.h"
+
+namespace
+{
+	struct Options
+	{
+		int participants = 1;
+		double duration = 600;
+		uint64_t seed = 1;
+		double rate = 90;
+		bool pipeline = false;
+		DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION;
+		FieldPrecision precision = FieldPrecision::DOUBLE;
+		std::string session;
+	};
+
+	struct Result
+	{
+		size_t samples = 0;
+		int trials = 0;
+		double seconds = 0;
+		size_t reachSamples = 0;	// samples with an intended object, pipeline only
+		size_t conflicts = 0;		// of those, samples where the robot targets the same object
+	};
+
+	// Mirrors the bridge in Experiment::handleSignalsBetweenDnfAndCoppeliasim.
+	class Pipeline
+	{
+	private:
+		DnfArchitectureType architecture;
+		std::unique_ptr<FieldEngineBase> engine;
+		int handStimulus;
+		int handStimuli[3];
+		int objectStimuli[3];
+		double handStimuliPositions[3];
+		double objectStimuliPositions[3];
+		Position previousHand;
+	public:
+		explicit Pipeline(const Options& options)
+			: architecture(options.architecture), previousHand(SyntheticParticipantParameters().restPosition)
+		{
+			DnfArchitectureDescription description = getDnfArchitectureDescription(architecture);
+			description.precision = options.precision;
+			engine = createFieldEngine(description, 65);
+			handStimulus = engine->indexOf("hand position stimulus");
+			for (int i = 0; i < 3; ++i)
+			{
+				handStimuli[i] = engine->indexOf("hand position stimulus " + std::to_string(i + 1));
+				objectStimuli[i] = engine->indexOf("object stimulus " + std::to_string(i + 1));
+				handStimuliPositions[i] = handStimuli[i] >= 0 ? engine->getDescription().elements[handStimuli[i]].position : 0;
+				objectStimuliPositions[i] = engine->getDescription().elements[objectStimuli[i]].position;
+			}
+		}
+
+		int step(const SyntheticSample& sample, double deltaTime)
+		{
+			const Position& hand = sample.pose.position;
+			if (architecture == DnfArchitectureType::HAND_MOTION)
+			{
+				const double proximity = calculateHandProximityToObjects(calculateHandDistanceToObjects(hand));
+				engine->setStimulus(handStimulus, proximity, normalizeHandPosition(hand.y));
+			}
+			else
+			{
+				const auto likelihoods = calculateLikelihoodOfHumanActions(hand, previousHand, deltaTime);
+				for (int i = 0; i < 3; ++i)
+					engine->setStimulus(handStimuli[i], 5 * likelihoods[i], handStimuliPositions[i]);
+			}
+			for (int i = 0; i < 3; ++i)
+				engine->setStimulus(objectStimuli[i], sample.objectPresent[i] ? 5 : 0, objectStimuliPositions[i]);
+			engine->step();
+			previousHand = hand;
+			return engine->getTargetObject();
+		}
+	};
+
+	// Writes logs.txt and logs_human.txt as EventLogger would have, on a fixed synthetic clock.
+	class SessionWriter
+	{
+	private:
+		std::ofstream events;
+		std::ofstream hand;
+		std::time_t start;
+		SyntheticSample previous;
+		bool hasPrevious = false;
+	public:
+		explicit SessionWriter(const std::string& directory)
+		{
+			std::filesystem::create_directories(directory);
+			events.open(directory + "/logs.txt");
+			hand.open(directory + "/logs_human.txt");
+			std::tm date{};
+			date.tm_year = 2025 - 1900;
+			date.tm_mday = 1;
+			date.tm_hour = 12;
+			start = std::mktime(&date);
+		}
+
+		bool isOpen() const { return events.is_open() && hand.is_open(); }
+
+		void write(const SyntheticSample& sample)
+		{
+			char stamp[32];
+			formatTimestamp(sample.time, stamp);
+			char line[256];
+			const int length = std::snprintf(line, sizeof(line),
+				"%s Hand pose: x = %f, y = %f, z = %f, alpha = %f, beta = %f, gamma = %f\n", stamp,
+				sample.pose.position.x, sample.pose.position.y, sample.pose.position.z,
+				sample.pose.orientation.alpha, sample.pose.orientation.beta, sample.pose.orientation.gamma);
+			hand.write(line, std::min<int>(length, sizeof(line) - 1));
+
+			if (!hasPrevious || sample.trial != previous.trial)
+				events << stamp << " CONTROL Simulation has started.\n";
+			for (int i = 0; i < 3; ++i)
+			{
+				if (sample.humanGrasping[i] && (!hasPrevious || !previous.humanGrasping[i]))
+					events << stamp << " HUMAN Human is grasping object " << i + 1 << ".\n";
+				if (sample.humanPlacing[i] && (!hasPrevious || !previous.humanPlacing[i]))
+					events << stamp << " HUMAN Human is placing object " << i + 1 << ".\n";
+			}
+			previous = sample;
+			hasPrevious = true;
+		}
+	private:
+		void formatTimestamp(double time, char* out) const
+		{
+			const std::time_t seconds = start + static_cast<std::time_t>(time);
+			const int milliseconds = static_cast<int>((time - std::floor(time)) * 1000) % 1000;
+			std::strftime(out, 20, "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+			std::snprintf(out + 19, 5, ".%03d", milliseconds);
+		}
+	};
+
+	Result runParticipant(const Options& options, int index)
+	{
+		SyntheticParticipantParameters parameters;
+		parameters.seed = options.seed + index;
+		parameters.sampleRate = options.rate;
+		SyntheticParticipant participant(parameters);
+		std::unique_ptr<Pipeline> pipeline = options.pipeline ? std::make_unique<Pipeline>(options) : nullptr;
+		std::unique_ptr<SessionWriter> writer;
+		if (index == 0 && !options.session.empty())
+		{
+			writer = std::make_unique<SessionWriter>(options.session);
+			if (!writer->isOpen())
+				std::fprintf(stderr, "Could not write a session to %s\n", options.session.c_str());
+		}
+
+		Result result;
+		result.samples = static_cast<size_t>(options.duration * options.rate);
+		const double deltaTime = 1.0 / options.rate;
+
+		// Samples are generated in blocks, the way a benchmark driver would consume them.
+		constexpr size_t blockSize = 4096;
+		std::vector<SyntheticSample> block(blockSize);
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t done = 0; done < result.samples; done += blockSize)
+		{
+			const size_t count = std::min(blockSize, result.samples - done);
+			participant.generate(block.data(), count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const SyntheticSample& sample = block[i];
+				if (pipeline)
+				{
+					const int target = pipeline->step(sample, deltaTime);
+					if (sample.intendedObject != 0)
+					{
+						result.reachSamples++;
+						result.conflicts += target == sample.intendedObject;
+					}
+				}
+				if (writer)
+					writer->write(sample);
+				result.trials = sample.trial;
+			}
+		}
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--participants" && hasValue)
+			options.participants = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "--duration" && hasValue)
+			options.duration = std::max(0.0, std::atof(argv[++i]));
+		else if (argument == "--seed" && hasValue)
+			options.seed = std::strtoull(argv[++i], nullptr, 10);
+		else if (argument == "--rate" && hasValue)
+			options.rate = std::max(1.0, std::atof(argv[++i]));
+		else if (argument == "--pipeline")
+			options.pipeline = true;
+		else if (argument == "--architecture" && hasValue)
+			options.architecture = std::string(argv[++i]) == "action-likelihood" ? DnfArchitectureType::ACTION_LIKELIHOOD : DnfArchitectureType::HAND_MOTION;
+		else if (argument == "--precision" && hasValue)
+		{
+			const std::string precision = argv[++i];
+			options.precision = precision == "float" ? FieldPrecision::FLOAT : precision == "mixed" ? FieldPrecision::MIXED : FieldPrecision::DOUBLE;
+		}
+		else if (argument == "--session" && hasValue)
+			options.session = argv[++i];
+		else
+		{
+			std::fprintf(stderr, "Unknown option %s\n", argument.c_str());
+			return 2;
+		}
+	}
+
+	std::vector<Result> results(options.participants);
+	const auto begin = std::chrono::steady_clock::now();
+	{
+		std::vector<std::thread> workers;
+		for (int i = 0; i < options.participants; ++i)
+			workers.emplace_back([&, i] { results[i] = runParticipant(options, i); });
+		for (auto& worker : workers)
+			worker.join();
+	}
+	const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	Result total;
+	for (const auto& result : results)
+	{
+		total.samples += result.samples;
+		total.trials += result.trials;
+		total.reachSamples += result.reachSamples;
+		total.conflicts += result.conflicts;
+	}
+	std::printf("%d participant%s, %.0f s each at %.0f Hz, seed %llu: %zu samples, %d trials\n",
+		options.participants, options.participants == 1 ? "" : "s", options.duration, options.rate, static_cast<unsigned long long>(options.seed),
+		total.samples, total.trials);
+	std::printf("%s: %.3f s wall, %.2f M samples/s, %.0fx real time per participant\n",
+		options.pipeline ? "generation and pipeline" : "generation",
+		wallSeconds, static_cast<double>(total.samples) / wallSeconds / 1e6,
+		options.duration / wallSeconds);
+	if (options.pipeline)
+		std::printf("%s, %s precision: robot targeted the participant's object in %.2f %% of %zu reach samples\n",
+			options.architecture == DnfArchitectureType::HAND_MOTION ? "hand-motion" : "action-likelihood",
+			toString(options.precision),
+			total.reachSamples ? 100.0 * static_cast<double>(total.conflicts) / total.reachSamples : 0.0, total.reachSamples);
+	return 0;
+}
@@ -0,0 +1,211 @@
+// Replays recorded hand trajectories through the FieldEngine in double, float and mixed
+// precision and compares the reduced-precision decisions and action execution centroids
+// against double precision. Decisions come from a BumpDetector with the production
+// parameters run after every step, as on the simulation thread, so the check covers the
+// decision that reaches the robot.
+// Usage: vr-hr-joint-task-precision-check [--architecture hand-motion|action-likelihood]
+//        [--resolution N] [--deltaT ms] [--step-rate Hz] [--tolerance fraction] [session-or-data-directory ...]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "field_engine.h"
+#include "session_log.h"
+
+namespace
+{
+	struct Comparison
+	{
+		FieldPrecision precision;
+		std::unique_ptr<FieldEngineBase> engine;
+		BumpDetector detector;
+		int actionExecutionField = -1;
+		uint64_t step = 0;
+		size_t events = 0;
+		double seconds = 0;
+		size_t decisions = 0;
+		size_t agreements = 0;
+		size_t bumpMismatches = 0;
+		size_t centroidSamples = 0;
+		double centroidErrorSum = 0;
+		double centroidErrorMax = 0;
+	};
+
+	std::vector<std::string> findSessions(const std::vector<std::string>& paths)
+	{
+		std::vector<std::string> sessions;
+		for (const auto& path : paths)
+		{
+			if (SessionIndex::isSession(path))
+			{
+				sessions.push_back(path);
+				continue;
+			}
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(path, error))
+				if (entry.is_directory() && SessionIndex::isSession(entry.path().string()))
+					sessions.push_back(entry.path().string());
+		}
+		std::sort(sessions.begin(), sessions.end());
+		return sessions;
+	}
+
+	void applyHand(FieldEngineBase& engine, DnfArchitectureType architecture,
+		const HandSample& sample, const HandSample& previous)
+	{
+		if (architecture == DnfArchitectureType::HAND_MOTION)
+		{
+			const double proximity = calculateHandProximityToObjects(calculateHandDistanceToObjects(sample.pose.position));
+			engine.setStimulus("hand position stimulus", proximity, normalizeHandPosition(sample.pose.position.y));
+			return;
+		}
+		const double deltaTime = sample.time - previous.time;
+		if (deltaTime < std::numeric_limits<double>::epsilon())
+			return;
+		const auto likelihoods = calculateLikelihoodOfHumanActions(sample.pose.position, previous.pose.position, deltaTime);
+		for (int object = 0; object < 3; ++object)
+		{
+			const std::string name = "hand position stimulus " + std::to_string(object + 1);
+			engine.setStimulus(name, 5 * likelihoods[object], engine.getDescription().find(name)->position);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	DnfArchitectureType architecture = DnfArchitectureType::HAND_MOTION;
+	int resolution = 1;
+	double deltaT = 65;
+	double stepRate = 60;
+	double tolerance = 0;
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (argument == "--architecture" && hasValue)
+			architecture = std::string(argv[++i]) == "action-likelihood" ? DnfArchitectureType::ACTION_LIKELIHOOD : DnfArchitectureType::HAND_MOTION;
+		else if (argument == "--resolution" && hasValue)
+			resolution = std::max(1, std::atoi(argv[++i]));
+		else if (argument == "--deltaT" && hasValue)
+			deltaT = std::atof(argv[++i]);
+		else if (argument == "--step-rate" && hasValue)
+			stepRate = std::atof(argv[++i]);
+		else if (argument == "--tolerance" && hasValue)
+			tolerance = std::atof(argv[++i]);
+		else
+			paths.push_back(argument);
+	}
+	if (paths.empty())
+		paths.emplace_back(OUTPUT_DIRECTORY);
+
+	const std::vector<std::string> sessions = findSessions(paths);
+	if (sessions.empty())
+	{
+		std::cerr << "No session with hand poses found." << std::endl;
+		return 2;
+	}
+
+	DnfArchitectureDescription description = getDnfArchitectureDescription(architecture);
+	description.dx /= resolution;
+
+	std::vector<Comparison> comparisons;
+	for (const FieldPrecision precision : { FieldPrecision::DOUBLE, FieldPrecision::FLOAT, FieldPrecision::MIXED })
+	{
+		Comparison comparison;
+		comparison.precision = precision;
+		description.precision = precision;
+		comparison.engine = createFieldEngine(description, deltaT);
+		comparison.detector = BumpDetector(BumpDetectorParameters(), description.circular, description.xMax);
+		comparison.actionExecutionField = comparison.engine->indexOf("ael");
+		comparisons.push_back(std::move(comparison));
+	}
+
+	size_t samples = 0, steps = 0;
+	for (const auto& session : sessions)
+	{
+		SessionIndex index;
+		std::vector<HandSample> trajectory;
+		if (index.load(session))
+			index.read("logs_human", {}, SESSION_END, [&](std::string_view text) {
+				SessionLogParser::parseHandTrajectory(text, trajectory);
+			});
+		if (trajectory.empty())
+			continue;
+
+		for (auto& comparison : comparisons)
+		{
+			comparison.engine->init();
+			comparison.detector.reset();
+		}
+		for (size_t k = 0; k < trajectory.size(); ++k)
+		{
+			const HandSample& previous = trajectory[k == 0 ? 0 : k - 1];
+			// Replay at the rate the simulation thread stepped between two logged poses.
+			const int stepCount = std::clamp(static_cast<int>(std::lround((trajectory[k].time - previous.time) * stepRate)), 1, 600);
+			for (auto& comparison : comparisons)
+			{
+				applyHand(*comparison.engine, architecture, trajectory[k], previous);
+				const auto start = std::chrono::steady_clock::now();
+				for (int s = 0; s < stepCount; ++s)
+				{
+					comparison.engine->step();
+					DecisionEvent event;
+					if (comparison.engine->updateDetector(comparison.actionExecutionField, comparison.detector, comparison.step++, event))
+						comparison.events++;
+				}
+				comparison.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+
+			const FieldEngineBase& reference = *comparisons.front().engine;
+			const int referenceTarget = comparisons.front().detector.getDecision();
+			const double referenceCentroid = reference.getCentroid("ael");
+			for (auto& comparison : comparisons)
+			{
+				comparison.decisions++;
+				if (comparison.detector.getDecision() == referenceTarget)
+					comparison.agreements++;
+				const double centroid = comparison.engine->getCentroid("ael");
+				if ((centroid < 0) != (referenceCentroid < 0))
+					comparison.bumpMismatches++;
+				else if (centroid >= 0)
+				{
+					const double error = std::abs(centroid - referenceCentroid);
+					comparison.centroidSamples++;
+					comparison.centroidErrorSum += error;
+					comparison.centroidErrorMax = std::max(comparison.centroidErrorMax, error);
+				}
+			}
+			samples++;
+			steps += stepCount;
+		}
+	}
+
+	std::printf("%zu trajectories, %zu samples, %zu steps, %d samples per field\n",
+		sessions.size(), samples, steps, description.getSize());
+	std::printf("%-8s %10s %8s %10s %10s %8s %10s %12s %12s\n",
+		"engine", "us/step", "speedup", "memory", "agreement", "events", "bumpDiff", "meanCentroid", "maxCentroid");
+	bool passed = true;
+	const double referenceSeconds = comparisons.front().seconds;
+	for (const auto& comparison : comparisons)
+	{
+		const double agreement = comparison.decisions ? static_cast<double>(comparison.agreements) / comparison.decisions : 1.0;
+		const double meanError = comparison.centroidSamples ? comparison.centroidErrorSum / comparison.centroidSamples : 0.0;
+		std::printf("%-8s %10.2f %7.2fx %9zuB %9.3f%% %8zu %10zu %12.5f %12.5f\n",
+			toString(comparison.precision),
+			steps ? comparison.seconds * 1e6 / steps : 0.0,
+			comparison.seconds > 0 ? referenceSeconds / comparison.seconds : 0.0,
+			comparison.engine->getMemoryFootprint(),
+			agreement * 100, comparison.events, comparison.bumpMismatches, meanError, comparison.centroidErrorMax);
+		if (1.0 - agreement > tolerance)
+			passed = false;
+	}
+	std::printf("shared profiles: %zu entries, %zuB\n", ProfileCache::getEntryCount(), ProfileCache::getMemoryFootprint());
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+// Aggregates trial metrics over every session directory found under the given data directories.
+// Usage: vr-hr-joint-task-session-analyzer [--trial N] [data-directory ...] > trials.csv
+// With --trial, only trial N of each session is read, through the session index.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "session_log.h"
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> roots;
+	int trial = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--trial" && i + 1 < argc)
+			trial = std::max(1, std::atoi(argv[++i]));
+		else
+			roots.push_back(argument);
+	}
+	if (roots.empty())
+		roots.emplace_back(OUTPUT_DIRECTORY);
+
+	std::vector<std::string> sessions;
+	for (const auto& root : roots)
+	{
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(root, error))
+			if (entry.is_directory() && entry.path().filename().string().starts_with("session"))
+				sessions.push_back(entry.path().string());
+		if (error)
+			std::cerr << "Cannot read " << root << ": " << error.message() << std::endl;
+	}
+
+	// Sessions are independent, so workers just take the next unclaimed one.
+	std::vector<std::vector<TrialMetrics>> results(sessions.size());
+	std::atomic<size_t> next{ 0 };
+	const size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(sessions.size(), 1));
+	std::vector<std::thread> workers;
+	for (size_t w = 0; w < workerCount; ++w)
+		workers.emplace_back([&] {
+			for (size_t i = next++; i < sessions.size(); i = next++)
+				results[i] = SessionLogParser::analyzeSession(sessions[i], trial);
+		});
+	for (auto& worker : workers)
+		worker.join();
+
+	std::vector<TrialMetrics> trials;
+	for (auto& result : results)
+		trials.insert(trials.end(), result.begin(), result.end());
+	std::sort(trials.begin(), trials.end(), [](const TrialMetrics& a, const TrialMetrics& b) {
+		return a.session != b.session ? a.session < b.session : a.trial < b.trial;
+	});
+
+	std::cout << SessionLogParser::formatHeader() << '\n';
+	for (const auto& trial : trials)
+		std::cout << SessionLogParser::format(trial) << '\n';
+	std::cerr << sessions.size() << " sessions, " << trials.size() << " trials." << std::endl;
+	return 0;
+}